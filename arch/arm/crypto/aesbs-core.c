@@ -0,0 +1,697 @@
+/*
+ * Bit sliced AES using NEON instructions
+ *
+ * Eight blocks are processed in parallel. After loading, the blocks are
+ * transposed into eight 128-bit planes so that bit i of byte j of block k
+ * ends up in bit k of byte j of plane i. SubBytes is then evaluated as a
+ * boolean circuit over the planes (a tower field GF((2^4)^2) inversion
+ * followed by the affine map), which takes the same time for every input.
+ *
+ * This unit is built with -mfpu=neon and must only be entered from between
+ * kernel_neon_begin() and kernel_neon_end().
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/neon-intrinsics.h>
+
+#include "aesbs.h"
+
+typedef uint8x16_t bs_t;
+
+static const uint8_t shift_rows_tbl[16] = {
+	0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11,
+};
+
+static const uint8_t inv_shift_rows_tbl[16] = {
+	0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3,
+};
+
+static inline void swapmove(bs_t *a, bs_t *b, int n, uint8_t mask)
+{
+	bs_t t;
+
+	switch (n) {
+	case 1:
+		t = vshrq_n_u8(*a, 1);
+		break;
+	case 2:
+		t = vshrq_n_u8(*a, 2);
+		break;
+	default:
+		t = vshrq_n_u8(*a, 4);
+		break;
+	}
+	t = vandq_u8(veorq_u8(t, *b), vdupq_n_u8(mask));
+	*b = veorq_u8(*b, t);
+	switch (n) {
+	case 1:
+		t = vshlq_n_u8(t, 1);
+		break;
+	case 2:
+		t = vshlq_n_u8(t, 2);
+		break;
+	default:
+		t = vshlq_n_u8(t, 4);
+		break;
+	}
+	*a = veorq_u8(*a, t);
+}
+
+static inline void bitslice(bs_t x[8])
+{
+	swapmove(&x[0], &x[1], 1, 0x55);
+	swapmove(&x[2], &x[3], 1, 0x55);
+	swapmove(&x[4], &x[5], 1, 0x55);
+	swapmove(&x[6], &x[7], 1, 0x55);
+
+	swapmove(&x[0], &x[2], 2, 0x33);
+	swapmove(&x[1], &x[3], 2, 0x33);
+	swapmove(&x[4], &x[6], 2, 0x33);
+	swapmove(&x[5], &x[7], 2, 0x33);
+
+	swapmove(&x[0], &x[4], 4, 0x0f);
+	swapmove(&x[1], &x[5], 4, 0x0f);
+	swapmove(&x[2], &x[6], 4, 0x0f);
+	swapmove(&x[3], &x[7], 4, 0x0f);
+}
+
+static inline bs_t permute(bs_t a, uint8x8_t lo, uint8x8_t hi)
+{
+	uint8x8x2_t t;
+
+	t.val[0] = vget_low_u8(a);
+	t.val[1] = vget_high_u8(a);
+	return vcombine_u8(vtbl2_u8(t, lo), vtbl2_u8(t, hi));
+}
+
+static inline void shift_rows(bs_t x[8], const uint8_t *tbl)
+{
+	uint8x8_t lo = vld1_u8(tbl);
+	uint8x8_t hi = vld1_u8(tbl + 8);
+	int i;
+
+	for (i = 0; i < 8; i++)
+		x[i] = permute(x[i], lo, hi);
+}
+
+static inline void add_round_key(bs_t x[8], const uint8_t *rk)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		x[i] = veorq_u8(x[i], vld1q_u8(rk + 16 * i));
+}
+
+static inline void xtime(bs_t out[8], const bs_t a[8])
+{
+	out[0] = a[7];
+	out[1] = veorq_u8(a[0], a[7]);
+	out[2] = a[1];
+	out[3] = veorq_u8(a[2], a[7]);
+	out[4] = veorq_u8(a[3], a[7]);
+	out[5] = a[4];
+	out[6] = a[5];
+	out[7] = a[6];
+}
+
+static inline bs_t rot1(bs_t a)
+{
+	uint32x4_t w = vreinterpretq_u32_u8(a);
+
+	return vreinterpretq_u8_u32(vsliq_n_u32(vshrq_n_u32(w, 8), w, 24));
+}
+
+static inline bs_t rot2(bs_t a)
+{
+	return vreinterpretq_u8_u16(vrev32q_u16(vreinterpretq_u16_u8(a)));
+}
+
+static inline void mix_columns(bs_t x[8])
+{
+	bs_t r[8], t[8], xt[8];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		r[i] = rot1(x[i]);
+		t[i] = veorq_u8(x[i], r[i]);
+	}
+	xtime(xt, t);
+	for (i = 0; i < 8; i++)
+		x[i] = veorq_u8(veorq_u8(xt[i], r[i]), rot2(t[i]));
+}
+
+static inline void inv_mix_columns(bs_t x[8])
+{
+	bs_t t[8], u[8];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		t[i] = veorq_u8(x[i], rot2(x[i]));
+	xtime(u, t);
+	xtime(t, u);
+	for (i = 0; i < 8; i++)
+		x[i] = veorq_u8(x[i], t[i]);
+	mix_columns(x);
+}
+
+static void sub_bytes(bs_t x[8])
+{
+	bs_t t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14,
+	     t15, t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27,
+	     t28, t29, t30, t31, t32, t33, t34, t35, t36, t37, t38, t39, t40,
+	     t41, t42, t43, t44, t45, t46, t47, t48, t49, t50, t51, t52, t53,
+	     t54, t55, t56, t57, t58, t59, t60, t61, t62, t63, t64, t65, t66,
+	     t67, t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78, t79,
+	     t80, t81, t82, t83, t84, t85, t86, t87, t88, t89, t90, t91, t92,
+	     t93, t94, t95, t96, t97, t98, t99, t100, t101, t102, t103, t104,
+	     t105, t106, t107, t108, t109, t110, t111, t112, t113, t114,
+	     t115, t116, t117, t118, t119, t120, t121, t122, t123, t124,
+	     t125, t126, t127, t128, t129, t130, t131, t132, t133, t134,
+	     t135, t136, t137, t138, t139, t140, t141, t142, t143, t144,
+	     t145, t146, t147, t148, t149, t150, t151, t152, t153, t154,
+	     t155, t156, t157, t158, t159, t160, t161, t162, t163, t164,
+	     t165, t166, t167, t168, t169, t170, t171, t172, t173, t174,
+	     t175, t176, t177, t178, t179, t180, t181, t182, t183, t184,
+	     t185, t186, t187, t188, t189, t190, t191, t192, t193, t194,
+	     t195, t196, t197, t198, t199, t200, t201, t202, t203, t204,
+	     t205, t206, t207, t208, t209;
+	t1 = veorq_u8(x[5], x[7]);
+	t2 = veorq_u8(x[4], x[6]);
+	t3 = veorq_u8(x[2], x[3]);
+	t4 = veorq_u8(t1, t3);
+	t5 = veorq_u8(t1, x[0]);
+	t6 = veorq_u8(t2, t4);
+	t7 = veorq_u8(x[3], x[4]);
+	t8 = veorq_u8(t2, x[5]);
+	t9 = veorq_u8(t2, x[1]);
+	t10 = veorq_u8(t9, x[7]);
+	t11 = veorq_u8(t10, t4);
+	t12 = veorq_u8(t11, t1);
+	t13 = veorq_u8(t8, t4);
+	t14 = veorq_u8(t13, t1);
+	t15 = veorq_u8(t5, t6);
+	t16 = veorq_u8(x[2], t7);
+	t17 = vandq_u8(t8, t5);
+	t18 = vandq_u8(t8, x[2]);
+	t19 = vandq_u8(t8, t6);
+	t20 = vandq_u8(t8, t7);
+	t21 = vandq_u8(t10, t5);
+	t22 = vandq_u8(t10, x[2]);
+	t23 = vandq_u8(t10, t6);
+	t24 = vandq_u8(t10, t7);
+	t25 = vandq_u8(t4, t5);
+	t26 = vandq_u8(t4, x[2]);
+	t27 = vandq_u8(t4, t6);
+	t28 = vandq_u8(t4, t7);
+	t29 = vandq_u8(t1, t5);
+	t30 = vandq_u8(t1, x[2]);
+	t31 = vandq_u8(t1, t6);
+	t32 = vandq_u8(t1, t7);
+	t33 = veorq_u8(t18, t21);
+	t34 = veorq_u8(t19, t22);
+	t35 = veorq_u8(t34, t25);
+	t36 = veorq_u8(t20, t23);
+	t37 = veorq_u8(t36, t26);
+	t38 = veorq_u8(t37, t29);
+	t39 = veorq_u8(t24, t27);
+	t40 = veorq_u8(t39, t30);
+	t41 = veorq_u8(t28, t31);
+	t42 = veorq_u8(t17, t40);
+	t43 = veorq_u8(t33, t40);
+	t44 = veorq_u8(t43, t41);
+	t45 = veorq_u8(t35, t41);
+	t46 = veorq_u8(t45, t32);
+	t47 = veorq_u8(t38, t32);
+	t48 = veorq_u8(t4, t15);
+	t49 = veorq_u8(t48, t42);
+	t50 = veorq_u8(t12, t6);
+	t51 = veorq_u8(t50, t44);
+	t52 = veorq_u8(t10, t16);
+	t53 = veorq_u8(t52, t46);
+	t54 = veorq_u8(t14, t7);
+	t55 = veorq_u8(t54, t47);
+	t56 = veorq_u8(t49, t53);
+	t57 = veorq_u8(t51, t55);
+	t58 = vandq_u8(t56, t49);
+	t59 = vandq_u8(t56, t51);
+	t60 = vandq_u8(t56, t53);
+	t61 = vandq_u8(t56, t55);
+	t62 = vandq_u8(t53, t49);
+	t63 = vandq_u8(t53, t51);
+	t64 = vandq_u8(t53, t53);
+	t65 = vandq_u8(t53, t55);
+	t66 = vandq_u8(t57, t49);
+	t67 = vandq_u8(t57, t51);
+	t68 = vandq_u8(t57, t53);
+	t69 = vandq_u8(t57, t55);
+	t70 = vandq_u8(t55, t49);
+	t71 = vandq_u8(t55, t51);
+	t72 = vandq_u8(t55, t53);
+	t73 = vandq_u8(t55, t55);
+	t74 = veorq_u8(t59, t62);
+	t75 = veorq_u8(t60, t63);
+	t76 = veorq_u8(t75, t66);
+	t77 = veorq_u8(t61, t64);
+	t78 = veorq_u8(t77, t67);
+	t79 = veorq_u8(t78, t70);
+	t80 = veorq_u8(t65, t68);
+	t81 = veorq_u8(t80, t71);
+	t82 = veorq_u8(t69, t72);
+	t83 = veorq_u8(t58, t81);
+	t84 = veorq_u8(t74, t81);
+	t85 = veorq_u8(t84, t82);
+	t86 = veorq_u8(t76, t82);
+	t87 = veorq_u8(t86, t73);
+	t88 = veorq_u8(t79, t73);
+	t89 = veorq_u8(t83, t85);
+	t90 = veorq_u8(t89, t87);
+	t91 = veorq_u8(t90, t88);
+	t92 = veorq_u8(t85, t88);
+	t93 = veorq_u8(t87, t88);
+	t94 = vandq_u8(t91, t56);
+	t95 = vandq_u8(t91, t53);
+	t96 = vandq_u8(t91, t57);
+	t97 = vandq_u8(t91, t55);
+	t98 = vandq_u8(t92, t56);
+	t99 = vandq_u8(t92, t53);
+	t100 = vandq_u8(t92, t57);
+	t101 = vandq_u8(t92, t55);
+	t102 = vandq_u8(t93, t56);
+	t103 = vandq_u8(t93, t53);
+	t104 = vandq_u8(t93, t57);
+	t105 = vandq_u8(t93, t55);
+	t106 = vandq_u8(t88, t56);
+	t107 = vandq_u8(t88, t53);
+	t108 = vandq_u8(t88, t57);
+	t109 = vandq_u8(t88, t55);
+	t110 = veorq_u8(t95, t98);
+	t111 = veorq_u8(t96, t99);
+	t112 = veorq_u8(t111, t102);
+	t113 = veorq_u8(t97, t100);
+	t114 = veorq_u8(t113, t103);
+	t115 = veorq_u8(t114, t106);
+	t116 = veorq_u8(t101, t104);
+	t117 = veorq_u8(t116, t107);
+	t118 = veorq_u8(t105, t108);
+	t119 = veorq_u8(t94, t117);
+	t120 = veorq_u8(t110, t117);
+	t121 = veorq_u8(t120, t118);
+	t122 = veorq_u8(t112, t118);
+	t123 = veorq_u8(t122, t109);
+	t124 = veorq_u8(t115, t109);
+	t125 = vandq_u8(t8, t119);
+	t126 = vandq_u8(t8, t121);
+	t127 = vandq_u8(t8, t123);
+	t128 = vandq_u8(t8, t124);
+	t129 = vandq_u8(t10, t119);
+	t130 = vandq_u8(t10, t121);
+	t131 = vandq_u8(t10, t123);
+	t132 = vandq_u8(t10, t124);
+	t133 = vandq_u8(t4, t119);
+	t134 = vandq_u8(t4, t121);
+	t135 = vandq_u8(t4, t123);
+	t136 = vandq_u8(t4, t124);
+	t137 = vandq_u8(t1, t119);
+	t138 = vandq_u8(t1, t121);
+	t139 = vandq_u8(t1, t123);
+	t140 = vandq_u8(t1, t124);
+	t141 = veorq_u8(t126, t129);
+	t142 = veorq_u8(t127, t130);
+	t143 = veorq_u8(t142, t133);
+	t144 = veorq_u8(t128, t131);
+	t145 = veorq_u8(t144, t134);
+	t146 = veorq_u8(t145, t137);
+	t147 = veorq_u8(t132, t135);
+	t148 = veorq_u8(t147, t138);
+	t149 = veorq_u8(t136, t139);
+	t150 = veorq_u8(t125, t148);
+	t151 = veorq_u8(t141, t148);
+	t152 = veorq_u8(t151, t149);
+	t153 = veorq_u8(t143, t149);
+	t154 = veorq_u8(t153, t140);
+	t155 = veorq_u8(t146, t140);
+	t156 = veorq_u8(t8, t5);
+	t157 = veorq_u8(t10, x[2]);
+	t158 = veorq_u8(t4, t6);
+	t159 = veorq_u8(t1, t7);
+	t160 = vandq_u8(t156, t119);
+	t161 = vandq_u8(t156, t121);
+	t162 = vandq_u8(t156, t123);
+	t163 = vandq_u8(t156, t124);
+	t164 = vandq_u8(t157, t119);
+	t165 = vandq_u8(t157, t121);
+	t166 = vandq_u8(t157, t123);
+	t167 = vandq_u8(t157, t124);
+	t168 = vandq_u8(t158, t119);
+	t169 = vandq_u8(t158, t121);
+	t170 = vandq_u8(t158, t123);
+	t171 = vandq_u8(t158, t124);
+	t172 = vandq_u8(t159, t119);
+	t173 = vandq_u8(t159, t121);
+	t174 = vandq_u8(t159, t123);
+	t175 = vandq_u8(t159, t124);
+	t176 = veorq_u8(t161, t164);
+	t177 = veorq_u8(t162, t165);
+	t178 = veorq_u8(t177, t168);
+	t179 = veorq_u8(t163, t166);
+	t180 = veorq_u8(t179, t169);
+	t181 = veorq_u8(t180, t172);
+	t182 = veorq_u8(t167, t170);
+	t183 = veorq_u8(t182, t173);
+	t184 = veorq_u8(t171, t174);
+	t185 = veorq_u8(t160, t183);
+	t186 = veorq_u8(t176, t183);
+	t187 = veorq_u8(t186, t184);
+	t188 = veorq_u8(t178, t184);
+	t189 = veorq_u8(t188, t175);
+	t190 = veorq_u8(t181, t175);
+	t191 = veorq_u8(t152, t190);
+	t192 = veorq_u8(t187, t191);
+	t193 = veorq_u8(t185, t189);
+	t194 = veorq_u8(t154, t155);
+	t195 = veorq_u8(t150, t192);
+	t196 = veorq_u8(t154, t193);
+	t197 = vmvnq_u8(t196);
+	t198 = veorq_u8(t193, t195);
+	t199 = vmvnq_u8(t198);
+	t200 = veorq_u8(t154, t185);
+	t201 = veorq_u8(t200, t191);
+	t202 = veorq_u8(t152, t193);
+	t203 = veorq_u8(t185, t195);
+	t204 = veorq_u8(t189, t192);
+	t205 = veorq_u8(t204, t194);
+	t206 = vmvnq_u8(t205);
+	t207 = veorq_u8(t150, t194);
+	t208 = vmvnq_u8(t207);
+	t209 = veorq_u8(t187, t189);
+	x[0] = t197;
+	x[1] = t199;
+	x[2] = t201;
+	x[3] = t202;
+	x[4] = t203;
+	x[5] = t206;
+	x[6] = t208;
+	x[7] = t209;
+}
+
+static void inv_sub_bytes(bs_t x[8])
+{
+	bs_t t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14,
+	     t15, t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27,
+	     t28, t29, t30, t31, t32, t33, t34, t35, t36, t37, t38, t39, t40,
+	     t41, t42, t43, t44, t45, t46, t47, t48, t49, t50, t51, t52, t53,
+	     t54, t55, t56, t57, t58, t59, t60, t61, t62, t63, t64, t65, t66,
+	     t67, t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78, t79,
+	     t80, t81, t82, t83, t84, t85, t86, t87, t88, t89, t90, t91, t92,
+	     t93, t94, t95, t96, t97, t98, t99, t100, t101, t102, t103, t104,
+	     t105, t106, t107, t108, t109, t110, t111, t112, t113, t114,
+	     t115, t116, t117, t118, t119, t120, t121, t122, t123, t124,
+	     t125, t126, t127, t128, t129, t130, t131, t132, t133, t134,
+	     t135, t136, t137, t138, t139, t140, t141, t142, t143, t144,
+	     t145, t146, t147, t148, t149, t150, t151, t152, t153, t154,
+	     t155, t156, t157, t158, t159, t160, t161, t162, t163, t164,
+	     t165, t166, t167, t168, t169, t170, t171, t172, t173, t174,
+	     t175, t176, t177, t178, t179, t180, t181, t182, t183, t184,
+	     t185, t186, t187, t188, t189, t190, t191, t192, t193, t194,
+	     t195, t196, t197, t198, t199, t200, t201, t202, t203, t204,
+	     t205, t206, t207, t208, t209, t210;
+	t1 = veorq_u8(x[5], x[6]);
+	t2 = veorq_u8(x[1], x[7]);
+	t3 = veorq_u8(t1, x[4]);
+	t4 = veorq_u8(x[0], x[2]);
+	t5 = veorq_u8(t1, x[1]);
+	t6 = vmvnq_u8(t5);
+	t7 = veorq_u8(t2, x[4]);
+	t8 = vmvnq_u8(t7);
+	t9 = veorq_u8(x[1], x[4]);
+	t10 = vmvnq_u8(t9);
+	t11 = veorq_u8(t4, t5);
+	t12 = veorq_u8(t11, x[3]);
+	t13 = veorq_u8(t2, t3);
+	t14 = veorq_u8(t13, t4);
+	t15 = veorq_u8(t3, x[3]);
+	t16 = veorq_u8(t3, x[0]);
+	t17 = vmvnq_u8(t16);
+	t18 = veorq_u8(t2, x[2]);
+	t19 = veorq_u8(t18, x[6]);
+	t20 = veorq_u8(t15, t17);
+	t21 = veorq_u8(t20, t19);
+	t22 = veorq_u8(t14, t17);
+	t23 = veorq_u8(t22, t19);
+	t24 = veorq_u8(t6, t10);
+	t25 = veorq_u8(t8, t12);
+	t26 = vandq_u8(t14, t6);
+	t27 = vandq_u8(t14, t8);
+	t28 = vandq_u8(t14, t10);
+	t29 = vandq_u8(t14, t12);
+	t30 = vandq_u8(t15, t6);
+	t31 = vandq_u8(t15, t8);
+	t32 = vandq_u8(t15, t10);
+	t33 = vandq_u8(t15, t12);
+	t34 = vandq_u8(t17, t6);
+	t35 = vandq_u8(t17, t8);
+	t36 = vandq_u8(t17, t10);
+	t37 = vandq_u8(t17, t12);
+	t38 = vandq_u8(t19, t6);
+	t39 = vandq_u8(t19, t8);
+	t40 = vandq_u8(t19, t10);
+	t41 = vandq_u8(t19, t12);
+	t42 = veorq_u8(t27, t30);
+	t43 = veorq_u8(t28, t31);
+	t44 = veorq_u8(t43, t34);
+	t45 = veorq_u8(t29, t32);
+	t46 = veorq_u8(t45, t35);
+	t47 = veorq_u8(t46, t38);
+	t48 = veorq_u8(t33, t36);
+	t49 = veorq_u8(t48, t39);
+	t50 = veorq_u8(t37, t40);
+	t51 = veorq_u8(t26, t49);
+	t52 = veorq_u8(t42, t49);
+	t53 = veorq_u8(t52, t50);
+	t54 = veorq_u8(t44, t50);
+	t55 = veorq_u8(t54, t41);
+	t56 = veorq_u8(t47, t41);
+	t57 = veorq_u8(t17, t24);
+	t58 = veorq_u8(t57, t51);
+	t59 = veorq_u8(t21, t10);
+	t60 = veorq_u8(t59, t53);
+	t61 = veorq_u8(t15, t25);
+	t62 = veorq_u8(t61, t55);
+	t63 = veorq_u8(t23, t12);
+	t64 = veorq_u8(t63, t56);
+	t65 = veorq_u8(t58, t62);
+	t66 = veorq_u8(t60, t64);
+	t67 = vandq_u8(t65, t58);
+	t68 = vandq_u8(t65, t60);
+	t69 = vandq_u8(t65, t62);
+	t70 = vandq_u8(t65, t64);
+	t71 = vandq_u8(t62, t58);
+	t72 = vandq_u8(t62, t60);
+	t73 = vandq_u8(t62, t62);
+	t74 = vandq_u8(t62, t64);
+	t75 = vandq_u8(t66, t58);
+	t76 = vandq_u8(t66, t60);
+	t77 = vandq_u8(t66, t62);
+	t78 = vandq_u8(t66, t64);
+	t79 = vandq_u8(t64, t58);
+	t80 = vandq_u8(t64, t60);
+	t81 = vandq_u8(t64, t62);
+	t82 = vandq_u8(t64, t64);
+	t83 = veorq_u8(t68, t71);
+	t84 = veorq_u8(t69, t72);
+	t85 = veorq_u8(t84, t75);
+	t86 = veorq_u8(t70, t73);
+	t87 = veorq_u8(t86, t76);
+	t88 = veorq_u8(t87, t79);
+	t89 = veorq_u8(t74, t77);
+	t90 = veorq_u8(t89, t80);
+	t91 = veorq_u8(t78, t81);
+	t92 = veorq_u8(t67, t90);
+	t93 = veorq_u8(t83, t90);
+	t94 = veorq_u8(t93, t91);
+	t95 = veorq_u8(t85, t91);
+	t96 = veorq_u8(t95, t82);
+	t97 = veorq_u8(t88, t82);
+	t98 = veorq_u8(t92, t94);
+	t99 = veorq_u8(t98, t96);
+	t100 = veorq_u8(t99, t97);
+	t101 = veorq_u8(t94, t97);
+	t102 = veorq_u8(t96, t97);
+	t103 = vandq_u8(t100, t65);
+	t104 = vandq_u8(t100, t62);
+	t105 = vandq_u8(t100, t66);
+	t106 = vandq_u8(t100, t64);
+	t107 = vandq_u8(t101, t65);
+	t108 = vandq_u8(t101, t62);
+	t109 = vandq_u8(t101, t66);
+	t110 = vandq_u8(t101, t64);
+	t111 = vandq_u8(t102, t65);
+	t112 = vandq_u8(t102, t62);
+	t113 = vandq_u8(t102, t66);
+	t114 = vandq_u8(t102, t64);
+	t115 = vandq_u8(t97, t65);
+	t116 = vandq_u8(t97, t62);
+	t117 = vandq_u8(t97, t66);
+	t118 = vandq_u8(t97, t64);
+	t119 = veorq_u8(t104, t107);
+	t120 = veorq_u8(t105, t108);
+	t121 = veorq_u8(t120, t111);
+	t122 = veorq_u8(t106, t109);
+	t123 = veorq_u8(t122, t112);
+	t124 = veorq_u8(t123, t115);
+	t125 = veorq_u8(t110, t113);
+	t126 = veorq_u8(t125, t116);
+	t127 = veorq_u8(t114, t117);
+	t128 = veorq_u8(t103, t126);
+	t129 = veorq_u8(t119, t126);
+	t130 = veorq_u8(t129, t127);
+	t131 = veorq_u8(t121, t127);
+	t132 = veorq_u8(t131, t118);
+	t133 = veorq_u8(t124, t118);
+	t134 = vandq_u8(t14, t128);
+	t135 = vandq_u8(t14, t130);
+	t136 = vandq_u8(t14, t132);
+	t137 = vandq_u8(t14, t133);
+	t138 = vandq_u8(t15, t128);
+	t139 = vandq_u8(t15, t130);
+	t140 = vandq_u8(t15, t132);
+	t141 = vandq_u8(t15, t133);
+	t142 = vandq_u8(t17, t128);
+	t143 = vandq_u8(t17, t130);
+	t144 = vandq_u8(t17, t132);
+	t145 = vandq_u8(t17, t133);
+	t146 = vandq_u8(t19, t128);
+	t147 = vandq_u8(t19, t130);
+	t148 = vandq_u8(t19, t132);
+	t149 = vandq_u8(t19, t133);
+	t150 = veorq_u8(t135, t138);
+	t151 = veorq_u8(t136, t139);
+	t152 = veorq_u8(t151, t142);
+	t153 = veorq_u8(t137, t140);
+	t154 = veorq_u8(t153, t143);
+	t155 = veorq_u8(t154, t146);
+	t156 = veorq_u8(t141, t144);
+	t157 = veorq_u8(t156, t147);
+	t158 = veorq_u8(t145, t148);
+	t159 = veorq_u8(t134, t157);
+	t160 = veorq_u8(t150, t157);
+	t161 = veorq_u8(t160, t158);
+	t162 = veorq_u8(t152, t158);
+	t163 = veorq_u8(t162, t149);
+	t164 = veorq_u8(t155, t149);
+	t165 = veorq_u8(t14, t6);
+	t166 = veorq_u8(t15, t8);
+	t167 = veorq_u8(t17, t10);
+	t168 = veorq_u8(t19, t12);
+	t169 = vandq_u8(t165, t128);
+	t170 = vandq_u8(t165, t130);
+	t171 = vandq_u8(t165, t132);
+	t172 = vandq_u8(t165, t133);
+	t173 = vandq_u8(t166, t128);
+	t174 = vandq_u8(t166, t130);
+	t175 = vandq_u8(t166, t132);
+	t176 = vandq_u8(t166, t133);
+	t177 = vandq_u8(t167, t128);
+	t178 = vandq_u8(t167, t130);
+	t179 = vandq_u8(t167, t132);
+	t180 = vandq_u8(t167, t133);
+	t181 = vandq_u8(t168, t128);
+	t182 = vandq_u8(t168, t130);
+	t183 = vandq_u8(t168, t132);
+	t184 = vandq_u8(t168, t133);
+	t185 = veorq_u8(t170, t173);
+	t186 = veorq_u8(t171, t174);
+	t187 = veorq_u8(t186, t177);
+	t188 = veorq_u8(t172, t175);
+	t189 = veorq_u8(t188, t178);
+	t190 = veorq_u8(t189, t181);
+	t191 = veorq_u8(t176, t179);
+	t192 = veorq_u8(t191, t182);
+	t193 = veorq_u8(t180, t183);
+	t194 = veorq_u8(t169, t192);
+	t195 = veorq_u8(t185, t192);
+	t196 = veorq_u8(t195, t193);
+	t197 = veorq_u8(t187, t193);
+	t198 = veorq_u8(t197, t184);
+	t199 = veorq_u8(t190, t184);
+	t200 = veorq_u8(t164, t196);
+	t201 = veorq_u8(t199, t200);
+	t202 = veorq_u8(t163, t198);
+	t203 = veorq_u8(t159, t202);
+	t204 = veorq_u8(t164, t194);
+	t205 = veorq_u8(t159, t161);
+	t206 = veorq_u8(t205, t164);
+	t207 = veorq_u8(t163, t200);
+	t208 = veorq_u8(t163, t201);
+	t209 = veorq_u8(t198, t201);
+	t210 = veorq_u8(t164, t203);
+	x[0] = t204;
+	x[1] = t206;
+	x[2] = t196;
+	x[3] = t207;
+	x[4] = t208;
+	x[5] = t203;
+	x[6] = t209;
+	x[7] = t210;
+}
+
+static inline void load8(bs_t x[8], const uint8_t *in)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		x[i] = vld1q_u8(in + 16 * i);
+	bitslice(x);
+}
+
+static inline void store8(uint8_t *out, bs_t x[8])
+{
+	int i;
+
+	bitslice(x);
+	for (i = 0; i < 8; i++)
+		vst1q_u8(out + 16 * i, x[i]);
+}
+
+void aesbs_encrypt8(void *out, const void *in, const void *rk, int rounds)
+{
+	const uint8_t *k = rk;
+	bs_t x[8];
+	int r;
+
+	load8(x, in);
+	add_round_key(x, k);
+	for (r = 1; r < rounds; r++) {
+		sub_bytes(x);
+		shift_rows(x, shift_rows_tbl);
+		mix_columns(x);
+		add_round_key(x, k + r * AESBS_RK_SIZE);
+	}
+	sub_bytes(x);
+	shift_rows(x, shift_rows_tbl);
+	add_round_key(x, k + rounds * AESBS_RK_SIZE);
+	store8(out, x);
+}
+
+void aesbs_decrypt8(void *out, const void *in, const void *rk, int rounds)
+{
+	const uint8_t *k = rk;
+	bs_t x[8];
+	int r;
+
+	load8(x, in);
+	add_round_key(x, k + rounds * AESBS_RK_SIZE);
+	for (r = rounds - 1; r > 0; r--) {
+		shift_rows(x, inv_shift_rows_tbl);
+		inv_sub_bytes(x);
+		add_round_key(x, k + r * AESBS_RK_SIZE);
+		inv_mix_columns(x);
+	}
+	shift_rows(x, inv_shift_rows_tbl);
+	inv_sub_bytes(x);
+	add_round_key(x, k);
+	store8(out, x);
+}
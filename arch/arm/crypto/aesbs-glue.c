@@ -0,0 +1,560 @@
+/*
+ * Glue code for the bit sliced NEON AES implementation
+ *
+ * ECB, CBC decryption, CTR and XTS process eight blocks per call into the
+ * NEON core. CBC encryption is inherently serial and uses the scalar
+ * cipher, as does any request issued from interrupt context where the
+ * NEON register file may not be touched.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <crypto/aes.h>
+#include <crypto/algapi.h>
+#include <crypto/xts.h>
+#include <linux/crypto.h>
+#include <linux/hardirq.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <asm/neon.h>
+
+#include "aesbs.h"
+
+#define AESBS_BATCH	(AESBS_BLOCKS * AES_BLOCK_SIZE)
+
+struct aesbs_ctx {
+	int rounds;
+	u8 rk[AESBS_MAX_ROUNDS + 1][AESBS_RK_SIZE] __aligned(16);
+	struct crypto_cipher *fallback;
+};
+
+struct aesbs_xts_ctx {
+	struct aesbs_ctx data;
+	struct crypto_cipher *tweak;
+};
+
+static inline bool aesbs_use_neon(void)
+{
+	return !in_interrupt();
+}
+
+static int aesbs_expand_key(struct aesbs_ctx *ctx, const u8 *in_key,
+			    unsigned int key_len, u32 *flags)
+{
+	struct crypto_aes_ctx rk;
+	int r, i, j, err;
+
+	err = crypto_aes_expand_key(&rk, in_key, key_len);
+	if (err) {
+		*flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+		return err;
+	}
+
+	ctx->rounds = 6 + key_len / 4;
+	for (r = 0; r <= ctx->rounds; r++) {
+		for (j = 0; j < AES_BLOCK_SIZE; j++) {
+			u8 b = rk.key_enc[4 * r + j / 4] >> (8 * (j % 4));
+
+			for (i = 0; i < 8; i++)
+				ctx->rk[r][16 * i + j] = -((b >> i) & 1);
+		}
+	}
+	memset(&rk, 0, sizeof(rk));
+
+	crypto_cipher_clear_flags(ctx->fallback, CRYPTO_TFM_REQ_MASK);
+	crypto_cipher_set_flags(ctx->fallback, *flags & CRYPTO_TFM_REQ_MASK);
+	err = crypto_cipher_setkey(ctx->fallback, in_key, key_len);
+	*flags |= crypto_cipher_get_flags(ctx->fallback) & CRYPTO_TFM_RES_MASK;
+
+	return err;
+}
+
+static int aesbs_setkey(struct crypto_tfm *tfm, const u8 *in_key,
+			unsigned int key_len)
+{
+	return aesbs_expand_key(crypto_tfm_ctx(tfm), in_key, key_len,
+				&tfm->crt_flags);
+}
+
+static int aesbs_xts_setkey(struct crypto_tfm *tfm, const u8 *in_key,
+			    unsigned int key_len)
+{
+	struct aesbs_xts_ctx *ctx = crypto_tfm_ctx(tfm);
+	u32 *flags = &tfm->crt_flags;
+	int err;
+
+	if (key_len % 2) {
+		*flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+		return -EINVAL;
+	}
+
+	err = aesbs_expand_key(&ctx->data, in_key, key_len / 2, flags);
+	if (err)
+		return err;
+
+	crypto_cipher_clear_flags(ctx->tweak, CRYPTO_TFM_REQ_MASK);
+	crypto_cipher_set_flags(ctx->tweak, *flags & CRYPTO_TFM_REQ_MASK);
+	err = crypto_cipher_setkey(ctx->tweak, in_key + key_len / 2,
+				   key_len / 2);
+	*flags |= crypto_cipher_get_flags(ctx->tweak) & CRYPTO_TFM_RES_MASK;
+
+	return err;
+}
+
+static void aesbs_crypt_neon(struct aesbs_ctx *ctx, u8 *dst, const u8 *src,
+			     unsigned int nblocks, bool enc)
+{
+	u8 buf[AESBS_BATCH] __aligned(16);
+	void (*fn)(void *, const void *, const void *, int);
+
+	fn = enc ? aesbs_encrypt8 : aesbs_decrypt8;
+
+	while (nblocks >= AESBS_BLOCKS) {
+		fn(dst, src, ctx->rk, ctx->rounds);
+		src += AESBS_BATCH;
+		dst += AESBS_BATCH;
+		nblocks -= AESBS_BLOCKS;
+	}
+
+	if (nblocks) {
+		memcpy(buf, src, nblocks * AES_BLOCK_SIZE);
+		fn(buf, buf, ctx->rk, ctx->rounds);
+		memcpy(dst, buf, nblocks * AES_BLOCK_SIZE);
+	}
+}
+
+static void aesbs_crypt_fallback(struct aesbs_ctx *ctx, u8 *dst,
+				 const u8 *src, unsigned int nblocks, bool enc)
+{
+	for (; nblocks; nblocks--) {
+		if (enc)
+			crypto_cipher_encrypt_one(ctx->fallback, dst, src);
+		else
+			crypto_cipher_decrypt_one(ctx->fallback, dst, src);
+		src += AES_BLOCK_SIZE;
+		dst += AES_BLOCK_SIZE;
+	}
+}
+
+static void aesbs_crypt(struct aesbs_ctx *ctx, u8 *dst, const u8 *src,
+			unsigned int nblocks, bool enc)
+{
+	if (!aesbs_use_neon()) {
+		aesbs_crypt_fallback(ctx, dst, src, nblocks, enc);
+		return;
+	}
+
+	kernel_neon_begin();
+	aesbs_crypt_neon(ctx, dst, src, nblocks, enc);
+	kernel_neon_end();
+}
+
+static int ecb_crypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		     struct scatterlist *src, unsigned int nbytes, bool enc)
+{
+	struct aesbs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+	struct blkcipher_walk walk;
+	int err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt(desc, &walk);
+
+	while ((nbytes = walk.nbytes)) {
+		aesbs_crypt(ctx, walk.dst.virt.addr, walk.src.virt.addr,
+			    nbytes / AES_BLOCK_SIZE, enc);
+		err = blkcipher_walk_done(desc, &walk,
+					  nbytes % AES_BLOCK_SIZE);
+	}
+
+	return err;
+}
+
+static int ecb_encrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		       struct scatterlist *src, unsigned int nbytes)
+{
+	return ecb_crypt(desc, dst, src, nbytes, true);
+}
+
+static int ecb_decrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		       struct scatterlist *src, unsigned int nbytes)
+{
+	return ecb_crypt(desc, dst, src, nbytes, false);
+}
+
+static int cbc_encrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		       struct scatterlist *src, unsigned int nbytes)
+{
+	struct aesbs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+	struct blkcipher_walk walk;
+	int err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt(desc, &walk);
+
+	while ((nbytes = walk.nbytes)) {
+		u8 *wsrc = walk.src.virt.addr;
+		u8 *wdst = walk.dst.virt.addr;
+		u8 *iv = walk.iv;
+
+		do {
+			crypto_xor(iv, wsrc, AES_BLOCK_SIZE);
+			crypto_cipher_encrypt_one(ctx->fallback, wdst, iv);
+			memcpy(iv, wdst, AES_BLOCK_SIZE);
+
+			wsrc += AES_BLOCK_SIZE;
+			wdst += AES_BLOCK_SIZE;
+			nbytes -= AES_BLOCK_SIZE;
+		} while (nbytes >= AES_BLOCK_SIZE);
+
+		err = blkcipher_walk_done(desc, &walk, nbytes);
+	}
+
+	return err;
+}
+
+static int cbc_decrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		       struct scatterlist *src, unsigned int nbytes)
+{
+	struct aesbs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+	struct blkcipher_walk walk;
+	u8 ct[AESBS_BATCH];
+	int err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt(desc, &walk);
+
+	while ((nbytes = walk.nbytes)) {
+		u8 *wsrc = walk.src.virt.addr;
+		u8 *wdst = walk.dst.virt.addr;
+		unsigned int nblocks = nbytes / AES_BLOCK_SIZE;
+		bool neon = aesbs_use_neon();
+
+		if (neon)
+			kernel_neon_begin();
+
+		while (nblocks) {
+			unsigned int n = min_t(unsigned int, nblocks,
+					       AESBS_BLOCKS);
+			unsigned int i;
+
+			memcpy(ct, wsrc, n * AES_BLOCK_SIZE);
+			if (neon)
+				aesbs_crypt_neon(ctx, wdst, wsrc, n, false);
+			else
+				aesbs_crypt_fallback(ctx, wdst, wsrc, n, false);
+
+			crypto_xor(wdst, walk.iv, AES_BLOCK_SIZE);
+			for (i = 1; i < n; i++)
+				crypto_xor(wdst + i * AES_BLOCK_SIZE,
+					   ct + (i - 1) * AES_BLOCK_SIZE,
+					   AES_BLOCK_SIZE);
+			memcpy(walk.iv, ct + (n - 1) * AES_BLOCK_SIZE,
+			       AES_BLOCK_SIZE);
+
+			wsrc += n * AES_BLOCK_SIZE;
+			wdst += n * AES_BLOCK_SIZE;
+			nblocks -= n;
+		}
+
+		if (neon)
+			kernel_neon_end();
+
+		err = blkcipher_walk_done(desc, &walk,
+					  nbytes % AES_BLOCK_SIZE);
+	}
+
+	return err;
+}
+
+static void ctr_keystream(struct aesbs_ctx *ctx, u8 *ks, u8 *ctrblk,
+			  unsigned int nblocks, bool neon)
+{
+	unsigned int i;
+
+	for (i = 0; i < nblocks; i++) {
+		memcpy(ks + i * AES_BLOCK_SIZE, ctrblk, AES_BLOCK_SIZE);
+		crypto_inc(ctrblk, AES_BLOCK_SIZE);
+	}
+	if (neon)
+		aesbs_crypt_neon(ctx, ks, ks, nblocks, true);
+	else
+		aesbs_crypt_fallback(ctx, ks, ks, nblocks, true);
+}
+
+static int ctr_crypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		     struct scatterlist *src, unsigned int nbytes)
+{
+	struct aesbs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+	struct blkcipher_walk walk;
+	u8 ks[AESBS_BATCH] __aligned(16);
+	int err;
+
+	blkcipher_walk_init(&walk, dst, src, nbytes);
+	err = blkcipher_walk_virt_block(desc, &walk, AES_BLOCK_SIZE);
+
+	while (walk.nbytes >= AES_BLOCK_SIZE) {
+		u8 *wsrc = walk.src.virt.addr;
+		u8 *wdst = walk.dst.virt.addr;
+		bool neon = aesbs_use_neon();
+
+		if (neon)
+			kernel_neon_begin();
+
+		nbytes = walk.nbytes;
+		while (nbytes >= AES_BLOCK_SIZE) {
+			unsigned int n = min_t(unsigned int,
+					       nbytes / AES_BLOCK_SIZE,
+					       AESBS_BLOCKS);
+
+			ctr_keystream(ctx, ks, walk.iv, n, neon);
+			if (wsrc != wdst)
+				memcpy(wdst, wsrc, n * AES_BLOCK_SIZE);
+			crypto_xor(wdst, ks, n * AES_BLOCK_SIZE);
+
+			wsrc += n * AES_BLOCK_SIZE;
+			wdst += n * AES_BLOCK_SIZE;
+			nbytes -= n * AES_BLOCK_SIZE;
+		}
+
+		if (neon)
+			kernel_neon_end();
+
+		err = blkcipher_walk_done(desc, &walk, nbytes);
+	}
+
+	if (walk.nbytes) {
+		crypto_cipher_encrypt_one(ctx->fallback, ks, walk.iv);
+		crypto_inc(walk.iv, AES_BLOCK_SIZE);
+		crypto_xor(ks, walk.src.virt.addr, walk.nbytes);
+		memcpy(walk.dst.virt.addr, ks, walk.nbytes);
+		err = blkcipher_walk_done(desc, &walk, 0);
+	}
+
+	return err;
+}
+
+struct aesbs_xts_priv {
+	struct aesbs_ctx *ctx;
+	bool neon;
+	bool enc;
+};
+
+static void xts_tweak(void *tweak, u8 *dst, const u8 *src)
+{
+	crypto_cipher_encrypt_one(tweak, dst, src);
+}
+
+static void xts_callback(void *priv, u8 *srcdst, unsigned int nbytes)
+{
+	struct aesbs_xts_priv *p = priv;
+
+	if (p->neon)
+		aesbs_crypt_neon(p->ctx, srcdst, srcdst,
+				 nbytes / AES_BLOCK_SIZE, p->enc);
+	else
+		aesbs_crypt_fallback(p->ctx, srcdst, srcdst,
+				     nbytes / AES_BLOCK_SIZE, p->enc);
+}
+
+static int xts_crypt_common(struct blkcipher_desc *desc,
+			    struct scatterlist *dst, struct scatterlist *src,
+			    unsigned int nbytes, bool enc)
+{
+	struct aesbs_xts_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+	be128 buf[AESBS_BLOCKS];
+	struct aesbs_xts_priv priv = {
+		.ctx = &ctx->data,
+		.neon = aesbs_use_neon(),
+		.enc = enc,
+	};
+	struct xts_crypt_req req = {
+		.tbuf = buf,
+		.tbuflen = sizeof(buf),
+
+		.tweak_ctx = ctx->tweak,
+		.tweak_fn = xts_tweak,
+		.crypt_ctx = &priv,
+		.crypt_fn = xts_callback,
+	};
+	int ret;
+
+	if (priv.neon) {
+		desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+		kernel_neon_begin();
+	}
+	ret = xts_crypt(desc, dst, src, nbytes, &req);
+	if (priv.neon)
+		kernel_neon_end();
+
+	return ret;
+}
+
+static int xts_encrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		       struct scatterlist *src, unsigned int nbytes)
+{
+	return xts_crypt_common(desc, dst, src, nbytes, true);
+}
+
+static int xts_decrypt(struct blkcipher_desc *desc, struct scatterlist *dst,
+		       struct scatterlist *src, unsigned int nbytes)
+{
+	return xts_crypt_common(desc, dst, src, nbytes, false);
+}
+
+static int aesbs_init_tfm(struct crypto_tfm *tfm)
+{
+	struct aesbs_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	ctx->fallback = crypto_alloc_cipher("aes", 0, CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(ctx->fallback))
+		return PTR_ERR(ctx->fallback);
+
+	return 0;
+}
+
+static void aesbs_exit_tfm(struct crypto_tfm *tfm)
+{
+	struct aesbs_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	crypto_free_cipher(ctx->fallback);
+}
+
+static int aesbs_xts_init_tfm(struct crypto_tfm *tfm)
+{
+	struct aesbs_xts_ctx *ctx = crypto_tfm_ctx(tfm);
+	int err;
+
+	err = aesbs_init_tfm(tfm);
+	if (err)
+		return err;
+
+	ctx->tweak = crypto_alloc_cipher("aes", 0, CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(ctx->tweak)) {
+		crypto_free_cipher(ctx->data.fallback);
+		return PTR_ERR(ctx->tweak);
+	}
+
+	return 0;
+}
+
+static void aesbs_xts_exit_tfm(struct crypto_tfm *tfm)
+{
+	struct aesbs_xts_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	crypto_free_cipher(ctx->tweak);
+	aesbs_exit_tfm(tfm);
+}
+
+static struct crypto_alg aesbs_algs[] = { {
+	.cra_name		= "ecb(aes)",
+	.cra_driver_name	= "ecb-aes-neonbs",
+	.cra_priority		= 250,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aesbs_ctx),
+	.cra_alignmask		= 0,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_init		= aesbs_init_tfm,
+	.cra_exit		= aesbs_exit_tfm,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= AES_MIN_KEY_SIZE,
+			.max_keysize	= AES_MAX_KEY_SIZE,
+			.setkey		= aesbs_setkey,
+			.encrypt	= ecb_encrypt,
+			.decrypt	= ecb_decrypt,
+		},
+	},
+}, {
+	.cra_name		= "cbc(aes)",
+	.cra_driver_name	= "cbc-aes-neonbs",
+	.cra_priority		= 250,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aesbs_ctx),
+	.cra_alignmask		= 0,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_init		= aesbs_init_tfm,
+	.cra_exit		= aesbs_exit_tfm,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= AES_MIN_KEY_SIZE,
+			.max_keysize	= AES_MAX_KEY_SIZE,
+			.ivsize		= AES_BLOCK_SIZE,
+			.setkey		= aesbs_setkey,
+			.encrypt	= cbc_encrypt,
+			.decrypt	= cbc_decrypt,
+		},
+	},
+}, {
+	.cra_name		= "ctr(aes)",
+	.cra_driver_name	= "ctr-aes-neonbs",
+	.cra_priority		= 250,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= 1,
+	.cra_ctxsize		= sizeof(struct aesbs_ctx),
+	.cra_alignmask		= 0,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_init		= aesbs_init_tfm,
+	.cra_exit		= aesbs_exit_tfm,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= AES_MIN_KEY_SIZE,
+			.max_keysize	= AES_MAX_KEY_SIZE,
+			.ivsize		= AES_BLOCK_SIZE,
+			.setkey		= aesbs_setkey,
+			.encrypt	= ctr_crypt,
+			.decrypt	= ctr_crypt,
+		},
+	},
+}, {
+	.cra_name		= "xts(aes)",
+	.cra_driver_name	= "xts-aes-neonbs",
+	.cra_priority		= 250,
+	.cra_flags		= CRYPTO_ALG_TYPE_BLKCIPHER,
+	.cra_blocksize		= AES_BLOCK_SIZE,
+	.cra_ctxsize		= sizeof(struct aesbs_xts_ctx),
+	.cra_alignmask		= 0,
+	.cra_type		= &crypto_blkcipher_type,
+	.cra_module		= THIS_MODULE,
+	.cra_init		= aesbs_xts_init_tfm,
+	.cra_exit		= aesbs_xts_exit_tfm,
+	.cra_u = {
+		.blkcipher = {
+			.min_keysize	= 2 * AES_MIN_KEY_SIZE,
+			.max_keysize	= 2 * AES_MAX_KEY_SIZE,
+			.ivsize		= AES_BLOCK_SIZE,
+			.setkey		= aesbs_xts_setkey,
+			.encrypt	= xts_encrypt,
+			.decrypt	= xts_decrypt,
+		},
+	},
+} };
+
+static int __init aesbs_mod_init(void)
+{
+	if (!cpu_has_neon())
+		return -ENODEV;
+
+	return crypto_register_algs(aesbs_algs, ARRAY_SIZE(aesbs_algs));
+}
+
+static void __exit aesbs_mod_exit(void)
+{
+	crypto_unregister_algs(aesbs_algs, ARRAY_SIZE(aesbs_algs));
+}
+
+module_init(aesbs_mod_init);
+module_exit(aesbs_mod_exit);
+
+MODULE_DESCRIPTION("Bit sliced AES in ECB/CBC/CTR/XTS modes using NEON");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("ecb(aes)");
+MODULE_ALIAS("cbc(aes)");
+MODULE_ALIAS("ctr(aes)");
+MODULE_ALIAS("xts(aes)");
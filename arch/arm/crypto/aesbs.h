@@ -0,0 +1,11 @@
+#ifndef __ARM_CRYPTO_AESBS_H
+#define __ARM_CRYPTO_AESBS_H
+
+#define AESBS_BLOCKS		8
+#define AESBS_MAX_ROUNDS	14
+#define AESBS_RK_SIZE		(8 * 16)
+
+void aesbs_encrypt8(void *out, const void *in, const void *rk, int rounds);
+void aesbs_decrypt8(void *out, const void *in, const void *rk, int rounds);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef __ARM_CRYPTO_SHA_NEON_H
+#define __ARM_CRYPTO_SHA_NEON_H
+
+void sha1_neon_transform(unsigned int *state, const void *data, int blocks);
+void sha256_neon_transform(unsigned int *state, const void *data, int blocks);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * SHA-1 block transform with a NEON message schedule
+ *
+ * The 80 word schedule is expanded four words at a time and the round
+ * constants are folded in, leaving only the scalar round function for the
+ * integer pipeline.
+ *
+ * This unit is built with -mfpu=neon and must only be entered from between
+ * kernel_neon_begin() and kernel_neon_end().
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/neon-intrinsics.h>
+
+#include "sha-neon.h"
+
+#define rol32(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+
+static inline uint32x4_t vrolq1(uint32x4_t x)
+{
+	return vsliq_n_u32(vshrq_n_u32(x, 31), x, 1);
+}
+
+static void sha1_schedule(uint32_t wk[80], const uint8_t *data)
+{
+	static const uint32_t k[4] = {
+		0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6,
+	};
+	uint32_t w[80];
+	uint32x4_t zero = vdupq_n_u32(0);
+	int t;
+
+	for (t = 0; t < 16; t += 4) {
+		uint8x16_t b = vrev32q_u8(vld1q_u8(data + 4 * t));
+
+		vst1q_u32(w + t, vreinterpretq_u32_u8(b));
+	}
+
+	for (t = 16; t < 80; t += 4) {
+		uint32x4_t v, f;
+
+		v = vextq_u32(vld1q_u32(w + t - 4), zero, 1);
+		v = veorq_u32(v, vld1q_u32(w + t - 8));
+		v = veorq_u32(v, vld1q_u32(w + t - 14));
+		v = veorq_u32(v, vld1q_u32(w + t - 16));
+		v = vrolq1(v);
+		f = vextq_u32(zero, v, 1);
+		v = veorq_u32(v, vrolq1(f));
+		vst1q_u32(w + t, v);
+	}
+
+	for (t = 0; t < 80; t += 4)
+		vst1q_u32(wk + t, vaddq_u32(vld1q_u32(w + t),
+					    vdupq_n_u32(k[t / 20])));
+}
+
+void sha1_neon_transform(unsigned int *state, const void *data, int blocks)
+{
+	const uint8_t *src = data;
+	uint32_t wk[80];
+
+	while (blocks--) {
+		uint32_t a = state[0], b = state[1], c = state[2];
+		uint32_t d = state[3], e = state[4], tmp;
+		int t;
+
+		sha1_schedule(wk, src);
+
+		for (t = 0; t < 80; t++) {
+			if (t < 20)
+				tmp = (b & c) | (~b & d);
+			else if (t < 40 || t >= 60)
+				tmp = b ^ c ^ d;
+			else
+				tmp = (b & c) | (d & (b | c));
+			tmp += rol32(a, 5) + e + wk[t];
+			e = d;
+			d = c;
+			c = rol32(b, 30);
+			b = a;
+			a = tmp;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		src += 64;
+	}
+}
@@ -0,0 +1,122 @@
+/*
+ * SHA-256 block transform with a NEON message schedule
+ *
+ * The schedule is expanded four words at a time: the sigma0 and W[t-7]
+ * terms for all four lanes first, then the sigma1 term for the low and
+ * high lane pairs in turn, since the high pair depends on the low one.
+ *
+ * This unit is built with -mfpu=neon and must only be entered from between
+ * kernel_neon_begin() and kernel_neon_end().
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/neon-intrinsics.h>
+
+#include "sha-neon.h"
+
+#define ror32(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define VROR(x, n)	vsliq_n_u32(vshrq_n_u32(x, n), x, 32 - (n))
+#define VROR2(x, n)	vsli_n_u32(vshr_n_u32(x, n), x, 32 - (n))
+
+static inline uint32x4_t vsigma0(uint32x4_t x)
+{
+	return veorq_u32(veorq_u32(VROR(x, 7), VROR(x, 18)),
+			 vshrq_n_u32(x, 3));
+}
+
+static inline uint32x2_t vsigma1(uint32x2_t x)
+{
+	return veor_u32(veor_u32(VROR2(x, 17), VROR2(x, 19)),
+			vshr_n_u32(x, 10));
+}
+
+static void sha256_schedule(uint32_t wk[64], const uint8_t *data)
+{
+	uint32_t w[64];
+	int t;
+
+	for (t = 0; t < 16; t += 4) {
+		uint8x16_t b = vrev32q_u8(vld1q_u8(data + 4 * t));
+
+		vst1q_u32(w + t, vreinterpretq_u32_u8(b));
+	}
+
+	for (t = 16; t < 64; t += 4) {
+		uint32x4_t v;
+		uint32x2_t lo, hi;
+
+		v = vaddq_u32(vld1q_u32(w + t - 16),
+			      vsigma0(vld1q_u32(w + t - 15)));
+		v = vaddq_u32(v, vld1q_u32(w + t - 7));
+		lo = vadd_u32(vget_low_u32(v), vsigma1(vld1_u32(w + t - 2)));
+		hi = vadd_u32(vget_high_u32(v), vsigma1(lo));
+		vst1q_u32(w + t, vcombine_u32(lo, hi));
+	}
+
+	for (t = 0; t < 64; t += 4)
+		vst1q_u32(wk + t, vaddq_u32(vld1q_u32(w + t),
+					    vld1q_u32(sha256_k + t)));
+}
+
+void sha256_neon_transform(unsigned int *state, const void *data, int blocks)
+{
+	const uint8_t *src = data;
+	uint32_t wk[64];
+
+	while (blocks--) {
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+		uint32_t t1, t2;
+		int t;
+
+		sha256_schedule(wk, src);
+
+		for (t = 0; t < 64; t++) {
+			t1 = h + (ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25)) +
+			     (g ^ (e & (f ^ g))) + wk[t];
+			t2 = (ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22)) +
+			     ((a & b) | (c & (a | b)));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+		src += 64;
+	}
+}
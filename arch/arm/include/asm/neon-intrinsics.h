@@ -0,0 +1,10 @@
+#ifndef __ASM_NEON_INTRINSICS_H
+#define __ASM_NEON_INTRINSICS_H
+
+#ifndef __ARM_NEON__
+#error "NEON intrinsics require -mfpu=neon"
+#endif
+
+#include <arm_neon.h>
+
+#endif
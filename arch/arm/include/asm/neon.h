@@ -0,0 +1,15 @@
+#ifndef __ASM_NEON_H
+#define __ASM_NEON_H
+
+#include <asm/hwcap.h>
+
+#define cpu_has_neon()		(!!(elf_hwcap & HWCAP_NEON))
+
+#ifdef __ARM_NEON__
+#error "kernel_neon_begin() must not be called from a unit built with NEON"
+#endif
+
+void kernel_neon_begin(void);
+void kernel_neon_end(void);
+
+#endif
@@ -24,6 +24,8 @@
 
 #define QMI_COMMON_TLV_TYPE 0
 
+#define QMI_TXN_HASH_SIZE 16
+
 enum qmi_event_type {
 	QMI_RECV_MSG = 1,
 	QMI_SERVER_ARRIVE,
@@ -35,6 +37,7 @@ struct qmi_handle {
 	void *dest_info;
 	uint16_t next_txn_id;
 	struct list_head txn_list;
+	struct hlist_head txn_hash[QMI_TXN_HASH_SIZE];
 	struct mutex handle_lock;
 	spinlock_t notify_lock;
 	void (*notify)(struct qmi_handle *handle, enum qmi_event_type event,
@@ -20,6 +20,8 @@
 #define __ARCH_ARM_MACH_PERF_LOCK_H
 
 #include <linux/list.h>
+#include <linux/plist.h>
+#include <linux/timer.h>
 #include <linux/cpufreq.h>
 
 
@@ -37,12 +39,18 @@ enum {
 	PERF_LOCK_INVALID,
 };
 
+#define PERF_LOCK_ALL_CPUS	(-1)
+
 struct perf_lock {
 	struct list_head link;
+	struct plist_node node;
+	struct timer_list expire_timer;
+	unsigned long expires;
 	unsigned int flags;
 	unsigned int level;
 	const char *name;
 	unsigned int type;
+	int cpu;
 };
 
 struct perflock_data {
@@ -59,7 +67,13 @@ struct perflock_pdata {
 #ifndef CONFIG_PERFLOCK
 static inline void perf_lock_init(struct perf_lock *lock, unsigned int type,
 	unsigned int level, const char *name) { return; }
+static inline void perf_lock_init_cpu(struct perf_lock *lock, unsigned int type,
+	unsigned int level, const char *name, int cpu) { return; }
 static inline void perf_lock(struct perf_lock *lock) { return; }
+static inline void perf_lock_timeout(struct perf_lock *lock,
+	unsigned int timeout_ms) { return; }
+static inline unsigned int perflock_cpu_floor(int cpu) { return 0; }
+static inline unsigned int perflock_cpu_ceiling(int cpu) { return 0; }
 static inline void perf_unlock(struct perf_lock *lock) { return; }
 static inline int is_perf_lock_active(struct perf_lock *lock) { return 0; }
 static inline int is_perf_locked(void) { return 0; }
@@ -72,7 +86,12 @@ static inline int perflock_release(const char *name) { return 0; }
 #else
 extern void perf_lock_init(struct perf_lock *lock, unsigned int type,
 	unsigned int level, const char *name);
+extern void perf_lock_init_cpu(struct perf_lock *lock, unsigned int type,
+	unsigned int level, const char *name, int cpu);
 extern void perf_lock(struct perf_lock *lock);
+extern void perf_lock_timeout(struct perf_lock *lock, unsigned int timeout_ms);
+extern unsigned int perflock_cpu_floor(int cpu);
+extern unsigned int perflock_cpu_ceiling(int cpu);
 extern void perf_unlock(struct perf_lock *lock);
 extern int is_perf_lock_active(struct perf_lock *lock);
 extern int is_perf_locked(void);
@@ -28,6 +28,8 @@
 #include <linux/uaccess.h>
 #include <linux/debugfs.h>
 #include <linux/rwsem.h>
+#include <linux/srcu.h>
+#include <linux/ktime.h>
 
 #include <asm/uaccess.h>
 #include <asm/byteorder.h>
@@ -107,6 +109,16 @@ static DECLARE_RWSEM(control_ports_lock_lha5);
 static struct list_head local_ports[LP_HASH_SIZE];
 static DECLARE_RWSEM(local_ports_lock_lha2);
 
+/*
+ * Local ports, routing table entries and remote ports are looked up on the
+ * data path under ipc_router_srcu rather than the list rwsems.  Writers
+ * still serialize on the rwsems, unlink with the _rcu list primitives and
+ * wait for a grace period before freeing or relinking an entry.  SRCU is
+ * needed because readers sleep while posting to a port or writing to a
+ * transport.
+ */
+static struct srcu_struct ipc_router_srcu;
+
 #define SRV_HASH_SIZE 32
 static struct list_head server_list[SRV_HASH_SIZE];
 static DECLARE_RWSEM(server_list_lock_lha2);
@@ -168,6 +180,7 @@ struct msm_ipc_routing_table_entry {
 	struct list_head remote_port_list[RP_HASH_SIZE];
 	struct msm_ipc_router_xprt_info *xprt_info;
 	struct rw_semaphore lock_lha4;
+	struct list_head free_list;
 	unsigned long num_tx_bytes;
 	unsigned long num_rx_bytes;
 };
@@ -232,7 +245,7 @@ static int add_routing_table_entry(
 		return -EINVAL;
 
 	key = (rt_entry->node_id % RT_HASH_SIZE);
-	list_add_tail(&rt_entry->list, &routing_table[key]);
+	list_add_tail_rcu(&rt_entry->list, &routing_table[key]);
 	return 0;
 }
 
@@ -242,7 +255,7 @@ static struct msm_ipc_routing_table_entry *lookup_routing_table(
 	uint32_t key = (node_id % RT_HASH_SIZE);
 	struct msm_ipc_routing_table_entry *rt_entry;
 
-	list_for_each_entry(rt_entry, &routing_table[key], list) {
+	list_for_each_entry_rcu(rt_entry, &routing_table[key], list) {
 		if (rt_entry->node_id == node_id)
 			return rt_entry;
 	}
@@ -807,7 +820,7 @@ void msm_ipc_router_add_local_port(struct msm_ipc_port *port_ptr)
 
 	key = (port_ptr->this_port.port_id & (LP_HASH_SIZE - 1));
 	down_write(&local_ports_lock_lha2);
-	list_add_tail(&port_ptr->list, &local_ports[key]);
+	list_add_tail_rcu(&port_ptr->list, &local_ports[key]);
 	up_write(&local_ports_lock_lha2);
 }
 
@@ -853,7 +866,7 @@ static struct msm_ipc_port *msm_ipc_router_lookup_local_port(uint32_t port_id)
 	int key = (port_id & (LP_HASH_SIZE - 1));
 	struct msm_ipc_port *port_ptr;
 
-	list_for_each_entry(port_ptr, &local_ports[key], list) {
+	list_for_each_entry_rcu(port_ptr, &local_ports[key], list) {
 		if (port_ptr->this_port.port_id == port_id) {
 			return port_ptr;
 		}
@@ -875,15 +888,11 @@ static struct msm_ipc_router_remote_port *msm_ipc_router_lookup_remote_port(
 		return NULL;
 	}
 
-	down_read(&rt_entry->lock_lha4);
-	list_for_each_entry(rport_ptr,
-			    &rt_entry->remote_port_list[key], list) {
-		if (rport_ptr->port_id == port_id) {
-			up_read(&rt_entry->lock_lha4);
+	list_for_each_entry_rcu(rport_ptr,
+				&rt_entry->remote_port_list[key], list) {
+		if (rport_ptr->port_id == port_id)
 			return rport_ptr;
-		}
 	}
-	up_read(&rt_entry->lock_lha4);
 	return NULL;
 }
 
@@ -915,8 +924,8 @@ static struct msm_ipc_router_remote_port *msm_ipc_router_create_remote_port(
 	mutex_init(&rport_ptr->quota_lock_lhb2);
 	INIT_LIST_HEAD(&rport_ptr->resume_tx_port_list);
 	down_write(&rt_entry->lock_lha4);
-	list_add_tail(&rport_ptr->list,
-		      &rt_entry->remote_port_list[key]);
+	list_add_tail_rcu(&rport_ptr->list,
+			  &rt_entry->remote_port_list[key]);
 	up_write(&rt_entry->lock_lha4);
 	return rport_ptr;
 }
@@ -984,13 +993,18 @@ static void msm_ipc_router_destroy_remote_port(
 		return;
 	}
 	down_write(&rt_entry->lock_lha4);
-	list_del(&rport_ptr->list);
+	list_del_rcu(&rport_ptr->list);
 	up_write(&rt_entry->lock_lha4);
+	return;
+}
+
+static void msm_ipc_router_free_remote_port(
+	struct msm_ipc_router_remote_port *rport_ptr)
+{
 	mutex_lock(&rport_ptr->quota_lock_lhb2);
 	msm_ipc_router_free_resume_tx_port(rport_ptr);
 	mutex_unlock(&rport_ptr->quota_lock_lhb2);
 	kfree(rport_ptr);
-	return;
 }
 
 static struct msm_ipc_server *msm_ipc_router_lookup_server(
@@ -1342,14 +1356,15 @@ static int forward_msg(struct msm_ipc_router_xprt_info *xprt_info,
 	struct msm_ipc_routing_table_entry *rt_entry;
 	int ret = 0;
 	int fwd_xprt_option;
+	int idx;
 
 	if (!xprt_info || !pkt)
 		return -EINVAL;
 
 	hdr = &(pkt->hdr);
-	down_read(&routing_table_lock_lha3);
+	idx = srcu_read_lock(&ipc_router_srcu);
 	rt_entry = lookup_routing_table(hdr->dst_node_id);
-	if (!(rt_entry) || !(rt_entry->xprt_info)) {
+	if (!(rt_entry)) {
 		pr_err("%s: Routing table not initialized\n", __func__);
 		ret = -ENODEV;
 		goto fm_error1;
@@ -1357,6 +1372,11 @@ static int forward_msg(struct msm_ipc_router_xprt_info *xprt_info,
 
 	down_read(&rt_entry->lock_lha4);
 	fwd_xprt_info = rt_entry->xprt_info;
+	if (!fwd_xprt_info) {
+		pr_err("%s: Routing table not initialized\n", __func__);
+		ret = -ENODEV;
+		goto fm_error2;
+	}
 	ret = prepend_header(pkt, fwd_xprt_info);
 	if (ret < 0) {
 		pr_err("%s: Prepend Header failed\n", __func__);
@@ -1388,7 +1408,7 @@ fm_error3:
 fm_error2:
 	up_read(&rt_entry->lock_lha4);
 fm_error1:
-	up_read(&routing_table_lock_lha3);
+	srcu_read_unlock(&ipc_router_srcu, idx);
 
 	return ret;
 }
@@ -1480,19 +1500,14 @@ static void cleanup_rmt_server(struct msm_ipc_router_xprt_info *xprt_info,
 static void cleanup_rmt_ports(struct msm_ipc_router_xprt_info *xprt_info,
 			      struct msm_ipc_routing_table_entry *rt_entry)
 {
-	struct msm_ipc_router_remote_port *rport_ptr, *tmp_rport_ptr;
+	struct msm_ipc_router_remote_port *rport_ptr;
 	union rr_control_msg ctl;
 	int j;
 
 	memset(&ctl, 0, sizeof(ctl));
 	for (j = 0; j < RP_HASH_SIZE; j++) {
-		list_for_each_entry_safe(rport_ptr, tmp_rport_ptr,
+		list_for_each_entry(rport_ptr,
 				&rt_entry->remote_port_list[j], list) {
-			list_del(&rport_ptr->list);
-			mutex_lock(&rport_ptr->quota_lock_lhb2);
-			msm_ipc_router_free_resume_tx_port(rport_ptr);
-			mutex_unlock(&rport_ptr->quota_lock_lhb2);
-
 			if (rport_ptr->server)
 				cleanup_rmt_server(xprt_info, rport_ptr);
 
@@ -1501,16 +1516,32 @@ static void cleanup_rmt_ports(struct msm_ipc_router_xprt_info *xprt_info,
 			ctl.cli.port_id = rport_ptr->port_id;
 			relay_ctl_msg(xprt_info, &ctl);
 			broadcast_ctl_msg_locally(&ctl);
-			kfree(rport_ptr);
 		}
 	}
 }
 
+static void free_routing_table_entry(
+	struct msm_ipc_routing_table_entry *rt_entry)
+{
+	struct msm_ipc_router_remote_port *rport_ptr, *tmp_rport_ptr;
+	int j;
+
+	for (j = 0; j < RP_HASH_SIZE; j++) {
+		list_for_each_entry_safe(rport_ptr, tmp_rport_ptr,
+				&rt_entry->remote_port_list[j], list) {
+			list_del(&rport_ptr->list);
+			msm_ipc_router_free_remote_port(rport_ptr);
+		}
+	}
+	kfree(rt_entry);
+}
+
 static void msm_ipc_cleanup_routing_table(
 	struct msm_ipc_router_xprt_info *xprt_info)
 {
 	int i;
 	struct msm_ipc_routing_table_entry *rt_entry, *tmp_rt_entry;
+	LIST_HEAD(free_list);
 
 	if (!xprt_info) {
 		pr_err("%s: Invalid xprt_info\n", __func__);
@@ -1530,12 +1561,19 @@ static void msm_ipc_cleanup_routing_table(
 			cleanup_rmt_ports(xprt_info, rt_entry);
 			rt_entry->xprt_info = NULL;
 			up_write(&rt_entry->lock_lha4);
-			list_del(&rt_entry->list);
-			kfree(rt_entry);
+			list_del_rcu(&rt_entry->list);
+			list_add_tail(&rt_entry->free_list, &free_list);
 		}
 	}
 	up_write(&routing_table_lock_lha3);
 	up_write(&server_list_lock_lha2);
+
+	if (list_empty(&free_list))
+		return;
+
+	synchronize_srcu(&ipc_router_srcu);
+	list_for_each_entry_safe(rt_entry, tmp_rt_entry, &free_list, free_list)
+		free_routing_table_entry(rt_entry);
 }
 
 static void sync_sec_rule(struct msm_ipc_server *server, void *rule)
@@ -1665,11 +1703,11 @@ static int process_resume_tx_msg(union rr_control_msg *msg,
 {
 	struct msm_ipc_router_remote_port *rport_ptr;
 	int ret = 0;
+	int idx;
 
 	RR("o RESUME_TX id=%d:%08x\n", msg->cli.node_id, msg->cli.port_id);
 
-	down_read(&local_ports_lock_lha2);
-	down_read(&routing_table_lock_lha3);
+	idx = srcu_read_lock(&ipc_router_srcu);
 	rport_ptr = msm_ipc_router_lookup_remote_port(msg->cli.node_id,
 						      msg->cli.port_id);
 	if (!rport_ptr) {
@@ -1682,8 +1720,7 @@ static int process_resume_tx_msg(union rr_control_msg *msg,
 	post_resume_tx(rport_ptr, pkt);
 	mutex_unlock(&rport_ptr->quota_lock_lhb2);
 prtm_out:
-	up_read(&routing_table_lock_lha3);
-	up_read(&local_ports_lock_lha2);
+	srcu_read_unlock(&ipc_router_srcu, idx);
 	return 0;
 }
 
@@ -1789,6 +1826,11 @@ static int process_rmv_client_msg(struct msm_ipc_router_xprt_info *xprt_info,
 		msm_ipc_router_destroy_remote_port(rport_ptr);
 	up_write(&routing_table_lock_lha3);
 
+	if (rport_ptr) {
+		synchronize_srcu(&ipc_router_srcu);
+		msm_ipc_router_free_remote_port(rport_ptr);
+	}
+
 	relay_ctl_msg(xprt_info, msg);
 	post_control_ports(pkt);
 	return 0;
@@ -1849,6 +1891,7 @@ static void do_read_data(struct work_struct *work)
 	struct msm_ipc_port *port_ptr;
 	struct msm_ipc_router_remote_port *rport_ptr;
 	int ret;
+	int idx;
 
 	struct msm_ipc_router_xprt_info *xprt_info =
 		container_of(work,
@@ -1901,17 +1944,16 @@ static void do_read_data(struct work_struct *work)
 #endif
 #endif
 
-		down_read(&local_ports_lock_lha2);
+		idx = srcu_read_lock(&ipc_router_srcu);
 		port_ptr = msm_ipc_router_lookup_local_port(hdr->dst_port_id);
 		if (!port_ptr) {
 			pr_err("%s: No local port id %08x\n", __func__,
 				hdr->dst_port_id);
-			up_read(&local_ports_lock_lha2);
+			srcu_read_unlock(&ipc_router_srcu, idx);
 			release_pkt(pkt);
 			return;
 		}
 
-		down_read(&routing_table_lock_lha3);
 		rport_ptr = msm_ipc_router_lookup_remote_port(hdr->src_node_id,
 							hdr->src_port_id);
 		if (!rport_ptr) {
@@ -1922,15 +1964,13 @@ static void do_read_data(struct work_struct *work)
 				pr_err("%s: Rmt Prt %08x:%08x create failed\n",
 					__func__, hdr->src_node_id,
 					hdr->src_port_id);
-				up_read(&routing_table_lock_lha3);
-				up_read(&local_ports_lock_lha2);
+				srcu_read_unlock(&ipc_router_srcu, idx);
 				release_pkt(pkt);
 				return;
 			}
 		}
-		up_read(&routing_table_lock_lha3);
 		post_pkt_to_port(port_ptr, pkt, 0);
-		up_read(&local_ports_lock_lha2);
+		srcu_read_unlock(&ipc_router_srcu, idx);
 	}
 	return;
 
@@ -2049,6 +2089,7 @@ static int loopback_data(struct msm_ipc_port *src,
 	struct msm_ipc_port *port_ptr;
 	struct rr_packet *pkt;
 	int ret_len;
+	int idx;
 
 	if (!data) {
 		pr_err("%s: Invalid pkt pointer\n", __func__);
@@ -2070,11 +2111,11 @@ static int loopback_data(struct msm_ipc_port *src,
 	hdr->dst_node_id = IPC_ROUTER_NID_LOCAL;
 	hdr->dst_port_id = port_id;
 
-	down_read(&local_ports_lock_lha2);
+	idx = srcu_read_lock(&ipc_router_srcu);
 	port_ptr = msm_ipc_router_lookup_local_port(port_id);
 	if (!port_ptr) {
 		pr_err("%s: Local port %d not present\n", __func__, port_id);
-		up_read(&local_ports_lock_lha2);
+		srcu_read_unlock(&ipc_router_srcu, idx);
 		pkt->pkt_fragment_q = NULL;
 		release_pkt(pkt);
 		return -ENODEV;
@@ -2083,7 +2124,7 @@ static int loopback_data(struct msm_ipc_port *src,
 	ret_len = pkt->length;
 	post_pkt_to_port(port_ptr, pkt, 0);
 	update_comm_mode_info(&src->mode_info, NULL);
-	up_read(&local_ports_lock_lha2);
+	srcu_read_unlock(&ipc_router_srcu, idx);
 
 	return ret_len;
 }
@@ -2143,13 +2184,19 @@ static int msm_ipc_router_write_pkt(struct msm_ipc_port *src,
 	mutex_unlock(&rport_ptr->quota_lock_lhb2);
 
 	rt_entry = lookup_routing_table(hdr->dst_node_id);
-	if (!rt_entry || !rt_entry->xprt_info) {
+	if (!rt_entry) {
 		pr_err("%s: Remote node %d not up\n",
 			__func__, hdr->dst_node_id);
 		return -ENODEV;
 	}
 	down_read(&rt_entry->lock_lha4);
 	xprt_info = rt_entry->xprt_info;
+	if (!xprt_info) {
+		up_read(&rt_entry->lock_lha4);
+		pr_err("%s: Remote node %d not up\n",
+			__func__, hdr->dst_node_id);
+		return -ENODEV;
+	}
 	ret = prepend_header(pkt, xprt_info);
 	if (ret < 0) {
 		up_read(&rt_entry->lock_lha4);
@@ -2217,6 +2264,7 @@ int msm_ipc_router_send_to(struct msm_ipc_port *src,
 	struct msm_ipc_router_remote_port *rport_ptr = NULL;
 	struct rr_packet *pkt;
 	int ret;
+	int idx;
 
 	if (!src || !data || !dest) {
 		pr_err("%s: Invalid Parameters\n", __func__);
@@ -2250,11 +2298,11 @@ int msm_ipc_router_send_to(struct msm_ipc_port *src,
 		return ret;
 	}
 
-	down_read(&routing_table_lock_lha3);
+	idx = srcu_read_lock(&ipc_router_srcu);
 	rport_ptr = msm_ipc_router_lookup_remote_port(dst_node_id,
 						      dst_port_id);
 	if (!rport_ptr) {
-		up_read(&routing_table_lock_lha3);
+		srcu_read_unlock(&ipc_router_srcu, idx);
 		pr_err("%s: Remote port not found\n", __func__);
 		return -ENODEV;
 	}
@@ -2262,7 +2310,7 @@ int msm_ipc_router_send_to(struct msm_ipc_port *src,
 	if (src->check_send_permissions) {
 		ret = src->check_send_permissions(rport_ptr->sec_rule);
 		if (ret <= 0) {
-			up_read(&routing_table_lock_lha3);
+			srcu_read_unlock(&ipc_router_srcu, idx);
 			pr_err("%s: permission failure for %s\n",
 				__func__, current->comm);
 			return -EPERM;
@@ -2271,13 +2319,13 @@ int msm_ipc_router_send_to(struct msm_ipc_port *src,
 
 	pkt = create_pkt(data);
 	if (!pkt) {
-		up_read(&routing_table_lock_lha3);
+		srcu_read_unlock(&ipc_router_srcu, idx);
 		pr_err("%s: Pkt creation failed\n", __func__);
 		return -ENOMEM;
 	}
 
 	ret = msm_ipc_router_write_pkt(src, rport_ptr, pkt);
-	up_read(&routing_table_lock_lha3);
+	srcu_read_unlock(&ipc_router_srcu, idx);
 	if (ret < 0)
 		pkt->pkt_fragment_q = NULL;
 	release_pkt(pkt);
@@ -2315,24 +2363,27 @@ static int msm_ipc_router_send_resume_tx(void *data)
 	struct rr_header_v1 *hdr = (struct rr_header_v1 *)data;
 	struct msm_ipc_routing_table_entry *rt_entry;
 	int ret;
+	int idx;
 
 	memset(&msg, 0, sizeof(msg));
 	msg.cmd = IPC_ROUTER_CTRL_CMD_RESUME_TX;
 	msg.cli.node_id = hdr->dst_node_id;
 	msg.cli.port_id = hdr->dst_port_id;
-	down_read(&routing_table_lock_lha3);
+	idx = srcu_read_lock(&ipc_router_srcu);
 	rt_entry = lookup_routing_table(hdr->src_node_id);
 	if (!rt_entry) {
 		pr_err("%s: %d Node is not present",
 				__func__, hdr->src_node_id);
-		up_read(&routing_table_lock_lha3);
+		srcu_read_unlock(&ipc_router_srcu, idx);
 		return -ENODEV;
 	}
 	RR("x RESUME_TX id=%d:%08x\n",
 			msg.cli.node_id, msg.cli.port_id);
+	down_read(&rt_entry->lock_lha4);
 	ret = msm_ipc_router_send_control_msg(rt_entry->xprt_info, &msg,
 						hdr->src_node_id);
-	up_read(&routing_table_lock_lha3);
+	up_read(&rt_entry->lock_lha4);
+	srcu_read_unlock(&ipc_router_srcu, idx);
 	if (ret < 0)
 		pr_err("%s: Send Resume_Tx Failed SRC_NODE: %d SRC_PORT: %d DEST_NODE: %d",
 			__func__, hdr->dst_node_id, hdr->dst_port_id,
@@ -2498,8 +2549,9 @@ int msm_ipc_router_close_port(struct msm_ipc_port *port_ptr)
 
 	if (port_ptr->type == SERVER_PORT || port_ptr->type == CLIENT_PORT) {
 		down_write(&local_ports_lock_lha2);
-		list_del(&port_ptr->list);
+		list_del_rcu(&port_ptr->list);
 		up_write(&local_ports_lock_lha2);
+		synchronize_srcu(&ipc_router_srcu);
 
 		if (port_ptr->type == SERVER_PORT) {
 			memset(&msg, 0, sizeof(msg));
@@ -2526,8 +2578,9 @@ int msm_ipc_router_close_port(struct msm_ipc_port *port_ptr)
 		up_write(&control_ports_lock_lha5);
 	} else if (port_ptr->type == IRSC_PORT) {
 		down_write(&local_ports_lock_lha2);
-		list_del(&port_ptr->list);
+		list_del_rcu(&port_ptr->list);
 		up_write(&local_ports_lock_lha2);
+		synchronize_srcu(&ipc_router_srcu);
 		signal_irsc_completion();
 	}
 
@@ -2582,8 +2635,9 @@ int msm_ipc_router_bind_control_port(struct msm_ipc_port *port_ptr)
 		return -EINVAL;
 
 	down_write(&local_ports_lock_lha2);
-	list_del(&port_ptr->list);
+	list_del_rcu(&port_ptr->list);
 	up_write(&local_ports_lock_lha2);
+	synchronize_srcu(&ipc_router_srcu);
 	port_ptr->type = CONTROL_PORT;
 	down_write(&control_ports_lock_lha5);
 	list_add_tail(&port_ptr->list, &control_ports);
@@ -2824,6 +2878,63 @@ static int dump_local_ports(char *buf, int max)
 	return i;
 }
 
+#define LOOPBACK_BENCH_ITER 1000
+static const unsigned int loopback_bench_sizes[] = { 64, 512, 4096 };
+
+static int loopback_bench(char *buf, int max)
+{
+	int i = 0, j, n, ret;
+	struct msm_ipc_port *src, *dst;
+	struct msm_ipc_addr dest;
+	unsigned char *data, *rx_data;
+	unsigned int size, rx_len;
+	ktime_t start;
+	s64 ns;
+
+	src = msm_ipc_router_create_raw_port(NULL, NULL, NULL);
+	dst = msm_ipc_router_create_raw_port(NULL, NULL, NULL);
+	if (!src || !dst) {
+		i += scnprintf(buf + i, max - i, "Port create failed\n");
+		goto out;
+	}
+
+	dest.addrtype = MSM_IPC_ADDR_ID;
+	dest.addr.port_addr.node_id = IPC_ROUTER_NID_LOCAL;
+	dest.addr.port_addr.port_id = dst->this_port.port_id;
+
+	for (j = 0; j < ARRAY_SIZE(loopback_bench_sizes); j++) {
+		size = loopback_bench_sizes[j];
+		data = kzalloc(size, GFP_KERNEL);
+		if (!data)
+			break;
+
+		start = ktime_get();
+		for (n = 0; n < LOOPBACK_BENCH_ITER; n++) {
+			ret = msm_ipc_router_send_msg(src, &dest, data, size);
+			if (ret < 0)
+				break;
+			ret = msm_ipc_router_read_msg(dst, NULL,
+						      &rx_data, &rx_len);
+			if (ret < 0)
+				break;
+			kfree(rx_data);
+		}
+		ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+		kfree(data);
+
+		i += scnprintf(buf + i, max - i,
+			       "%u bytes: %d msgs, %lld ns/msg\n",
+			       size, n, n ? div_s64(ns, n) : 0);
+	}
+
+out:
+	if (src)
+		msm_ipc_router_close_port(src);
+	if (dst)
+		msm_ipc_router_close_port(dst);
+	return i;
+}
+
 #define DEBUG_BUFMAX 4096
 static char debug_buffer[DEBUG_BUFMAX];
 
@@ -2873,6 +2984,8 @@ static void debugfs_init(void)
 		      dump_xprt_info);
 	debug_create("dump_routing_table", 0444, dent,
 		      dump_routing_table);
+	debug_create("loopback_bench", 0400, dent,
+		      loopback_bench);
 }
 
 #else
@@ -3053,6 +3166,10 @@ static int __init msm_ipc_router_init(void)
 	int i, ret;
 	struct msm_ipc_routing_table_entry *rt_entry;
 
+	ret = init_srcu_struct(&ipc_router_srcu);
+	if (ret < 0)
+		return ret;
+
 	msm_ipc_router_debug_mask |= SMEM_LOG;
 	ipc_rtr_log_ctxt = ipc_log_context_create(IPC_RTR_LOG_PAGES,
 						  "ipc_router");
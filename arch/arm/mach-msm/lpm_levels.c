@@ -23,6 +23,7 @@
 #include <linux/ktime.h>
 #include <linux/tick.h>
 #include <linux/suspend.h>
+#include <linux/sched.h>
 #include <linux/pm_qos.h>
 #include <linux/of_platform.h>
 #include <mach/mpm.h>
@@ -705,6 +706,7 @@ static void lpm_enter_low_power(struct lpm_system_state *system_state,
 {
 	int idx;
 	struct lpm_cpu_level *cpu_level = &system_state->cpu_level[cpu_index];
+	uint32_t latency_us;
 
 	cpu_level = &system_state->cpu_level[cpu_index];
 
@@ -712,6 +714,14 @@ static void lpm_enter_low_power(struct lpm_system_state *system_state,
 
 	idx = lpm_system_select(system_state, cpu_index, from_idle);
 
+	if (from_idle) {
+		latency_us = cpu_level->pwr.latency_us;
+		if (idx >= 0)
+			latency_us = max(latency_us,
+				system_state->system_level[idx].pwr.latency_us);
+		sched_set_idle_exit_latency(latency_us);
+	}
+
 	lpm_system_prepare(system_state, idx, from_idle);
 
 	msm_cpu_pm_enter_sleep(cpu_level->mode, from_idle);
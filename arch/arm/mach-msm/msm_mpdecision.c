@@ -33,6 +33,10 @@
 #include <linux/cpufreq.h>
 #include <linux/sched.h>
 #include <linux/rq_stats.h>
+#include <linux/input.h>
+#include <linux/seq_file.h>
+#include <linux/log2.h>
+#include <mach/perflock.h>
 #include <asm/atomic.h>
 #include <asm/page.h>
 #include <mach/msm_dcvs.h>
@@ -43,6 +47,8 @@
 #define DEFAULT_RQ_AVG_POLL_MS    (1)
 #define DEFAULT_RQ_AVG_DIVIDE    (25)
 
+#define HP_LAT_BUCKETS		(16)
+
 struct mpd_attrib {
 	struct kobj_attribute	enabled;
 	struct kobj_attribute	rq_avg_poll_ms;
@@ -99,9 +105,15 @@ struct hp_latency {
 	int hp_dw_max_ms;
 	int hp_dw_ms;
 	int hp_dw_count;
+	unsigned int hp_up_hist[HP_LAT_BUCKETS];
+	unsigned int hp_dw_hist[HP_LAT_BUCKETS];
+};
+
+enum {
+	MSM_MPD_POLICY_TZ = 0,
+	MSM_MPD_POLICY_KERNEL = 1,
 };
 
-static DEFINE_PER_CPU(struct hrtimer, rq_avg_poll_timer);
 static DEFINE_SPINLOCK(rq_avg_lock);
 
 enum {
@@ -119,6 +131,32 @@ enum {
 static int msm_mpd_enabled = 1;
 module_param_named(enabled, msm_mpd_enabled, int, S_IRUGO | S_IWUSR | S_IWGRP);
 
+static int msm_mpd_policy = MSM_MPD_POLICY_TZ;
+module_param_named(policy, msm_mpd_policy, int, S_IRUGO | S_IWUSR);
+
+static unsigned int nr_run_thresholds[NR_CPUS] = {
+	[0 ... NR_CPUS - 1] = UINT_MAX,
+	[0] = 150, [1] = 250, [2] = 350,
+};
+static unsigned int nr_run_thresholds_count;
+module_param_array(nr_run_thresholds, uint, &nr_run_thresholds_count,
+		   S_IRUGO | S_IWUSR);
+
+static unsigned int nr_run_hysteresis = 50;
+module_param(nr_run_hysteresis, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int min_online_ms = 200;
+module_param(min_online_ms, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int boost_cpus = 2;
+module_param(boost_cpus, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int input_boost_ms = 500;
+module_param(input_boost_ms, uint, S_IRUGO | S_IWUSR);
+
+static DEFINE_PER_CPU(ktime_t, online_since);
+static unsigned long input_boost_until;
+
 static struct dentry *debugfs_base;
 static struct mpdecision msm_mpd;
 
@@ -138,18 +176,58 @@ static bool ok_to_update_tz(int nr, int last_nr)
 		&& (msm_mpd.hpupdate != HPUPDATE_IN_PROGRESS)));
 }
 
-static enum hrtimer_restart msm_mpd_rq_avg_poll_timer(struct hrtimer *timer)
+static unsigned int msm_mpd_kernel_decide(int nr)
+{
+	unsigned int cur = num_online_cpus();
+	unsigned int need = cur, floor = 1;
+
+	if (cur < num_present_cpus() &&
+	    nr > nr_run_thresholds[cur - 1])
+		need = cur + 1;
+	else if (cur > 1 &&
+		 nr + nr_run_hysteresis < nr_run_thresholds[cur - 2])
+		need = cur - 1;
+
+	if (time_before(jiffies, input_boost_until) || is_perf_locked())
+		floor = boost_cpus;
+
+	need = clamp(need, floor, num_present_cpus());
+	return need;
+}
+
+static void msm_mpd_kernel_update(int nr)
+{
+	unsigned int need = msm_mpd_kernel_decide(nr);
+	uint32_t mask = 0, online = 0;
+	int cpu;
+
+	for_each_present_cpu(cpu) {
+		if (need) {
+			mask |= 1 << cpu;
+			need--;
+		}
+		if (cpu_online(cpu))
+			online |= 1 << cpu;
+	}
+
+	if (mask == atomic_read(&msm_mpd.algo_cpu_mask) && mask == online)
+		return;
+
+	trace_msm_mp_cpusonline("cpu_online_mp", mask);
+	atomic_set(&msm_mpd.algo_cpu_mask, mask);
+	msm_mpd.hpupdate = HPUPDATE_SCHEDULED;
+	wake_up(&msm_mpd.wait_hpq);
+}
+
+static int msm_mpd_rq_avg_notify(struct notifier_block *nb,
+				 unsigned long avg, void *data)
 {
-	int nr, nr_iowait;
+	int nr = (int)avg;
+	int nr_iowait = *(int *)data;
 	ktime_t curr_time = ktime_get();
 	unsigned long flags;
-	int cpu = smp_processor_id();
-	enum hrtimer_restart restart = HRTIMER_RESTART;
 
 	spin_lock_irqsave(&rq_avg_lock, flags);
-	
-	if (&per_cpu(rq_avg_poll_timer, cpu) != timer)
-		restart = HRTIMER_NORESTART;
 
 	if (ktime_to_ns(ktime_sub(curr_time, msm_mpd.next_update)) < 0)
 		goto out;
@@ -157,8 +235,6 @@ static enum hrtimer_restart msm_mpd_rq_avg_poll_timer(struct hrtimer *timer)
 	msm_mpd.next_update = ktime_add_ns(curr_time,
 			(msm_mpd.rq_avg_poll_ms * NSEC_PER_MSEC));
 
-	sched_get_nr_running_avg(&nr, &nr_iowait);
-
 	if ((nr_iowait >= msm_mpd.iowait_threshold_pct) && (nr < last_nr))
 		nr = last_nr;
 
@@ -167,7 +243,11 @@ static enum hrtimer_restart msm_mpd_rq_avg_poll_timer(struct hrtimer *timer)
 
 	trace_msm_mp_runq("nr_running", nr);
 
-	if (ok_to_update_tz(nr, last_nr)) {
+	if (msm_mpd_policy == MSM_MPD_POLICY_KERNEL) {
+		if (msm_mpd.hpupdate != HPUPDATE_IN_PROGRESS)
+			msm_mpd_kernel_update(nr);
+		last_nr = nr;
+	} else if (ok_to_update_tz(nr, last_nr)) {
 		hrtimer_try_to_cancel(&msm_mpd.slack_timer);
 		msm_mpd.data.nr = nr;
 		msm_mpd.data.event = MSM_DCVS_SCM_RUNQ_UPDATE;
@@ -176,28 +256,47 @@ static enum hrtimer_restart msm_mpd_rq_avg_poll_timer(struct hrtimer *timer)
 	}
 
 out:
-	hrtimer_set_expires(timer, msm_mpd.next_update);
 	spin_unlock_irqrestore(&rq_avg_lock, flags);
-	
-	return restart;
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block msm_mpd_rq_avg_nb = {
+	.notifier_call = msm_mpd_rq_avg_notify,
+};
+
+static void hp_latency_account(unsigned int *hist, s64 time_taken_us)
+{
+	int bucket = 0;
+
+	if (time_taken_us > 1)
+		bucket = min_t(int, ilog2(time_taken_us), HP_LAT_BUCKETS - 1);
+	hist[bucket]++;
 }
 
 static void bring_up_cpu(int cpu)
 {
-	int cpu_action_time_ms;
+	ktime_t cpu_action_time, now;
+	s64 time_taken_us;
 	int time_taken_ms;
 	int ret, ret1, ret2;
 
-	cpu_action_time_ms = ktime_to_ms(ktime_get());
+	cpu_action_time = ktime_get();
 	ret = cpu_up(cpu);
 	if (ret) {
 		pr_debug("Error %d online core %d\n", ret, cpu);
 	} else {
-		time_taken_ms = ktime_to_ms(ktime_get()) - cpu_action_time_ms;
+		now = ktime_get();
+		per_cpu(online_since, cpu) = now;
+		time_taken_us = ktime_us_delta(now, cpu_action_time);
+		time_taken_ms = (int)div_s64(time_taken_us, USEC_PER_MSEC);
+		hp_latency_account(hp_latencies.hp_up_hist, time_taken_us);
 		if (time_taken_ms > hp_latencies.hp_up_max_ms)
 			hp_latencies.hp_up_max_ms = time_taken_ms;
 		hp_latencies.hp_up_ms += time_taken_ms;
 		hp_latencies.hp_up_count++;
+		if (msm_mpd_policy == MSM_MPD_POLICY_KERNEL)
+			return;
 		ret = msm_dcvs_scm_event(
 				CPU_OFFSET + cpu,
 				MSM_DCVS_SCM_CORE_ONLINE,
@@ -211,21 +310,26 @@ static void bring_up_cpu(int cpu)
 
 static void bring_down_cpu(int cpu)
 {
-	int cpu_action_time_ms;
+	ktime_t cpu_action_time;
+	s64 time_taken_us;
 	int time_taken_ms;
 	int ret, ret1, ret2;
 
 	BUG_ON(cpu == 0);
-	cpu_action_time_ms = ktime_to_ms(ktime_get());
+	cpu_action_time = ktime_get();
 	ret = cpu_down(cpu);
 	if (ret) {
 		pr_debug("Error %d offline" "core %d\n", ret, cpu);
 	} else {
-		time_taken_ms = ktime_to_ms(ktime_get()) - cpu_action_time_ms;
+		time_taken_us = ktime_us_delta(ktime_get(), cpu_action_time);
+		time_taken_ms = (int)div_s64(time_taken_us, USEC_PER_MSEC);
+		hp_latency_account(hp_latencies.hp_dw_hist, time_taken_us);
 		if (time_taken_ms > hp_latencies.hp_dw_max_ms)
 			hp_latencies.hp_dw_max_ms = time_taken_ms;
 		hp_latencies.hp_dw_ms += time_taken_ms;
 		hp_latencies.hp_dw_count++;
+		if (msm_mpd_policy == MSM_MPD_POLICY_KERNEL)
+			return;
 		ret = msm_dcvs_scm_event(
 				CPU_OFFSET + cpu,
 				MSM_DCVS_SCM_CORE_OFFLINE,
@@ -295,59 +399,15 @@ out:
 	return HRTIMER_NORESTART;
 }
 
-static int msm_mpd_idle_notifier(struct notifier_block *self,
-				 unsigned long cmd, void *v)
+static bool msm_mpd_can_bring_down(int cpu)
 {
-	int cpu = smp_processor_id();
-	unsigned long flags;
+	if (msm_mpd_policy != MSM_MPD_POLICY_KERNEL)
+		return true;
 
-	switch (cmd) {
-	case CPU_PM_EXIT:
-		spin_lock_irqsave(&rq_avg_lock, flags);
-		hrtimer_start(&per_cpu(rq_avg_poll_timer, cpu),
-			      msm_mpd.next_update,
-			      HRTIMER_MODE_ABS_PINNED);
-		spin_unlock_irqrestore(&rq_avg_lock, flags);
-		break;
-	case CPU_PM_ENTER:
-		hrtimer_cancel(&per_cpu(rq_avg_poll_timer, cpu));
-		break;
-	default:
-		break;
-	}
-
-	return NOTIFY_OK;
-}
-
-static int msm_mpd_hotplug_notifier(struct notifier_block *self,
-				    unsigned long action, void *hcpu)
-{
-	int cpu = (int)hcpu;
-	unsigned long flags;
-
-	switch (action & (~CPU_TASKS_FROZEN)) {
-	case CPU_STARTING:
-		spin_lock_irqsave(&rq_avg_lock, flags);
-		hrtimer_start(&per_cpu(rq_avg_poll_timer, cpu),
-			      msm_mpd.next_update,
-			      HRTIMER_MODE_ABS_PINNED);
-		spin_unlock_irqrestore(&rq_avg_lock, flags);
-		break;
-	default:
-		break;
-	}
-
-	return NOTIFY_OK;
+	return ktime_to_ms(ktime_sub(ktime_get(),
+			per_cpu(online_since, cpu))) >= min_online_ms;
 }
 
-static struct notifier_block msm_mpd_idle_nb = {
-	.notifier_call = msm_mpd_idle_notifier,
-};
-
-static struct notifier_block msm_mpd_hotplug_nb = {
-	.notifier_call = msm_mpd_hotplug_notifier,
-};
-
 static int __cpuinit msm_mpd_do_hotplug(void *data)
 {
 	int *event = (int *)data;
@@ -374,7 +434,8 @@ restart:
 		    100 * NSEC_PER_MSEC)
 			for_each_possible_cpu(cpu)
 				if (!(atomic_read(&msm_mpd.algo_cpu_mask) &
-				      (1 << cpu)) && cpu_online(cpu)) {
+				      (1 << cpu)) && cpu_online(cpu) &&
+				    msm_mpd_can_bring_down(cpu)) {
 					bring_down_cpu(cpu);
 					last_down_time = ktime_get();
 					break;
@@ -414,6 +475,122 @@ static int msm_mpd_do_update_scm(void *data)
 	return 0;
 }
 
+static void msm_mpd_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	unsigned long flags;
+
+	if (msm_mpd_policy != MSM_MPD_POLICY_KERNEL || !input_boost_ms)
+		return;
+
+	input_boost_until = jiffies + msecs_to_jiffies(input_boost_ms);
+	if (num_online_cpus() >= boost_cpus)
+		return;
+
+	spin_lock_irqsave(&rq_avg_lock, flags);
+	if (msm_mpd.hpupdate != HPUPDATE_IN_PROGRESS)
+		msm_mpd_kernel_update(last_nr);
+	spin_unlock_irqrestore(&rq_avg_lock, flags);
+}
+
+static int msm_mpd_input_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "msm_mpdecision";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err2;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err1;
+
+	return 0;
+err1:
+	input_unregister_handle(handle);
+err2:
+	kfree(handle);
+	return error;
+}
+
+static void msm_mpd_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id msm_mpd_input_ids[] = {
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			BIT_MASK(ABS_MT_POSITION_X) |
+			BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	{ },
+};
+
+static struct input_handler msm_mpd_input_handler = {
+	.event		= msm_mpd_input_event,
+	.connect	= msm_mpd_input_connect,
+	.disconnect	= msm_mpd_input_disconnect,
+	.name		= "msm_mpdecision",
+	.id_table	= msm_mpd_input_ids,
+};
+
+static void msm_mpd_show_hist(struct seq_file *m, const char *name,
+			      unsigned int *hist)
+{
+	int i;
+
+	seq_printf(m, "%s:\n", name);
+	for (i = 0; i < HP_LAT_BUCKETS; i++)
+		seq_printf(m, "  %s%7luus: %u\n",
+			   i == HP_LAT_BUCKETS - 1 ? ">=" : "< ",
+			   i == HP_LAT_BUCKETS - 1 ? 1UL << i : 2UL << i,
+			   hist[i]);
+}
+
+static int msm_mpd_hp_latency_show(struct seq_file *m, void *unused)
+{
+	seq_printf(m, "policy: %s\n",
+		   msm_mpd_policy == MSM_MPD_POLICY_KERNEL ? "kernel" : "tz");
+	msm_mpd_show_hist(m, "online", hp_latencies.hp_up_hist);
+	msm_mpd_show_hist(m, "offline", hp_latencies.hp_dw_hist);
+	return 0;
+}
+
+static int msm_mpd_hp_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_mpd_hp_latency_show, inode->i_private);
+}
+
+static const struct file_operations msm_mpd_hp_latency_fops = {
+	.open		= msm_mpd_hp_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int __ref msm_mpd_set_enabled(uint32_t enable)
 {
 	int ret = 0;
@@ -426,6 +603,14 @@ static int __ref msm_mpd_set_enabled(uint32_t enable)
 	if (last_enable == enable)
 		return ret;
 
+	if (msm_mpd_policy == MSM_MPD_POLICY_KERNEL) {
+		last_enable = enable;
+		last_nr = 0;
+		for_each_online_cpu(cpu)
+			per_cpu(online_since, cpu) = ktime_get();
+		goto start;
+	}
+
 	if (enable) {
 		ret = msm_mpd_scm_set_algo_params(&msm_mpd.mp_param);
 		if (ret) {
@@ -444,6 +629,7 @@ static int __ref msm_mpd_set_enabled(uint32_t enable)
 		last_enable = enable;
 		last_nr = 0;
 	}
+start:
 	if (enable) {
 		msm_mpd.next_update = ktime_add_ns(ktime_get(),
 				(msm_mpd.rq_avg_poll_ms * NSEC_PER_MSEC));
@@ -457,20 +643,12 @@ static int __ref msm_mpd_set_enabled(uint32_t enable)
 		if (IS_ERR(msm_mpd.hptask))
 			return -EFAULT;
 
-		for_each_online_cpu(cpu)
-			hrtimer_start(&per_cpu(rq_avg_poll_timer, cpu),
-				      msm_mpd.next_update,
-				      HRTIMER_MODE_ABS_PINNED);
-		cpu_pm_register_notifier(&msm_mpd_idle_nb);
-		register_cpu_notifier(&msm_mpd_hotplug_nb);
+		sched_register_nr_running_avg_notifier(&msm_mpd_rq_avg_nb);
 		msm_mpd.enabled = 1;
 	} else {
-		for_each_online_cpu(cpu)
-			hrtimer_cancel(&per_cpu(rq_avg_poll_timer, cpu));
+		sched_unregister_nr_running_avg_notifier(&msm_mpd_rq_avg_nb);
 		kthread_stop(msm_mpd.hptask);
 		kthread_stop(msm_mpd.task);
-		cpu_pm_unregister_notifier(&msm_mpd_idle_nb);
-		unregister_cpu_notifier(&msm_mpd_hotplug_nb);
 		msm_mpd.enabled = 0;
 	}
 
@@ -649,6 +827,17 @@ static int __devinit msm_mpd_probe(struct platform_device *pdev)
 		goto done;
 	}
 
+	if (!debugfs_create_file("hotplug_latency", S_IRUGO, debugfs_base,
+				 NULL, &msm_mpd_hp_latency_fops)) {
+		pr_err("Cannot create debugfs hotplug_latency\n");
+		ret = -ENOENT;
+		goto done;
+	}
+
+	ret = input_register_handler(&msm_mpd_input_handler);
+	if (ret)
+		pr_err("Unable to register input handler: %d\n", ret);
+
 done:
 	if (ret && debugfs_base)
 		debugfs_remove(debugfs_base);
@@ -674,7 +863,6 @@ static struct platform_driver msm_mpd_driver = {
 
 static int __init msm_mpdecision_init(void)
 {
-	int cpu;
 	if (!msm_mpd_enabled) {
 		pr_info("Not enabled\n");
 		return 0;
@@ -686,12 +874,6 @@ static int __init msm_mpdecision_init(void)
 			HRTIMER_MODE_REL_PINNED);
 	msm_mpd.slack_timer.function = msm_mpd_slack_timer;
 
-	for_each_possible_cpu(cpu) {
-		hrtimer_init(&per_cpu(rq_avg_poll_timer, cpu),
-			     CLOCK_MONOTONIC, HRTIMER_MODE_ABS_PINNED);
-		per_cpu(rq_avg_poll_timer, cpu).function
-				= msm_mpd_rq_avg_poll_timer;
-	}
 	mutex_init(&msm_mpd.lock);
 	init_waitqueue_head(&msm_mpd.wait_q);
 	init_waitqueue_head(&msm_mpd.wait_hpq);
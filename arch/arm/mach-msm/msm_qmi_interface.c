@@ -120,6 +120,19 @@ static void init_msm_qmi(void)
 	mutex_unlock(&msm_qmi_init_lock);
 }
 
+static void qmi_txn_link(struct qmi_handle *handle, struct qmi_txn *txn)
+{
+	list_add_tail(&txn->list, &handle->txn_list);
+	hlist_add_head(&txn->hash,
+		&handle->txn_hash[txn->txn_id & (QMI_TXN_HASH_SIZE - 1)]);
+}
+
+static void qmi_txn_unlink(struct qmi_txn *txn)
+{
+	list_del(&txn->list);
+	hlist_del_init(&txn->hash);
+}
+
 static void handle_resume_tx(struct work_struct *work)
 {
 	struct delayed_work *rtx_work = to_delayed_work(work);
@@ -161,7 +174,7 @@ static void handle_resume_tx(struct work_struct *work)
 			}
 		} else {
 			list_del(&pend_txn->list);
-			list_add_tail(&pend_txn->list, &handle->txn_list);
+			qmi_txn_link(handle, pend_txn);
 		}
 	}
 	mutex_unlock(&handle->handle_lock);
@@ -174,6 +187,7 @@ struct qmi_handle *qmi_handle_create(
 {
 	struct qmi_handle *temp_handle;
 	struct msm_ipc_port *port_ptr;
+	int i;
 
 	temp_handle = kzalloc(sizeof(struct qmi_handle), GFP_KERNEL);
 	if (!temp_handle) {
@@ -192,6 +206,8 @@ struct qmi_handle *qmi_handle_create(
 	temp_handle->src_port = port_ptr;
 	temp_handle->next_txn_id = 1;
 	INIT_LIST_HEAD(&temp_handle->txn_list);
+	for (i = 0; i < QMI_TXN_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&temp_handle->txn_hash[i]);
 	INIT_LIST_HEAD(&temp_handle->pending_txn_list);
 	mutex_init(&temp_handle->handle_lock);
 	spin_lock_init(&temp_handle->notify_lock);
@@ -228,7 +244,7 @@ static void clean_txn_info(struct qmi_handle *handle)
 	list_for_each_entry_safe(txn_handle, temp_txn_handle,
 				 &handle->txn_list, list) {
 		if (txn_handle->type == QMI_ASYNC_TXN) {
-			list_del(&txn_handle->list);
+			qmi_txn_unlink(txn_handle);
 			kfree(txn_handle);
 		} else if (txn_handle->type == QMI_SYNC_TXN) {
 			wake_up(&txn_handle->wait_q);
@@ -313,6 +329,7 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 	}
 	txn_handle->type = type;
 	INIT_LIST_HEAD(&txn_handle->list);
+	INIT_HLIST_NODE(&txn_handle->hash);
 	init_waitqueue_head(&txn_handle->wait_q);
 
 	
@@ -357,7 +374,7 @@ static int qmi_encode_and_send_req(struct qmi_txn **ret_txn_handle,
 		goto append_pend_txn;
 	}
 
-	list_add_tail(&txn_handle->list, &handle->txn_list);
+	qmi_txn_link(handle, txn_handle);
 	
 	rc = msm_ipc_router_send_msg((struct msm_ipc_port *)(handle->src_port),
 		(struct msm_ipc_addr *)handle->dest_info,
@@ -367,7 +384,7 @@ append_pend_txn:
 		txn_handle->enc_data = encoded_req;
 		txn_handle->enc_data_len = encoded_req_len;
 		if (list_empty(&handle->pending_txn_list))
-			list_del(&txn_handle->list);
+			qmi_txn_unlink(txn_handle);
 		list_add_tail(&txn_handle->list, &handle->pending_txn_list);
 		if (ret_txn_handle)
 			*ret_txn_handle = txn_handle;
@@ -386,7 +403,7 @@ append_pend_txn:
 	return 0;
 
 encode_and_send_req_err3:
-	list_del(&txn_handle->list);
+	qmi_txn_unlink(txn_handle);
 encode_and_send_req_err2:
 	kfree(encoded_req);
 encode_and_send_req_err1:
@@ -449,7 +466,7 @@ int qmi_send_req_wait(struct qmi_handle *handle,
 	rc = 0;
 
 send_req_wait_err:
-	list_del(&txn_handle->list);
+	qmi_txn_unlink(txn_handle);
 	kfree(txn_handle);
 	mutex_unlock(&handle->handle_lock);
 	wake_up(&handle->reset_waitq);
@@ -478,8 +495,10 @@ static struct qmi_txn *find_txn_handle(struct qmi_handle *handle,
 				       uint16_t txn_id)
 {
 	struct qmi_txn *txn_handle;
+	struct hlist_node *pos;
 
-	list_for_each_entry(txn_handle, &handle->txn_list, list) {
+	hlist_for_each_entry(txn_handle, pos,
+		&handle->txn_hash[txn_id & (QMI_TXN_HASH_SIZE - 1)], hash) {
 		if (txn_handle->txn_id == txn_id)
 			return txn_handle;
 	}
@@ -509,7 +528,7 @@ static int handle_qmi_response(struct qmi_handle *handle,
 			__func__, txn_id, msg_id, msg_len, rc);
 		wake_up(&txn_handle->wait_q);
 		if (txn_handle->type == QMI_ASYNC_TXN) {
-			list_del(&txn_handle->list);
+			qmi_txn_unlink(txn_handle);
 			kfree(txn_handle);
 		}
 		return rc;
@@ -528,7 +547,7 @@ static int handle_qmi_response(struct qmi_handle *handle,
 			txn_handle->resp_cb(txn_handle->handle, msg_id,
 					    txn_handle->resp,
 					    txn_handle->resp_cb_data, 0);
-		list_del(&txn_handle->list);
+		qmi_txn_unlink(txn_handle);
 		kfree(txn_handle);
 		rc = 0;
 		break;
@@ -31,6 +31,7 @@ enum txn_type {
 
 struct qmi_txn {
 	struct list_head list;
+	struct hlist_node hash;
 	uint16_t txn_id;
 	enum txn_type type;
 	struct qmi_handle *handle;
@@ -31,9 +31,11 @@
 #include <linux/suspend.h>
 
 #define MAX_LONG_SIZE 24
-#define DEFAULT_RQ_POLL_JIFFIES 1
 #define DEFAULT_DEF_TIMER_JIFFIES 5
 
+struct rq_data rq_info;
+static struct workqueue_struct *rq_wq;
+
 struct notifier_block freq_transition;
 struct notifier_block cpu_hotplug;
 
@@ -241,17 +243,29 @@ static void def_work_fn(struct work_struct *work)
 	sysfs_notify(rq_info.kobj, NULL, "def_timer_ms");
 }
 
+static int rq_stats_nr_avg_notify(struct notifier_block *nb,
+				  unsigned long avg, void *data)
+{
+	if (jiffies - rq_info.def_timer_last_jiffy >=
+	    ACCESS_ONCE(rq_info.def_timer_jiffies)) {
+		rq_info.def_timer_last_jiffy = jiffies;
+		queue_work(rq_wq, &rq_info.def_timer_work);
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block rq_stats_nr_avg_nb = {
+	.notifier_call = rq_stats_nr_avg_notify,
+};
+
 static ssize_t run_queue_avg_show(struct kobject *kobj,
 		struct kobj_attribute *attr, char *buf)
 {
-	unsigned int val = 0;
-	unsigned long flags = 0;
+	int val, iowait;
 
-	spin_lock_irqsave(&rq_lock, flags);
-	
-	val = rq_info.rq_avg;
-	rq_info.rq_avg = 0;
-	spin_unlock_irqrestore(&rq_lock, flags);
+	sched_get_nr_running_avg_decayed(&val, &iowait);
+	val /= 10;
 
 	return snprintf(buf, PAGE_SIZE, "%d.%d\n", val/10, val%10);
 }
@@ -261,15 +275,8 @@ static struct kobj_attribute run_queue_avg_attr = __ATTR_RO(run_queue_avg);
 static ssize_t show_run_queue_poll_ms(struct kobject *kobj,
 				      struct kobj_attribute *attr, char *buf)
 {
-	int ret = 0;
-	unsigned long flags = 0;
-
-	spin_lock_irqsave(&rq_lock, flags);
-	ret = snprintf(buf, MAX_LONG_SIZE, "%u\n",
-		       jiffies_to_msecs(rq_info.rq_poll_jiffies));
-	spin_unlock_irqrestore(&rq_lock, flags);
-
-	return ret;
+	return snprintf(buf, MAX_LONG_SIZE, "%u\n",
+			sched_get_nr_running_avg_period());
 }
 
 static ssize_t store_run_queue_poll_ms(struct kobject *kobj,
@@ -277,17 +284,9 @@ static ssize_t store_run_queue_poll_ms(struct kobject *kobj,
 				       const char *buf, size_t count)
 {
 	unsigned int val = 0;
-	unsigned long flags = 0;
-	static DEFINE_MUTEX(lock_poll_ms);
 
-	mutex_lock(&lock_poll_ms);
-
-	spin_lock_irqsave(&rq_lock, flags);
 	sscanf(buf, "%u", &val);
-	rq_info.rq_poll_jiffies = msecs_to_jiffies(val);
-	spin_unlock_irqrestore(&rq_lock, flags);
-
-	mutex_unlock(&lock_poll_ms);
+	sched_set_nr_running_avg_period(val);
 
 	return count;
 }
@@ -345,7 +344,6 @@ static int init_rq_attribs(void)
 {
 	int err;
 
-	rq_info.rq_avg = 0;
 	rq_info.attr_group = &rq_attr_group;
 
 	
@@ -377,10 +375,7 @@ static int __init msm_rq_stats_init(void)
 	rq_wq = create_singlethread_workqueue("rq_stats");
 	BUG_ON(!rq_wq);
 	INIT_WORK(&rq_info.def_timer_work, def_work_fn);
-	spin_lock_init(&rq_lock);
-	rq_info.rq_poll_jiffies = DEFAULT_RQ_POLL_JIFFIES;
 	rq_info.def_timer_jiffies = DEFAULT_DEF_TIMER_JIFFIES;
-	rq_info.rq_poll_last_jiffy = 0;
 	rq_info.def_timer_last_jiffy = 0;
 	rq_info.hotplug_disabled = 0;
 	ret = init_rq_attribs();
@@ -401,6 +396,7 @@ static int __init msm_rq_stats_init(void)
 	cpufreq_register_notifier(&freq_transition,
 					CPUFREQ_TRANSITION_NOTIFIER);
 	register_hotcpu_notifier(&cpu_hotplug);
+	sched_register_nr_running_avg_notifier(&rq_stats_nr_avg_nb);
 
 	return ret;
 }
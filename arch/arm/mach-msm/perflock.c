@@ -19,10 +19,14 @@
 #include <linux/device.h>
 #include <linux/clk.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/pm_qos.h>
 #include <linux/earlysuspend.h>
 #include <linux/cpufreq.h>
 #include <linux/timer.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/sched.h>
 #include <mach/perflock.h>
 #include "acpuclock.h"
 
@@ -49,6 +53,19 @@ static unsigned int *cpufreq_ceiling_acpu_table;
 static unsigned int table_size;
 static struct workqueue_struct *perflock_setrate_workqueue;
 
+#define PERF_QOS_GLOBAL		NR_CPUS
+
+static struct pm_qos_constraints floor_qos[NR_CPUS + 1];
+static struct pm_qos_constraints ceiling_qos[NR_CPUS + 1];
+/*
+ * Nothing registers on this chain, so pm_qos_update_target() never sleeps
+ * and perf_lock()/perf_unlock() stay usable from atomic context.  Changes
+ * reach cpufreq through perflock_notify_work instead.
+ */
+static BLOCKING_NOTIFIER_HEAD(perflock_qos_notifier);
+static int qos_initialized;
+static unsigned long perflock_notify_pending;
+static struct cpumask perflock_update_cpus;
 
 #ifdef CONFIG_PERF_LOCK_DEBUG
 static int debug_mask = PERF_LOCK_DEBUG | PERF_EXPIRE_DEBUG |
@@ -91,6 +108,11 @@ module_param_call(min_cpu_khz, param_set_cpu_min_max, param_get_int,
 module_param_call(max_cpu_khz, param_set_cpu_min_max, param_get_int,
 	&policy_max, S_IWUSR | S_IRUGO);
 
+static unsigned int floor_min_nr_running;
+module_param(floor_min_nr_running, uint, S_IWUSR | S_IRUGO);
+
+static int perflock_floor_gated;
+
 static DEFINE_PER_CPU(int, stored_policy_min);
 static DEFINE_PER_CPU(int, stored_policy_max);
 
@@ -108,45 +130,156 @@ void perflock_scaling_min_freq(unsigned int freq, unsigned int cpu)
 	per_cpu(stored_policy_min, cpu) = freq;
 }
 
-static unsigned int get_perflock_speed(void)
+static void perflock_qos_init(void)
 {
-	unsigned long irqflags;
-	struct perf_lock *lock;
-	unsigned int perf_level = 0;
+	int i;
 
-	
-	if (list_empty(&active_perf_locks))
-		return 0;
+	if (qos_initialized)
+		return;
 
-	spin_lock_irqsave(&list_lock, irqflags);
-	list_for_each_entry(lock, &active_perf_locks, link) {
-		if (lock->level > perf_level)
-			perf_level = lock->level;
+	for (i = 0; i <= PERF_QOS_GLOBAL; i++) {
+		plist_head_init(&floor_qos[i].list);
+		floor_qos[i].target_value = PM_QOS_DEFAULT_VALUE;
+		floor_qos[i].default_value = PM_QOS_DEFAULT_VALUE;
+		floor_qos[i].type = PM_QOS_MAX;
+		floor_qos[i].notifiers = &perflock_qos_notifier;
+
+		plist_head_init(&ceiling_qos[i].list);
+		ceiling_qos[i].target_value = PERF_LOCK_INVALID;
+		ceiling_qos[i].default_value = PERF_LOCK_INVALID;
+		ceiling_qos[i].type = PM_QOS_MIN;
+		ceiling_qos[i].notifiers = &perflock_qos_notifier;
 	}
-	spin_unlock_irqrestore(&list_lock, irqflags);
+	qos_initialized = 1;
+}
+
+static inline int perflock_qos_index(int cpu)
+{
+	return (cpu == PERF_LOCK_ALL_CPUS) ? PERF_QOS_GLOBAL : cpu;
+}
+
+static struct pm_qos_constraints *perflock_qos(struct perf_lock *lock)
+{
+	int idx = perflock_qos_index(lock->cpu);
+
+	if (lock->type == TYPE_CPUFREQ_CEILING)
+		return &ceiling_qos[idx];
+	return &floor_qos[idx];
+}
+
+static int floor_level(int idx)
+{
+	if (!initialized)
+		return -1;
+	return pm_qos_read_value(&floor_qos[idx]);
+}
+
+static int ceiling_level(int idx)
+{
+	if (!cpufreq_ceiling_initialized)
+		return PERF_LOCK_INVALID;
+	return pm_qos_read_value(&ceiling_qos[idx]);
+}
+
+static unsigned int get_perflock_speed(void)
+{
+	int perf_level = floor_level(PERF_QOS_GLOBAL);
+
+	if (perf_level < 0 || ACCESS_ONCE(perflock_floor_gated))
+		return 0;
 
 	return perf_acpu_table[perf_level];
 }
 
 static unsigned int get_cpufreq_ceiling_speed(void)
 {
-	unsigned long irqflags;
-	struct perf_lock *lock;
-	unsigned int perf_level = PERF_LOCK_HIGHEST;
+	int perf_level = ceiling_level(PERF_QOS_GLOBAL);
 
-	
-	if (list_empty(&active_cpufreq_ceiling_locks))
+	if (perf_level >= PERF_LOCK_INVALID)
 		return 0;
 
-	spin_lock_irqsave(&list_lock, irqflags);
-	list_for_each_entry(lock, &active_cpufreq_ceiling_locks, link) {
-		if (lock->level < perf_level)
-			perf_level = lock->level;
-	}
-	spin_unlock_irqrestore(&list_lock, irqflags);
+	return cpufreq_ceiling_acpu_table[perf_level];
+}
+
+unsigned int perflock_cpu_floor(int cpu)
+{
+	int perf_level = floor_level(cpu);
+
+	if (!ACCESS_ONCE(perflock_floor_gated))
+		perf_level = max(floor_level(PERF_QOS_GLOBAL), perf_level);
+
+	if (perf_level < 0)
+		return 0;
+
+	return perf_acpu_table[perf_level];
+}
+EXPORT_SYMBOL(perflock_cpu_floor);
+
+unsigned int perflock_cpu_ceiling(int cpu)
+{
+	int perf_level = min(ceiling_level(PERF_QOS_GLOBAL),
+			     ceiling_level(cpu));
+
+	if (perf_level >= PERF_LOCK_INVALID)
+		return 0;
 
 	return cpufreq_ceiling_acpu_table[perf_level];
 }
+EXPORT_SYMBOL(perflock_cpu_ceiling);
+
+static void perflock_notify_work_fn(struct work_struct *work)
+{
+	int cpu;
+
+	if (test_and_clear_bit(TYPE_PERF_LOCK, &perflock_notify_pending))
+		sysfs_notify(cpufreq_kobj, NULL, "perflock_scaling_min");
+	if (test_and_clear_bit(TYPE_CPUFREQ_CEILING, &perflock_notify_pending))
+		sysfs_notify(cpufreq_kobj, NULL, "perflock_scaling_max");
+	for_each_possible_cpu(cpu)
+		if (cpumask_test_and_clear_cpu(cpu, &perflock_update_cpus) &&
+		    cpu_online(cpu))
+			cpufreq_update_policy(cpu);
+}
+
+static DECLARE_WORK(perflock_notify_work, perflock_notify_work_fn);
+
+static void perflock_notify(struct perf_lock *lock)
+{
+	if (lock->cpu == PERF_LOCK_ALL_CPUS)
+		set_bit(lock->type, &perflock_notify_pending);
+	else
+		cpumask_set_cpu(lock->cpu, &perflock_update_cpus);
+	schedule_work(&perflock_notify_work);
+}
+
+static int perflock_nr_avg_notify(struct notifier_block *nb,
+				  unsigned long avg, void *data)
+{
+	int gated = floor_min_nr_running && avg < floor_min_nr_running;
+
+	if (gated == perflock_floor_gated)
+		return NOTIFY_OK;
+
+	perflock_floor_gated = gated;
+	set_bit(TYPE_PERF_LOCK, &perflock_notify_pending);
+	schedule_work(&perflock_notify_work);
+	return NOTIFY_OK;
+}
+
+static struct notifier_block perflock_nr_avg_nb = {
+	.notifier_call = perflock_nr_avg_notify,
+};
+
+static void perflock_expire(unsigned long data)
+{
+	struct perf_lock *lock = (struct perf_lock *)data;
+
+	if (debug_mask & PERF_EXPIRE_DEBUG)
+		pr_info("%s: '%s' expired\n", __func__, lock->name);
+
+	if (is_perf_lock_active(lock))
+		perf_unlock(lock);
+}
 
 void htc_print_active_perf_locks(void)
 {
@@ -171,8 +304,8 @@ void htc_print_active_perf_locks(void)
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
 
-void perf_lock_init(struct perf_lock *lock, unsigned int type,
-			unsigned int level, const char *name)
+void perf_lock_init_cpu(struct perf_lock *lock, unsigned int type,
+			unsigned int level, const char *name, int cpu)
 {
 	unsigned long irqflags = 0;
 
@@ -180,19 +313,26 @@ void perf_lock_init(struct perf_lock *lock, unsigned int type,
 	WARN_ON(!name);
 	WARN_ON(level >= PERF_LOCK_INVALID);
 	WARN_ON(lock->flags & PERF_LOCK_INITIALIZED);
+	WARN_ON(cpu != PERF_LOCK_ALL_CPUS && (cpu < 0 || cpu >= nr_cpu_ids));
 
 	if ((!name) || (level >= PERF_LOCK_INVALID) ||
-			(lock->flags & PERF_LOCK_INITIALIZED)) {
-		pr_err("%s: ERROR \"%s\" flags %x level %d\n",
-			__func__, name, lock->flags, level);
+			(lock->flags & PERF_LOCK_INITIALIZED) ||
+			(cpu != PERF_LOCK_ALL_CPUS &&
+			 (cpu < 0 || cpu >= nr_cpu_ids))) {
+		pr_err("%s: ERROR \"%s\" flags %x level %d cpu %d\n",
+			__func__, name, lock->flags, level, cpu);
 		return;
 	}
 	lock->name = name;
 	lock->flags = PERF_LOCK_INITIALIZED;
 	lock->level = level;
 	lock->type = type;
+	lock->cpu = cpu;
+	lock->expires = 0;
 
 	INIT_LIST_HEAD(&lock->link);
+	plist_node_init(&lock->node, level);
+	setup_timer(&lock->expire_timer, perflock_expire, (unsigned long)lock);
 	spin_lock_irqsave(&list_lock, irqflags);
 	if (lock->type == TYPE_PERF_LOCK)
 		list_add(&lock->link, &inactive_perf_locks);
@@ -200,12 +340,20 @@ void perf_lock_init(struct perf_lock *lock, unsigned int type,
 		list_add(&lock->link, &inactive_cpufreq_ceiling_locks);
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
+EXPORT_SYMBOL(perf_lock_init_cpu);
+
+void perf_lock_init(struct perf_lock *lock, unsigned int type,
+			unsigned int level, const char *name)
+{
+	perf_lock_init_cpu(lock, type, level, name, PERF_LOCK_ALL_CPUS);
+}
 EXPORT_SYMBOL(perf_lock_init);
 
 
 void perf_lock(struct perf_lock *lock)
 {
 	unsigned long irqflags;
+	int changed;
 
 	WARN_ON((lock->flags & PERF_LOCK_INITIALIZED) == 0);
 	WARN_ON(lock->flags & PERF_LOCK_ACTIVE);
@@ -240,20 +388,37 @@ void perf_lock(struct perf_lock *lock)
 		list_add(&lock->link, &active_perf_locks);
 	else if (lock->type == TYPE_CPUFREQ_CEILING)
 		list_add(&lock->link, &active_cpufreq_ceiling_locks);
+	changed = pm_qos_update_target(perflock_qos(lock), &lock->node,
+				       PM_QOS_ADD_REQ, lock->level);
 	spin_unlock_irqrestore(&list_lock, irqflags);
 
-    if (lock->type == TYPE_PERF_LOCK)
-		sysfs_notify(cpufreq_kobj, NULL, "perflock_scaling_min");
-	else if (lock->type == TYPE_CPUFREQ_CEILING)
-		sysfs_notify(cpufreq_kobj, NULL, "perflock_scaling_max");
+	if (changed)
+		perflock_notify(lock);
 
 	return;
 }
 EXPORT_SYMBOL(perf_lock);
 
+void perf_lock_timeout(struct perf_lock *lock, unsigned int timeout_ms)
+{
+	unsigned long irqflags;
+
+	if (!is_perf_lock_active(lock))
+		perf_lock(lock);
+
+	spin_lock_irqsave(&list_lock, irqflags);
+	if (lock->flags & PERF_LOCK_ACTIVE) {
+		lock->expires = jiffies + msecs_to_jiffies(timeout_ms);
+		mod_timer(&lock->expire_timer, lock->expires);
+	}
+	spin_unlock_irqrestore(&list_lock, irqflags);
+}
+EXPORT_SYMBOL(perf_lock_timeout);
+
 void perf_unlock(struct perf_lock *lock)
 {
 	unsigned long irqflags;
+	int changed;
 
 	WARN_ON(!initialized);
 	WARN_ON((lock->flags & PERF_LOCK_ACTIVE) == 0);
@@ -284,17 +449,19 @@ void perf_unlock(struct perf_lock *lock)
 		return;
 	}
 	lock->flags &= ~PERF_LOCK_ACTIVE;
+	lock->expires = 0;
+	del_timer(&lock->expire_timer);
 	list_del(&lock->link);
 	if (lock->type == TYPE_PERF_LOCK)
 		list_add(&lock->link, &inactive_perf_locks);
 	else if (lock->type == TYPE_CPUFREQ_CEILING)
 		list_add(&lock->link, &inactive_cpufreq_ceiling_locks);
+	changed = pm_qos_update_target(perflock_qos(lock), &lock->node,
+				       PM_QOS_REMOVE_REQ, PM_QOS_DEFAULT_VALUE);
 	spin_unlock_irqrestore(&list_lock, irqflags);
 
-	if (lock->type == TYPE_PERF_LOCK)
-		sysfs_notify(cpufreq_kobj, NULL, "perflock_scaling_min");
-	else if (lock->type == TYPE_CPUFREQ_CEILING)
-		sysfs_notify(cpufreq_kobj, NULL, "perflock_scaling_max");
+	if (changed)
+		perflock_notify(lock);
 }
 EXPORT_SYMBOL(perf_unlock);
 
@@ -361,6 +528,7 @@ struct perf_lock *perflock_acquire(const char *name)
 	lock->name = name;
 	
 	lock->flags = 0; 
+	lock->cpu = PERF_LOCK_ALL_CPUS;
 
 	return lock;
 }
@@ -378,6 +546,8 @@ int perflock_release(const char *name)
 	
 	if(is_perf_lock_active(lock))
 		perf_unlock(lock);
+	if (lock->flags & PERF_LOCK_INITIALIZED)
+		del_timer_sync(&lock->expire_timer);
 
 	spin_lock_irqsave(&list_lock, irqflags);
 	list_del(&lock->link);
@@ -479,6 +649,99 @@ invalid_config:
 		cpufreq_ceiling_acpu_table, table_size, PERF_LOCK_INVALID);
 }
 
+static int perflock_cpufreq_policy_notify(struct notifier_block *nb,
+					  unsigned long val, void *data)
+{
+	struct cpufreq_policy *policy = data;
+	int floor = -1, ceiling = PERF_LOCK_INVALID;
+	int cpu;
+
+	if (val != CPUFREQ_ADJUST)
+		return NOTIFY_OK;
+
+	for_each_cpu(cpu, policy->cpus) {
+		floor = max(floor, floor_level(cpu));
+		ceiling = min(ceiling, ceiling_level(cpu));
+	}
+
+	if (floor >= 0)
+		cpufreq_verify_within_limits(policy,
+			perf_acpu_table[floor] / 1000,
+			policy->cpuinfo.max_freq);
+	if (ceiling < PERF_LOCK_INVALID)
+		cpufreq_verify_within_limits(policy,
+			policy->cpuinfo.min_freq,
+			cpufreq_ceiling_acpu_table[ceiling] / 1000);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block perflock_cpufreq_policy_nb = {
+	.notifier_call = perflock_cpufreq_policy_notify,
+};
+
+static void perflock_show_locks(struct seq_file *m, struct list_head *head,
+				const char *type)
+{
+	struct perf_lock *lock;
+
+	list_for_each_entry(lock, head, link) {
+		seq_printf(m, "  %-24s %-7s cpu:%-3d level:%u", lock->name,
+			   type, lock->cpu, lock->level);
+		if (lock->expires)
+			seq_printf(m, " expires:%ums",
+				   jiffies_to_msecs(max_t(long, 0,
+					(long)(lock->expires - jiffies))));
+		seq_printf(m, "\n");
+	}
+}
+
+static int perflock_constraints_show(struct seq_file *m, void *unused)
+{
+	unsigned long irqflags;
+	int cpu;
+
+	seq_printf(m, "global floor:%u ceiling:%u\n",
+		   get_perflock_speed() / 1000,
+		   get_cpufreq_ceiling_speed() / 1000);
+	for_each_possible_cpu(cpu)
+		seq_printf(m, "cpu%d floor:%u ceiling:%u\n", cpu,
+			   perflock_cpu_floor(cpu) / 1000,
+			   perflock_cpu_ceiling(cpu) / 1000);
+
+	seq_printf(m, "holders:\n");
+	spin_lock_irqsave(&list_lock, irqflags);
+	perflock_show_locks(m, &active_perf_locks, "floor");
+	perflock_show_locks(m, &active_cpufreq_ceiling_locks, "ceiling");
+	spin_unlock_irqrestore(&list_lock, irqflags);
+
+	return 0;
+}
+
+static int perflock_constraints_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, perflock_constraints_show, inode->i_private);
+}
+
+static const struct file_operations perflock_constraints_fops = {
+	.open		= perflock_constraints_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void perflock_debugfs_init(void)
+{
+	struct dentry *dent;
+
+	dent = debugfs_create_dir("perflock", NULL);
+	if (IS_ERR_OR_NULL(dent))
+		return;
+
+	debugfs_create_file("constraints", S_IRUGO, dent, NULL,
+			    &perflock_constraints_fops);
+}
+
 static int perf_lock_probe(struct platform_device *pdev)
 {
 	struct perflock_pdata *pdata = pdev->dev.platform_data;
@@ -487,6 +750,7 @@ static int perf_lock_probe(struct platform_device *pdev)
 		printk(KERN_INFO "perf_lock Not Initialized\n");
 		return -ENODEV;
 	}
+	perflock_qos_init();
 	if(pdata->perf_floor) {
 		perflock_floor_init(pdata->perf_floor);
 
@@ -494,6 +758,10 @@ static int perf_lock_probe(struct platform_device *pdev)
 	if(pdata->perf_ceiling) {
 		cpufreq_ceiling_init(pdata->perf_ceiling);
 	}
+	cpufreq_register_notifier(&perflock_cpufreq_policy_nb,
+				  CPUFREQ_POLICY_NOTIFIER);
+	sched_register_nr_running_avg_notifier(&perflock_nr_avg_nb);
+	perflock_debugfs_init();
 	return 0;
 }
 
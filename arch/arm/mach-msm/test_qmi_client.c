@@ -16,6 +16,7 @@
 #include <linux/errno.h>
 #include <linux/delay.h>
 #include <linux/debugfs.h>
+#include <linux/ktime.h>
 #include <linux/qmi_encdec.h>
 
 #include <asm/uaccess.h>
@@ -153,6 +154,70 @@ data_send_err:
 	return rc;
 }
 
+static int test_qmi_encdec_msg(unsigned int data_len)
+{
+	struct test_data_req_msg_v01 *req, *dec;
+	struct msg_desc req_desc;
+	unsigned char *buf;
+	ktime_t start;
+	s64 ns;
+	int rc = -ENOMEM, i;
+
+	if (data_len > TEST_MED_DATA_SIZE_V01)
+		return -EINVAL;
+
+	req = kzalloc(sizeof(struct test_data_req_msg_v01), GFP_KERNEL);
+	dec = kzalloc(sizeof(struct test_data_req_msg_v01), GFP_KERNEL);
+	buf = kmalloc(TEST_DATA_REQ_MAX_MSG_LEN_V01, GFP_KERNEL);
+	if (!req || !dec || !buf) {
+		pr_err("%s: Encdec msg alloc failed\n", __func__);
+		goto encdec_err;
+	}
+
+	req->data_len = data_len;
+	for (i = 0; i < data_len; i++)
+		req->data[i] = (uint8_t)i;
+	req->client_name_valid = 1;
+	req->client_name.name_len = strlcpy(req->client_name.name,
+				"test_qmi_client", TEST_MAX_NAME_SIZE_V01);
+
+	req_desc.max_msg_len = TEST_DATA_REQ_MAX_MSG_LEN_V01;
+	req_desc.msg_id = TEST_DATA_REQ_MSG_ID_V01;
+	req_desc.ei_array = test_data_req_msg_v01_ei;
+
+	start = ktime_get();
+	for (i = 0; i < test_rep_cnt; i++) {
+		rc = qmi_kernel_encode(&req_desc, buf,
+				       TEST_DATA_REQ_MAX_MSG_LEN_V01, req);
+		if (rc < 0)
+			goto encdec_err;
+		rc = qmi_kernel_decode(&req_desc, dec, buf, rc);
+		if (rc < 0)
+			goto encdec_err;
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (dec->data_len != req->data_len ||
+	    memcmp(dec->data, req->data, data_len) ||
+	    !dec->client_name_valid ||
+	    strncmp(dec->client_name.name, req->client_name.name,
+		    TEST_MAX_NAME_SIZE_V01)) {
+		pr_err("%s: Decoded msg does not match\n", __func__);
+		rc = -EFAULT;
+		goto encdec_err;
+	}
+
+	pr_info("%s: %d round trips of %u bytes, %lld ns each\n", __func__,
+		test_rep_cnt, data_len,
+		test_rep_cnt > 0 ? div_s64(ns, test_rep_cnt) : 0);
+	rc = 0;
+encdec_err:
+	kfree(buf);
+	kfree(dec);
+	kfree(req);
+	return rc;
+}
+
 static int test_qmi_data_send_async_msg(unsigned int data_len)
 {
 	struct test_data_req_msg_v01 *req;
@@ -377,6 +442,8 @@ static ssize_t test_qmi_write(struct file *fp, const char __user *buf,
 		}
 		D("%s complete\n", __func__);
 		callback_count = 0;
+	} else if (!strncmp(cmd, "encdec", sizeof(cmd))) {
+		test_res = test_qmi_encdec_msg(test_data_sz);
 	} else {
 		test_res = -EINVAL;
 	}
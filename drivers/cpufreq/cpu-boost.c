@@ -25,6 +25,9 @@
 #include <linux/input.h>
 #include <linux/time.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/cpu_boost.h>
+
 struct cpu_sync {
 	struct task_struct *thread;
 	wait_queue_head_t sync_wq;
@@ -34,8 +37,11 @@ struct cpu_sync {
 	spinlock_t lock;
 	bool pending;
 	int src_cpu;
+	int task_load;
 	unsigned int boost_min;
 	unsigned int input_boost_min;
+	unsigned int input_boost_freq;
+	unsigned int input_boost_stage;
 };
 
 static DEFINE_PER_CPU(struct cpu_sync, sync_info);
@@ -49,12 +55,90 @@ module_param(boost_ms, uint, 0644);
 static unsigned int sync_threshold;
 module_param(sync_threshold, uint, 0644);
 
-static unsigned int input_boost_freq;
-module_param(input_boost_freq, uint, 0644);
+static unsigned int migration_load_threshold = 15;
+module_param(migration_load_threshold, uint, 0644);
+
+static bool boost_decay = true;
+module_param(boost_decay, bool, 0644);
+
+static bool input_boost_enabled;
 
 static unsigned int input_boost_ms = 40;
 module_param(input_boost_ms, uint, 0644);
 
+static unsigned int input_boost_stage2_pct;
+module_param(input_boost_stage2_pct, uint, 0644);
+
+static unsigned int input_boost_stage2_ms = 80;
+module_param(input_boost_stage2_ms, uint, 0644);
+
+static int set_input_boost_freq(const char *buf, const struct kernel_param *kp)
+{
+	int i, ntokens = 0;
+	unsigned int val, cpu;
+	const char *cp = buf;
+	bool enabled = false;
+
+	while ((cp = strpbrk(cp + 1, " :")))
+		ntokens++;
+
+	if (!ntokens) {
+		if (sscanf(buf, "%u\n", &val) != 1)
+			return -EINVAL;
+		for_each_possible_cpu(i)
+			per_cpu(sync_info, i).input_boost_freq = val;
+		goto check_enable;
+	}
+
+	if (!(ntokens % 2))
+		return -EINVAL;
+
+	cp = buf;
+	for (i = 0; i < ntokens; i += 2) {
+		if (sscanf(cp, "%u:%u", &cpu, &val) != 2)
+			return -EINVAL;
+		if (cpu >= nr_cpu_ids)
+			return -EINVAL;
+
+		per_cpu(sync_info, cpu).input_boost_freq = val;
+		cp = strchr(cp, ' ');
+		if (!cp)
+			break;
+		cp++;
+	}
+
+check_enable:
+	for_each_possible_cpu(i) {
+		if (per_cpu(sync_info, i).input_boost_freq) {
+			enabled = true;
+			break;
+		}
+	}
+	input_boost_enabled = enabled;
+
+	return 0;
+}
+
+static int get_input_boost_freq(char *buf, const struct kernel_param *kp)
+{
+	int cnt = 0, cpu;
+	struct cpu_sync *s;
+
+	for_each_possible_cpu(cpu) {
+		s = &per_cpu(sync_info, cpu);
+		cnt += snprintf(buf + cnt, PAGE_SIZE - cnt,
+				"%d:%u ", cpu, s->input_boost_freq);
+	}
+	cnt += snprintf(buf + cnt, PAGE_SIZE - cnt, "\n");
+	return cnt;
+}
+
+static const struct kernel_param_ops param_ops_input_boost_freq = {
+	.set = set_input_boost_freq,
+	.get = get_input_boost_freq,
+};
+module_param_cb(input_boost_freq, &param_ops_input_boost_freq, NULL, 0644);
+
 static u64 last_input_time;
 #define MIN_INPUT_INTERVAL (150 * USEC_PER_MSEC)
 
@@ -95,11 +179,24 @@ static void do_boost_rem(struct work_struct *work)
 {
 	struct cpu_sync *s = container_of(work, struct cpu_sync,
 						boost_rem.work);
+	struct cpufreq_policy policy;
+	unsigned int decayed = 0;
 
-	pr_debug("Removing boost for CPU%d\n", s->cpu);
-	s->boost_min = 0;
+	if (boost_decay && !cpufreq_get_policy(&policy, s->cpu)) {
+		decayed = s->boost_min >> 1;
+		if (decayed <= policy.min)
+			decayed = 0;
+	}
+
+	pr_debug("Decaying boost for CPU%d to %u kHz\n", s->cpu, decayed);
+	trace_cpu_boost_decay(s->cpu, decayed);
+	s->boost_min = decayed;
 	
 	cpufreq_update_policy(s->cpu);
+
+	if (decayed)
+		queue_delayed_work_on(s->cpu, cpu_boost_wq,
+			&s->boost_rem, msecs_to_jiffies(boost_ms));
 }
 
 static void do_input_boost_rem(struct work_struct *work)
@@ -107,7 +204,21 @@ static void do_input_boost_rem(struct work_struct *work)
 	struct cpu_sync *s = container_of(work, struct cpu_sync,
 						input_boost_rem.work);
 
+	if (s->input_boost_stage == 1 && input_boost_stage2_pct) {
+		s->input_boost_stage = 2;
+		s->input_boost_min = s->input_boost_min *
+					input_boost_stage2_pct / 100;
+		trace_cpu_boost_input(s->cpu, 2, s->input_boost_min);
+		cpufreq_update_policy(s->cpu);
+		queue_delayed_work_on(s->cpu, cpu_boost_wq,
+			&s->input_boost_rem,
+			msecs_to_jiffies(input_boost_stage2_ms));
+		return;
+	}
+
 	pr_debug("Removing input boost for CPU%d\n", s->cpu);
+	trace_cpu_boost_input_rem(s->cpu, 0);
+	s->input_boost_stage = 0;
 	s->input_boost_min = 0;
 	
 	cpufreq_update_policy(s->cpu);
@@ -116,11 +227,12 @@ static void do_input_boost_rem(struct work_struct *work)
 static int boost_mig_sync_thread(void *data)
 {
 	int dest_cpu = (int) data;
-	int src_cpu, ret;
+	int src_cpu, ret, load;
 	struct cpu_sync *s = &per_cpu(sync_info, dest_cpu);
 	struct cpufreq_policy dest_policy;
 	struct cpufreq_policy src_policy;
 	unsigned long flags;
+	unsigned int req_freq;
 
 	while(1) {
 		wait_event(s->sync_wq, s->pending || kthread_should_stop());
@@ -131,6 +243,8 @@ static int boost_mig_sync_thread(void *data)
 		spin_lock_irqsave(&s->lock, flags);
 		s->pending = false;
 		src_cpu = s->src_cpu;
+		load = s->task_load;
+		s->task_load = 0;
 		spin_unlock_irqrestore(&s->lock, flags);
 
 		ret = cpufreq_get_policy(&src_policy, src_cpu);
@@ -141,24 +255,22 @@ static int boost_mig_sync_thread(void *data)
 		if (ret)
 			continue;
 
-		if (dest_policy.cur >= src_policy.cur ) {
-			pr_debug("No sync. CPU%d@%dKHz >= CPU%d@%dKHz\n",
-				 dest_cpu, dest_policy.cur, src_cpu, src_policy.cur);
-			continue;
-		}
+		req_freq = max(src_policy.cur * load / 100, src_policy.min);
+		if (sync_threshold)
+			req_freq = min(req_freq, sync_threshold);
 
-		if (sync_threshold && (dest_policy.cur >= sync_threshold))
+		if (dest_policy.cur >= req_freq) {
+			pr_debug("No sync. CPU%d@%dKHz >= %dKHz (load %d%%)\n",
+				 dest_cpu, dest_policy.cur, req_freq, load);
+			trace_cpu_boost_migration(src_cpu, dest_cpu, load,
+						  src_policy.cur, 0);
 			continue;
+		}
 
 		cancel_delayed_work_sync(&s->boost_rem);
-		if (sync_threshold) {
-			if (src_policy.cur >= sync_threshold)
-				s->boost_min = sync_threshold;
-			else
-				s->boost_min = src_policy.cur;
-		} else {
-			s->boost_min = src_policy.cur;
-		}
+		s->boost_min = req_freq;
+		trace_cpu_boost_migration(src_cpu, dest_cpu, load,
+					  src_policy.cur, req_freq);
 		
 		cpufreq_update_policy(dest_cpu);
 		queue_delayed_work_on(s->cpu, cpu_boost_wq,
@@ -169,18 +281,24 @@ static int boost_mig_sync_thread(void *data)
 }
 
 static int boost_migration_notify(struct notifier_block *nb,
-				unsigned long dest_cpu, void *arg)
+				unsigned long unused, void *arg)
 {
+	struct migration_notify_data *mnd = arg;
 	unsigned long flags;
-	struct cpu_sync *s = &per_cpu(sync_info, dest_cpu);
+	struct cpu_sync *s = &per_cpu(sync_info, mnd->dest_cpu);
 
 	if (!boost_ms)
 		return NOTIFY_OK;
 
-	pr_debug("Migration: CPU%d --> CPU%d\n", (int) arg, (int) dest_cpu);
+	if (mnd->load < migration_load_threshold)
+		return NOTIFY_OK;
+
+	pr_debug("Migration: CPU%d --> CPU%d (load %d%%)\n",
+		 mnd->src_cpu, mnd->dest_cpu, mnd->load);
 	spin_lock_irqsave(&s->lock, flags);
 	s->pending = true;
-	s->src_cpu = (int) arg;
+	s->src_cpu = mnd->src_cpu;
+	s->task_load = max(s->task_load, mnd->load);
 	spin_unlock_irqrestore(&s->lock, flags);
 	wake_up(&s->sync_wq);
 
@@ -200,14 +318,20 @@ static void do_input_boost(struct work_struct *work)
 	for_each_online_cpu(i) {
 
 		i_sync_info = &per_cpu(sync_info, i);
+		if (!i_sync_info->input_boost_freq)
+			continue;
 		ret = cpufreq_get_policy(&policy, i);
 		if (ret)
 			continue;
-		if (policy.cur >= input_boost_freq)
+		if (policy.cpu != i)
+			continue;
+		if (policy.cur >= i_sync_info->input_boost_freq)
 			continue;
 
 		cancel_delayed_work_sync(&i_sync_info->input_boost_rem);
-		i_sync_info->input_boost_min = input_boost_freq;
+		i_sync_info->input_boost_min = i_sync_info->input_boost_freq;
+		i_sync_info->input_boost_stage = 1;
+		trace_cpu_boost_input(i, 1, i_sync_info->input_boost_min);
 		cpufreq_update_policy(i);
 		queue_delayed_work_on(i_sync_info->cpu, cpu_boost_wq,
 			&i_sync_info->input_boost_rem,
@@ -220,7 +344,7 @@ static void cpuboost_input_event(struct input_handle *handle,
 {
 	u64 now;
 
-	if (!input_boost_freq)
+	if (!input_boost_enabled)
 		return;
 
 	now = ktime_to_us(ktime_get());
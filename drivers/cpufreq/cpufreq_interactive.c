@@ -104,6 +104,9 @@ static unsigned int up_threshold_any_cpu_load;
 static unsigned int sync_freq;
 static unsigned int up_threshold_any_cpu_freq;
 
+static unsigned int up_threshold_nr_running;
+static unsigned long nr_running_avg;
+
 static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		unsigned int event);
 
@@ -390,6 +393,11 @@ static void cpufreq_interactive_timer(unsigned long data)
 			if (max_freq > up_threshold_any_cpu_freq &&
 				max_load >= up_threshold_any_cpu_load)
 				new_freq = sync_freq;
+
+			if (up_threshold_nr_running &&
+			    ACCESS_ONCE(nr_running_avg) >=
+			    up_threshold_nr_running)
+				new_freq = sync_freq;
 		}
 	}
 
@@ -1087,6 +1095,30 @@ static struct global_attr up_threshold_any_cpu_freq_attr =
 		show_up_threshold_any_cpu_freq,
 				store_up_threshold_any_cpu_freq);
 
+static ssize_t show_up_threshold_nr_running(struct kobject *kobj,
+			struct attribute *attr, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", up_threshold_nr_running);
+}
+
+static ssize_t store_up_threshold_nr_running(struct kobject *kobj,
+			struct attribute *attr, const char *buf, size_t count)
+{
+	int ret;
+	unsigned long val;
+
+	ret = kstrtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	up_threshold_nr_running = val;
+	return count;
+}
+
+static struct global_attr up_threshold_nr_running_attr =
+		__ATTR(up_threshold_nr_running, 0644,
+		show_up_threshold_nr_running,
+				store_up_threshold_nr_running);
+
 static struct attribute *interactive_attributes[] = {
 	&target_loads_attr.attr,
 	&above_hispeed_delay_attr.attr,
@@ -1103,6 +1135,7 @@ static struct attribute *interactive_attributes[] = {
 	&sync_freq_attr.attr,
 	&up_threshold_any_cpu_load_attr.attr,
 	&up_threshold_any_cpu_freq_attr.attr,
+	&up_threshold_nr_running_attr.attr,
 	NULL,
 };
 
@@ -1127,6 +1160,17 @@ static int cpufreq_interactive_idle_notifier(struct notifier_block *nb,
 	return 0;
 }
 
+static int cpufreq_interactive_nr_avg_notifier(struct notifier_block *nb,
+					       unsigned long avg, void *data)
+{
+	nr_running_avg = avg;
+	return NOTIFY_OK;
+}
+
+static struct notifier_block cpufreq_interactive_nr_avg_nb = {
+	.notifier_call = cpufreq_interactive_nr_avg_notifier,
+};
+
 static struct notifier_block cpufreq_interactive_idle_nb = {
 	.notifier_call = cpufreq_interactive_idle_notifier,
 };
@@ -1182,6 +1226,8 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		idle_notifier_register(&cpufreq_interactive_idle_nb);
 		cpufreq_register_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
+		sched_register_nr_running_avg_notifier(
+			&cpufreq_interactive_nr_avg_nb);
 		mutex_unlock(&gov_lock);
 		break;
 
@@ -1201,6 +1247,8 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 			return 0;
 		}
 
+		sched_unregister_nr_running_avg_notifier(
+			&cpufreq_interactive_nr_avg_nb);
 		cpufreq_unregister_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
 		idle_notifier_unregister(&cpufreq_interactive_idle_nb);
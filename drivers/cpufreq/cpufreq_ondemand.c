@@ -151,6 +151,8 @@ static DEFINE_MUTEX(dbs_mutex);
 
 static struct workqueue_struct *dbs_wq;
 
+static unsigned long dbs_nr_running_avg;
+
 static struct dbs_tuners {
 	unsigned int sampling_rate;
 	unsigned int up_threshold;
@@ -159,6 +161,7 @@ static struct dbs_tuners {
 	unsigned int down_differential_multi_core;
 	unsigned int optimal_freq;
 	unsigned int up_threshold_any_cpu_load;
+	unsigned int up_threshold_nr_running;
 	unsigned int sync_freq;
 	unsigned int ignore_nice;
 	unsigned int sampling_down_factor;
@@ -338,6 +341,7 @@ show_one(ignore_nice_load, ignore_nice);
 show_one(down_differential_multi_core, down_differential_multi_core);
 show_one(optimal_freq, optimal_freq);
 show_one(up_threshold_any_cpu_load, up_threshold_any_cpu_load);
+show_one(up_threshold_nr_running, up_threshold_nr_running);
 show_one(sync_freq, sync_freq);
 show_one(freq_down_step, freq_down_step);
 show_one(freq_down_step_barriar, freq_down_step_barriar);
@@ -502,6 +506,19 @@ static ssize_t store_up_threshold_any_cpu_load(struct kobject *a,
 	return count;
 }
 
+static ssize_t store_up_threshold_nr_running(struct kobject *a,
+			struct attribute *b, const char *buf, size_t count)
+{
+	unsigned int input;
+	int ret;
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1)
+		return -EINVAL;
+	dbs_tuners_ins.up_threshold_nr_running = input;
+	return count;
+}
+
 static ssize_t store_down_differential(struct kobject *a, struct attribute *b,
 		const char *buf, size_t count)
 {
@@ -823,6 +840,7 @@ define_one_global_rw(up_threshold_multi_core);
 define_one_global_rw(down_differential_multi_core);
 define_one_global_rw(optimal_freq);
 define_one_global_rw(up_threshold_any_cpu_load);
+define_one_global_rw(up_threshold_nr_running);
 define_one_global_rw(sync_freq);
 define_one_global_rw(input_event_min_freq);
 define_one_global_rw(multi_phase_freq_tbl);
@@ -843,6 +861,7 @@ static struct attribute *dbs_attributes[] = {
 	&down_differential_multi_core.attr,
 	&optimal_freq.attr,
 	&up_threshold_any_cpu_load.attr,
+	&up_threshold_nr_running.attr,
 	&sync_freq.attr,
 	&input_event_min_freq.attr,
 	&multi_phase_freq_tbl.attr,
@@ -1267,6 +1286,15 @@ static void dbs_check_cpu(struct cpu_dbs_info_s *this_dbs_info)
 		}
 #endif
 
+		if (dbs_tuners_ins.up_threshold_nr_running &&
+		    ACCESS_ONCE(dbs_nr_running_avg) >=
+		    dbs_tuners_ins.up_threshold_nr_running) {
+			if (policy->cur < dbs_tuners_ins.sync_freq)
+				dbs_freq_increase(policy, max_cur_load,
+						dbs_tuners_ins.sync_freq);
+			return;
+		}
+
 		if (max_load_freq > dbs_tuners_ins.up_threshold_multi_core *
 								policy->cur) {
 			if (policy->cur < dbs_tuners_ins.optimal_freq)
@@ -1420,14 +1448,26 @@ static int should_io_be_busy(void)
 	return 0;
 }
 
+static int dbs_nr_avg_notify(struct notifier_block *nb,
+				unsigned long avg, void *data)
+{
+	dbs_nr_running_avg = avg;
+	return NOTIFY_OK;
+}
+
+static struct notifier_block dbs_nr_avg_nb = {
+	.notifier_call = dbs_nr_avg_notify,
+};
+
 #ifndef CONFIG_ARCH_MSM_CORTEXMP
 static int dbs_migration_notify(struct notifier_block *nb,
-				unsigned long target_cpu, void *arg)
+				unsigned long unused, void *arg)
 {
+	struct migration_notify_data *mnd = arg;
 	struct cpu_dbs_info_s *target_dbs_info =
-		&per_cpu(od_cpu_dbs_info, target_cpu);
+		&per_cpu(od_cpu_dbs_info, mnd->dest_cpu);
 
-	atomic_set(&target_dbs_info->src_sync_cpu, (int)arg);
+	atomic_set(&target_dbs_info->src_sync_cpu, mnd->src_cpu);
 	wake_up(&target_dbs_info->sync_wq);
 
 	return NOTIFY_OK;
@@ -1751,6 +1791,7 @@ static int cpufreq_governor_dbs(struct cpufreq_policy *policy,
 			atomic_notifier_chain_register(&migration_notifier_head,
 					&dbs_migration_nb);
 #endif
+			sched_register_nr_running_avg_notifier(&dbs_nr_avg_nb);
 		}
 		if (!cpu)
 			rc = input_register_handler(&dbs_input_handler);
@@ -1784,6 +1825,8 @@ static int cpufreq_governor_dbs(struct cpufreq_policy *policy,
 		if (!dbs_enable) {
 			dbs_deinit_freq_map_table();
 
+			sched_unregister_nr_running_avg_notifier(&dbs_nr_avg_nb);
+
 			sysfs_remove_group(cpufreq_global_kobject,
 					   &dbs_attr_group);
 
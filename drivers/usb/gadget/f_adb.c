@@ -33,8 +33,23 @@
 #define ADB_ATS_ENABLE              _IOR(ADB_IOCTL_MAGIC, 1, unsigned)
 
 #define ADB_BULK_BUFFER_SIZE           4096
+#define ADB_REQ_LEN_DEFAULT            16384
 
 #define TX_REQ_MAX 4
+#define ADB_RX_REQ_MAX 4
+#define ADB_REQ_LIMIT 16
+
+static unsigned int adb_rx_req_len = ADB_REQ_LEN_DEFAULT;
+module_param(adb_rx_req_len, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int adb_tx_req_len = ADB_REQ_LEN_DEFAULT;
+module_param(adb_tx_req_len, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int adb_rx_reqs = ADB_RX_REQ_MAX;
+module_param(adb_rx_reqs, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int adb_tx_reqs = TX_REQ_MAX;
+module_param(adb_tx_reqs, uint, S_IRUGO | S_IWUSR);
 
 static const char adb_shortname[] = "android_adb";
 
@@ -54,11 +69,20 @@ struct adb_dev {
 	atomic_t open_excl;
 
 	struct list_head tx_idle;
+	struct list_head rx_idle;
+	struct list_head rx_done;
+
+	unsigned int rx_req_len;
+	unsigned int tx_req_len;
+	unsigned int rx_reqs;
+	unsigned int tx_reqs;
 
 	wait_queue_head_t read_wq;
 	wait_queue_head_t write_wq;
-	struct usb_request *rx_req;
-	int rx_done;
+	struct usb_request *rx_req[ADB_REQ_LIMIT];
+	int rx_queued;
+	size_t rx_queued_bytes;
+	unsigned int rx_offset;
 };
 
 static struct usb_interface_descriptor adb_interface_desc = {
@@ -251,8 +275,8 @@ static void adb_complete_in(struct usb_ep *ep, struct usb_request *req)
 static void adb_complete_out(struct usb_ep *ep, struct usb_request *req)
 {
 	struct adb_dev *dev = _adb_dev;
+	unsigned long flags;
 
-	dev->rx_done = 1;
 	if (req->status != 0 && req->status != -ECONNRESET)
 		atomic_set(&dev->error, 1);
 
@@ -260,6 +284,17 @@ static void adb_complete_out(struct usb_ep *ep, struct usb_request *req)
 		if (req->status != -ESHUTDOWN)
 			printk(KERN_INFO "[USB] %s: warning (%d)\n", __func__, req->status);
 	}
+
+	
+	spin_lock_irqsave(&dev->lock, flags);
+	dev->rx_queued--;
+	dev->rx_queued_bytes -= req->length;
+	if (req->status == 0 || (req->status == -ECONNRESET && req->actual))
+		list_add_tail(&req->list, &dev->rx_done);
+	else
+		list_add_tail(&req->list, &dev->rx_idle);
+	spin_unlock_irqrestore(&dev->lock, flags);
+
 	wake_up(&dev->read_wq);
 }
 
@@ -293,16 +328,44 @@ static int adb_create_bulk_endpoints(struct adb_dev *dev,
 	dev->ep_out = ep;
 
 	
-	req = adb_request_new(dev->ep_out, ADB_BULK_BUFFER_SIZE);
-	if (!req)
-		goto fail;
-	req->complete = adb_complete_out;
-	dev->rx_req = req;
-
-	for (i = 0; i < TX_REQ_MAX; i++) {
-		req = adb_request_new(dev->ep_in, ADB_BULK_BUFFER_SIZE);
-		if (!req)
-			goto fail;
+	dev->rx_req_len = max_t(unsigned int, adb_rx_req_len,
+				ADB_BULK_BUFFER_SIZE);
+	if (dev->rx_req_len % 1024)
+		dev->rx_req_len = ADB_BULK_BUFFER_SIZE;
+	dev->rx_reqs = clamp_t(unsigned int, adb_rx_reqs, 1, ADB_REQ_LIMIT);
+retry_rx_alloc:
+	for (i = 0; i < dev->rx_reqs; i++) {
+		req = adb_request_new(dev->ep_out, dev->rx_req_len);
+		if (!req) {
+			if (dev->rx_req_len == ADB_BULK_BUFFER_SIZE)
+				goto fail;
+			while (i--)
+				adb_request_free(dev->rx_req[i], dev->ep_out);
+			INIT_LIST_HEAD(&dev->rx_idle);
+			dev->rx_req_len = ADB_BULK_BUFFER_SIZE;
+			dev->rx_reqs = ADB_RX_REQ_MAX;
+			goto retry_rx_alloc;
+		}
+		req->complete = adb_complete_out;
+		dev->rx_req[i] = req;
+		adb_req_put(dev, &dev->rx_idle, req);
+	}
+
+	dev->tx_req_len = max_t(unsigned int, adb_tx_req_len,
+				ADB_BULK_BUFFER_SIZE);
+	dev->tx_reqs = clamp_t(unsigned int, adb_tx_reqs, 1, ADB_REQ_LIMIT);
+retry_tx_alloc:
+	for (i = 0; i < dev->tx_reqs; i++) {
+		req = adb_request_new(dev->ep_in, dev->tx_req_len);
+		if (!req) {
+			if (dev->tx_req_len == ADB_BULK_BUFFER_SIZE)
+				goto fail;
+			while ((req = adb_req_get(dev, &dev->tx_idle)))
+				adb_request_free(req, dev->ep_in);
+			dev->tx_req_len = ADB_BULK_BUFFER_SIZE;
+			dev->tx_reqs = TX_REQ_MAX;
+			goto retry_tx_alloc;
+		}
 		req->complete = adb_complete_in;
 		adb_req_put(dev, &dev->tx_idle, req);
 	}
@@ -317,12 +380,87 @@ fail:
 static int bugreport_debug;
 static void adb_read_timeout(void);
 
+/*
+ * Queue idle OUT requests until @want bytes of the current read are
+ * covered.  Chunks of a read that is a multiple of the packet size are
+ * sized exactly, so no request is left waiting past the end of a transfer
+ * the host sent without a ZLP; any other read ends in a short packet, so
+ * its last request may use the whole buffer.
+ */
+static int adb_rx_fill(struct adb_dev *dev, size_t *queued, size_t want)
+{
+	struct usb_request *req;
+	size_t len;
+	int ret;
+
+	while (*queued < want && (req = adb_req_get(dev, &dev->rx_idle))) {
+		len = min_t(size_t, want - *queued, dev->rx_req_len);
+		if (len % 512) {
+			req->length = dev->rx_req_len;
+			*queued = want;
+		} else {
+			req->length = len;
+			*queued += len;
+		}
+
+		spin_lock_irq(&dev->lock);
+		dev->rx_queued++;
+		dev->rx_queued_bytes += req->length;
+		spin_unlock_irq(&dev->lock);
+
+		ret = usb_ep_queue(dev->ep_out, req, GFP_ATOMIC);
+		if (ret < 0) {
+			pr_debug("adb_read: failed to queue req %p (%d)\n",
+				 req, ret);
+			spin_lock_irq(&dev->lock);
+			dev->rx_queued--;
+			dev->rx_queued_bytes -= req->length;
+			list_add_tail(&req->list, &dev->rx_idle);
+			spin_unlock_irq(&dev->lock);
+			return ret;
+		}
+		pr_debug("rx %p queue\n", req);
+	}
+	return 0;
+}
+
+/*
+ * Top up the OUT queue for a read that still wants @want bytes.  Data
+ * already completed and requests still in flight from earlier reads count
+ * towards it; when neither exists at least one request is queued.
+ */
+static int adb_rx_refill(struct adb_dev *dev, size_t want)
+{
+	struct usb_request *req;
+	size_t queued;
+
+	spin_lock_irq(&dev->lock);
+	queued = dev->rx_queued_bytes;
+	list_for_each_entry(req, &dev->rx_done, list)
+		queued += req->actual;
+	queued -= min_t(size_t, queued, dev->rx_offset);
+	spin_unlock_irq(&dev->lock);
+
+	return adb_rx_fill(dev, &queued, want);
+}
+
+static void adb_rx_flush(struct adb_dev *dev)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->lock, flags);
+	list_splice_tail_init(&dev->rx_done, &dev->rx_idle);
+	dev->rx_offset = 0;
+	spin_unlock_irqrestore(&dev->lock, flags);
+}
+
 static ssize_t adb_read(struct file *fp, char __user *buf,
 				size_t count, loff_t *pos)
 {
 	struct adb_dev *dev = fp->private_data;
 	struct usb_request *req;
-	int r = count, xfer;
+	size_t copied = 0, xfer;
+	int r = 0, end;
 	int ret;
 
 	pr_debug("adb_read(%d)\n", count);
@@ -330,9 +468,6 @@ static ssize_t adb_read(struct file *fp, char __user *buf,
 	if (!_adb_dev)
 		return -ENODEV;
 
-	if (count > ADB_BULK_BUFFER_SIZE)
-		return -EINVAL;
-
 	if (adb_lock(&dev->read_excl))
 		return -EBUSY;
 
@@ -351,60 +486,81 @@ static ssize_t adb_read(struct file *fp, char __user *buf,
 		r = -EIO;
 		goto done;
 	}
+	if (!count)
+		goto done;
 
 requeue_req:
-	
-	req = dev->rx_req;
-
-	if (count % 512 == 0)
-		req->length = count;
-	else
-		req->length = ADB_BULK_BUFFER_SIZE;
-	dev->rx_done = 0;
-	ret = usb_ep_queue(dev->ep_out, req, GFP_ATOMIC);
-	if (ret < 0) {
-		pr_debug("adb_read: failed to queue req %p (%d)\n", req, ret);
-		r = -EIO;
-		atomic_set(&dev->error, 1);
-		goto done;
-	} else {
-		pr_debug("rx %p queue\n", req);
-	}
+	end = 0;
+	while (copied < count && !end) {
+		if (adb_rx_refill(dev, count - copied) < 0) {
+			r = -EIO;
+			atomic_set(&dev->error, 1);
+			goto done;
+		}
 
-	
-	ret = wait_event_interruptible(dev->read_wq, dev->rx_done ||
+		ret = wait_event_interruptible(dev->read_wq,
+				!list_empty(&dev->rx_done) ||
+				!dev->rx_queued ||
 				atomic_read(&dev->error));
 
-	if (bugreport_debug) {
+		if (bugreport_debug) {
+			if (atomic_read(&dev->error)) {
+				r = -EIO;
+				adb_read_timeout();
+				goto done;
+			}
+			del_timer(&adb_read_timer);
+		}
+
+		if (ret < 0) {
+			if (ret != -ERESTARTSYS)
+				atomic_set(&dev->error, 1);
+			r = ret;
+			goto done;
+		}
 		if (atomic_read(&dev->error)) {
 			r = -EIO;
-			adb_read_timeout();
 			goto done;
 		}
-		del_timer(&adb_read_timer);
-	}
 
-	if (ret < 0) {
-		if (ret != -ERESTARTSYS)
-		atomic_set(&dev->error, 1);
-		r = ret;
-		usb_ep_dequeue(dev->ep_out, req);
-		goto done;
-	}
-	if (!atomic_read(&dev->error)) {
-		
-		if (req->actual == 0)
-			goto requeue_req;
+		spin_lock_irq(&dev->lock);
+		if (list_empty(&dev->rx_done)) {
+			spin_unlock_irq(&dev->lock);
+			continue;
+		}
+		req = list_first_entry(&dev->rx_done, struct usb_request, list);
+		spin_unlock_irq(&dev->lock);
 
 		pr_debug("rx %p %d\n", req, req->actual);
-		xfer = (req->actual < count) ? req->actual : count;
-		if (copy_to_user(buf, req->buf, xfer))
+		xfer = min_t(size_t, req->actual - dev->rx_offset,
+			     count - copied);
+		if (xfer && copy_to_user(buf + copied,
+					 req->buf + dev->rx_offset, xfer)) {
 			r = -EFAULT;
+			goto done;
+		}
+		copied += xfer;
+		dev->rx_offset += xfer;
 
-	} else
-		r = -EIO;
+		
+		if (dev->rx_offset < req->actual)
+			break;
+
+		end = req->status || req->actual < req->length;
+		spin_lock_irq(&dev->lock);
+		list_move_tail(&req->list, &dev->rx_idle);
+		spin_unlock_irq(&dev->lock);
+		dev->rx_offset = 0;
+	}
+
+	
+	if (!copied)
+		goto requeue_req;
 
 done:
+	if (copied && r != -EFAULT)
+		r = copied;
+
 	if (atomic_read(&dev->error))
 		wake_up(&dev->write_wq);
 
@@ -460,8 +616,8 @@ static ssize_t adb_write(struct file *fp, const char __user *buf,
 		}
 
 		if (req != 0) {
-			if (count > ADB_BULK_BUFFER_SIZE)
-				xfer = ADB_BULK_BUFFER_SIZE;
+			if (count > dev->tx_req_len)
+				xfer = dev->tx_req_len;
 			else
 				xfer = count;
 			if (copy_from_user(req->buf, buf, xfer)) {
@@ -511,6 +667,7 @@ static int adb_open(struct inode *ip, struct file *fp)
 	fp->private_data = _adb_dev;
 
 	
+	adb_rx_flush(_adb_dev);
 	atomic_set(&_adb_dev->error, 0);
 	return 0;
 }
@@ -640,14 +797,20 @@ adb_function_unbind(struct usb_configuration *c, struct usb_function *f)
 {
 	struct adb_dev	*dev = func_to_adb(f);
 	struct usb_request *req;
-
+	int i;
 
 	atomic_set(&dev->online, 0);
 	atomic_set(&dev->error, 1);
 
 	wake_up(&dev->read_wq);
 
-	adb_request_free(dev->rx_req, dev->ep_out);
+	for (i = 0; i < dev->rx_reqs; i++)
+		adb_request_free(dev->rx_req[i], dev->ep_out);
+	INIT_LIST_HEAD(&dev->rx_idle);
+	INIT_LIST_HEAD(&dev->rx_done);
+	dev->rx_queued = 0;
+	dev->rx_queued_bytes = 0;
+	dev->rx_offset = 0;
 	while ((req = adb_req_get(dev, &dev->tx_idle)))
 		adb_request_free(req, dev->ep_in);
 }
@@ -690,6 +853,7 @@ static int adb_function_set_alt(struct usb_function *f,
 		usb_ep_disable(dev->ep_in);
 		return ret;
 	}
+	adb_rx_flush(dev);
 	atomic_set(&dev->online, 1);
 
 	
@@ -755,6 +919,8 @@ static int adb_setup(void)
 	
 
 	INIT_LIST_HEAD(&dev->tx_idle);
+	INIT_LIST_HEAD(&dev->rx_idle);
+	INIT_LIST_HEAD(&dev->rx_done);
 
 	_adb_dev = dev;
 
@@ -58,6 +58,8 @@
 #include <linux/string.h>
 #include <linux/freezer.h>
 #include <linux/utsname.h>
+#include <linux/mm.h>
+#include <linux/uio.h>
 
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
@@ -83,6 +85,16 @@ static int write_error_after_csw_sent;
 static int csw_hack_sent;
 #endif
 
+static unsigned int fsg_readahead_kb = 512;
+module_param_named(readahead_kb, fsg_readahead_kb, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(readahead_kb, "Readahead window for sequential reads (KB)");
+
+static unsigned int fsg_flush_kb = 4096;
+module_param_named(flush_kb, fsg_flush_kb, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(flush_kb, "Start writeback after this much data is written (KB)");
+
+#define FSG_WRITE_VECS	8
+
 struct fsg_dev;
 struct fsg_common;
 
@@ -575,6 +587,38 @@ static void cd_data_to_raw(u8 *buf, int lba)
 
 
 
+/*
+ * Keep the backing file's page cache a window ahead of a sequential
+ * host stream, so that vfs_read() below is a copy rather than a wait.
+ * Only a READ that continues where the previous one ended starts
+ * readahead; random accesses are left to the normal read path.
+ */
+static void fsg_lun_readahead(struct fsg_lun *curlun, loff_t offset,
+			      u32 amount_left)
+{
+	loff_t window = (loff_t)fsg_readahead_kb << 10;
+	loff_t end = offset + amount_left;
+	loff_t next;
+	pgoff_t start;
+
+	if (offset != curlun->next_read) {
+		curlun->next_read = end;
+		curlun->ra_end = end;
+		return;
+	}
+	curlun->next_read = end;
+
+	if (!window || curlun->ra_end >= curlun->file_length ||
+	    curlun->ra_end - end >= window / 2)
+		return;
+
+	next = min(max(curlun->ra_end, end) + window, curlun->file_length);
+	start = curlun->ra_end >> PAGE_CACHE_SHIFT;
+	force_page_cache_readahead(curlun->filp->f_mapping, curlun->filp,
+			start, ((next - 1) >> PAGE_CACHE_SHIFT) - start + 1);
+	curlun->ra_end = next;
+}
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = common->curlun;
@@ -628,6 +672,8 @@ static int do_read(struct fsg_common *common)
 	if (unlikely(amount_left == 0))
 		return -EIO;		
 
+	fsg_lun_readahead(curlun, file_offset, amount_left);
+
 	for (;;) {
 		amount = min(amount_left, FSG_BUFLEN);
 		amount = min((loff_t)amount,
@@ -728,16 +774,38 @@ static int do_read(struct fsg_common *common)
 
 
 
+/*
+ * Buffered writes are otherwise left to the flusher threads, so a long
+ * host write builds up a dirty backlog that is paid for all at once in
+ * balance_dirty_pages() or the next SYNCHRONIZE CACHE.  Start writeback
+ * every flush_kb instead, so the backing device streams along with the
+ * host.
+ */
+static void fsg_lun_written(struct fsg_lun *curlun, ssize_t nwritten)
+{
+	if (!fsg_flush_kb || nwritten <= 0)
+		return;
+
+	curlun->unflushed += nwritten;
+	if (curlun->unflushed < (unsigned long)fsg_flush_kb << 10)
+		return;
+
+	curlun->unflushed = 0;
+	filemap_flush(curlun->filp->f_mapping);
+}
+
 static int do_write(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = common->curlun;
 	u32			lba;
-	struct fsg_buffhd	*bh;
+	struct fsg_buffhd	*bh, *next;
 	int			get_some_more;
 	u32			amount_left_to_req, amount_left_to_write;
 	loff_t			usb_offset, file_offset, file_offset_tmp;
-	unsigned int		amount;
+	unsigned int		amount, len;
 	ssize_t			nwritten;
+	struct iovec		iov[FSG_WRITE_VECS];
+	int			nvec;
 	int			rc;
 
 #ifdef CONFIG_USB_CSW_HACK
@@ -859,14 +927,56 @@ static int do_write(struct fsg_common *common)
 			if (amount == 0)
 				goto empty_write;
 
+			/*
+			 * Whole buffers that have already arrived behind this
+			 * one continue it on disk; hand them to the filesystem
+			 * in the same call.
+			 */
+			iov[0].iov_base = bh->buf;
+			iov[0].iov_len = amount;
+			nvec = 1;
+			len = amount;
+			while (nvec < FSG_WRITE_VECS &&
+			       len == bh->bulk_out_intended_length &&
+			       bh->outreq->actual == len) {
+				next = common->next_buffhd_to_drain;
+				if (next->state != BUF_STATE_FULL)
+					break;
+#ifdef CONFIG_USB_CSW_HACK
+				/* same check as the drain path above */
+				if (common->residue <= amount)
+					break;
+#endif
+				smp_rmb();
+				len = next->bulk_out_intended_length;
+				if (next->outreq->status != 0 ||
+				    next->outreq->actual != len ||
+				    len % curlun->blksize ||
+				    curlun->file_length - file_offset - amount < len)
+					break;
+
+				common->next_buffhd_to_drain = next->next;
+				next->state = BUF_STATE_EMPTY;
+				iov[nvec].iov_base = next->buf;
+				iov[nvec].iov_len = len;
+				nvec++;
+				amount += len;
+				bh = next;
+			}
+
 			
 			file_offset_tmp = file_offset;
 #ifdef CONFIG_USB_MSC_PROFILING
 			start = ktime_get();
 #endif
-			nwritten = vfs_write(curlun->filp,
-					     (char __user *)bh->buf,
-					     amount, &file_offset_tmp);
+			if (nvec == 1)
+				nwritten = vfs_write(curlun->filp,
+						     (char __user *)bh->buf,
+						     amount, &file_offset_tmp);
+			else
+				nwritten = vfs_writev(curlun->filp,
+					(const struct iovec __user *)iov,
+					nvec, &file_offset_tmp);
 			VLDBG(curlun, "file write %u @ %llu -> %d\n", amount,
 			      (unsigned long long)file_offset, (int)nwritten);
 #ifdef CONFIG_USB_MSC_PROFILING
@@ -890,6 +1000,7 @@ static int do_write(struct fsg_common *common)
 			file_offset += nwritten;
 			amount_left_to_write -= nwritten;
 			common->residue -= nwritten;
+			fsg_lun_written(curlun, nwritten);
 
 			
 			if (nwritten < amount) {
@@ -28,6 +28,7 @@
 #include <linux/file.h>
 #include <linux/device.h>
 #include <linux/miscdevice.h>
+#include <linux/mm.h>
 
 #include <linux/usb.h>
 #include <linux/usb_usual.h>
@@ -52,6 +53,18 @@
 #define MTP_RX_REQ_MAX 8
 #define MTP_INTR_REQ_MAX 5
 
+static unsigned int mtp_rx_req_len = MTP_BULK_BUFFER_SIZE;
+module_param(mtp_rx_req_len, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int mtp_tx_req_len = MTP_BULK_BUFFER_SIZE;
+module_param(mtp_tx_req_len, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int mtp_tx_reqs = MTP_TX_REQ_MAX;
+module_param(mtp_tx_reqs, uint, S_IRUGO | S_IWUSR);
+
+static unsigned int mtp_rx_reqs = MTP_RX_REQ_MAX;
+module_param(mtp_rx_reqs, uint, S_IRUGO | S_IWUSR);
+
 #define MTP_OS_STRING_ID   0xEE
 
 #define MTP_REQ_CANCEL              0x64
@@ -92,12 +105,17 @@ struct mtp_dev {
 	struct usb_request *rx_req;
 	unsigned char *read_buf;
 	uint64_t read_count;
+	bool rx_short;
 
 	struct list_head rx_idle;
 	struct list_head rx_done;
 	struct list_head tx_idle;
 	struct list_head intr_idle;
 
+	unsigned int rx_req_len;
+	unsigned int tx_req_len;
+	unsigned int tx_reqs;
+
 	wait_queue_head_t read_wq;
 	wait_queue_head_t write_wq;
 	wait_queue_head_t intr_wq;
@@ -469,6 +487,15 @@ static struct usb_request
 	return req;
 }
 
+static void mtp_rx_drop(struct mtp_dev *dev)
+{
+	if (dev->rx_req) {
+		mtp_req_put(dev, &dev->rx_idle, dev->rx_req);
+		dev->rx_req = NULL;
+	}
+	dev->read_count = 0;
+}
+
 static void mtp_complete_in(struct usb_ep *ep, struct usb_request *req)
 {
 	struct mtp_dev *dev = _mtp_dev;
@@ -521,6 +548,7 @@ static int mtp_create_bulk_endpoints(struct mtp_dev *dev,
 	struct usb_composite_dev *cdev = dev->cdev;
 	struct usb_request *req;
 	struct usb_ep *ep;
+	unsigned int rx_reqs;
 	int i;
 
 	DBG(cdev, "create_bulk_endpoints dev: %p\n", dev);
@@ -553,17 +581,43 @@ static int mtp_create_bulk_endpoints(struct mtp_dev *dev,
 	dev->ep_intr = ep;
 
 	
-	for (i = 0; i < MTP_TX_REQ_MAX; i++) {
-		req = mtp_request_new(dev->ep_in, MTP_BULK_BUFFER_SIZE);
-		if (!req)
+	dev->tx_req_len = max_t(unsigned int, mtp_tx_req_len,
+				MTP_BULK_BUFFER_SIZE);
+	dev->tx_reqs = clamp_t(unsigned int, mtp_tx_reqs, 2, 32);
+retry_tx_alloc:
+	for (i = 0; i < dev->tx_reqs; i++) {
+		req = mtp_request_new(dev->ep_in, dev->tx_req_len);
+		if (!req) {
+			if (dev->tx_req_len == MTP_BULK_BUFFER_SIZE)
 				goto fail;
+			while ((req = mtp_req_get(dev, &dev->tx_idle)))
+				mtp_request_free(req, dev->ep_in);
+			dev->tx_req_len = MTP_BULK_BUFFER_SIZE;
+			dev->tx_reqs = MTP_TX_REQ_MAX;
+			goto retry_tx_alloc;
+		}
 		req->complete = mtp_complete_in;
 		mtp_req_put(dev, &dev->tx_idle, req);
 	}
-	for (i = 0; i < MTP_RX_REQ_MAX; i++) {
-		req = mtp_request_new(dev->ep_out, MTP_BULK_BUFFER_SIZE);
-		if (!req)
+
+	
+	dev->rx_req_len = max_t(unsigned int, mtp_rx_req_len,
+				MTP_BULK_BUFFER_SIZE);
+	if (dev->rx_req_len % 1024)
+		dev->rx_req_len = MTP_BULK_BUFFER_SIZE;
+	rx_reqs = clamp_t(unsigned int, mtp_rx_reqs, 2, 32);
+retry_rx_alloc:
+	for (i = 0; i < rx_reqs; i++) {
+		req = mtp_request_new(dev->ep_out, dev->rx_req_len);
+		if (!req) {
+			if (dev->rx_req_len == MTP_BULK_BUFFER_SIZE)
 				goto fail;
+			while ((req = mtp_req_get(dev, &dev->rx_idle)))
+				mtp_request_free(req, dev->ep_out);
+			dev->rx_req_len = MTP_BULK_BUFFER_SIZE;
+			rx_reqs = MTP_RX_REQ_MAX;
+			goto retry_rx_alloc;
+		}
 		req->complete = mtp_complete_out;
 		mtp_req_put(dev, &dev->rx_idle, req);
 	}
@@ -621,7 +675,7 @@ static ssize_t mtp_read(struct file *fp, char __user *buf,
 	spin_unlock_irq(&dev->lock);
 
 	
-	if (count > MTP_BULK_BUFFER_SIZE) {
+	if (count > dev->rx_req_len) {
 		file_xfer_zlp_flag = 1;
 		
 #ifdef CONFIG_PERFLOCK
@@ -634,11 +688,11 @@ static ssize_t mtp_read(struct file *fp, char __user *buf,
 			usb_ep_nuke(dev->ep_out);
 			while ((req = mtp_req_get(dev, &dev->rx_done)))
 				mtp_req_put(dev, &dev->rx_idle, req);
-			dev->read_count = 0;
+			mtp_rx_drop(dev);
 			r = -ECANCELED;
 			break;
 		} else if (unlikely(dev->state == STATE_OFFLINE)) {
-			dev->read_count = 0;
+			mtp_rx_drop(dev);
 			r = -EIO;
 			goto done;
 		}
@@ -649,14 +703,14 @@ requeue_req:
 			#if 0
 			req->length = dev->maxsize?dev->maxsize:512;
 			#endif
-			req->length = MTP_BULK_BUFFER_SIZE;
+			req->length = dev->rx_req_len;
 			DBG(cdev, "%s: queue request(%p) on %s\n", __func__, req, dev->ep_out->name);
 			ret = usb_ep_queue(dev->ep_out, req, GFP_ATOMIC);
 			if (ret < 0) {
 				INFO(cdev, "%s: failed to queue req %p (%d)\n", __func__, req, ret);
 				r = -EIO;
 				mtp_req_put(dev, &dev->rx_idle, req);
-				dev->read_count = 0;
+				mtp_rx_drop(dev);
 				goto done;
 			}
 		}
@@ -682,12 +736,10 @@ requeue_req:
 			if (dev->read_count == 0 && dev->rx_req) {
 				mtp_req_put(dev, &dev->rx_idle, dev->rx_req);
 				dev->rx_req = 0;
-			}
 
-			
-			if (xfer < MTP_BULK_BUFFER_SIZE) {
-				dev->read_count = 0;
-				break;
+				
+				if (dev->rx_short)
+					break;
 			}
 			continue;
 		}
@@ -702,12 +754,12 @@ requeue_req:
 			if (req->actual == 0) {
 				if (file_xfer_zlp_flag == 0)
 					goto requeue_req;
-					dev->rx_req = req;
-					mtp_req_put(dev, &dev->rx_idle, dev->rx_req);
+					mtp_req_put(dev, &dev->rx_idle, req);
 					INFO(cdev, "%s: got ZLP while file xfer.\n", __func__);
 					break;
 				}
 				dev->rx_req = req;
+				dev->rx_short = req->actual < req->length;
 				dev->read_count = req->actual;
 				dev->read_buf = req->buf;
 		}
@@ -781,8 +833,8 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 			break;
 		}
 
-		if (count > MTP_BULK_BUFFER_SIZE)
-			xfer = MTP_BULK_BUFFER_SIZE;
+		if (count > dev->tx_req_len)
+			xfer = dev->tx_req_len;
 		else
 			xfer = count;
 		if (xfer && copy_from_user(req->buf, buf, xfer)) {
@@ -819,6 +871,27 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 	return r;
 }
 
+/*
+ * Keep the page cache one request ring ahead of the USB transfers, so
+ * the vfs_read() for the next chunk normally finds its pages already
+ * read in while earlier chunks are still on the bus.
+ */
+static void mtp_file_readahead(struct file *filp, loff_t offset,
+			       loff_t *ra_end, loff_t end, loff_t window)
+{
+	pgoff_t start;
+	loff_t next;
+
+	if (*ra_end >= end || *ra_end - offset >= window / 2)
+		return;
+
+	next = min(*ra_end + window, end);
+	start = *ra_end >> PAGE_CACHE_SHIFT;
+	force_page_cache_readahead(filp->f_mapping, filp, start,
+			((next - 1) >> PAGE_CACHE_SHIFT) - start + 1);
+	*ra_end = next;
+}
+
 static void send_file_work(struct work_struct *data)
 {
 	struct mtp_dev *dev = container_of(data, struct mtp_dev,
@@ -827,7 +900,7 @@ static void send_file_work(struct work_struct *data)
 	struct usb_request *req = 0;
 	struct mtp_data_header *header;
 	struct file *filp;
-	loff_t offset;
+	loff_t offset, ra_end, end, ra_window;
 	int64_t count;
 	int xfer, ret, hdr_size;
 	int r = 0;
@@ -842,6 +915,10 @@ static void send_file_work(struct work_struct *data)
 
 	DBG(cdev, "send_file_work(%lld %lld)\n", offset, count);
 
+	ra_end = offset;
+	end = offset + count;
+	ra_window = (loff_t)dev->tx_req_len * dev->tx_reqs;
+
 	if (dev->xfer_send_header) {
 		hdr_size = sizeof(struct mtp_data_header);
 		count += hdr_size;
@@ -873,11 +950,13 @@ static void send_file_work(struct work_struct *data)
 			break;
 		}
 
-		if (count > MTP_BULK_BUFFER_SIZE)
-			xfer = MTP_BULK_BUFFER_SIZE;
+		if (count > dev->tx_req_len)
+			xfer = dev->tx_req_len;
 		else
 			xfer = count;
 
+		mtp_file_readahead(filp, offset, &ra_end, end, ra_window);
+
 		if (hdr_size) {
 			
 			header = (struct mtp_data_header *)req->buf;
@@ -948,7 +1027,7 @@ static void receive_file_work(struct work_struct *data)
 	filp = dev->xfer_file;
 	offset = dev->xfer_file_offset;
 	count = dev->xfer_file_length;
-	dev->read_count = 0;
+	mtp_rx_drop(dev);
 
 	DBG(cdev, "receive_file_work(%lld)\n", count);
 	if (htc_mtp_performance_debug)
@@ -976,7 +1055,7 @@ requeue_req:
 			#if 0
 			req->length = dev->maxsize?dev->maxsize:512;
 			#endif
-			req->length = MTP_BULK_BUFFER_SIZE;
+			req->length = dev->rx_req_len;
 			DBG(cdev, "%s: queue request(%p) on %s\n", __func__, req, dev->ep_out->name);
 			ret = usb_ep_queue(dev->ep_out, req, GFP_ATOMIC);
 			if (ret < 0) {
@@ -1016,11 +1095,10 @@ requeue_req:
 			if (dev->read_count == 0 && dev->rx_req) {
 				mtp_req_put(dev, &dev->rx_idle, dev->rx_req);
 				dev->rx_req = 0;
-			}
 
-			
-			if (xfer < MTP_BULK_BUFFER_SIZE) {
-				break;
+				
+				if (dev->rx_short)
+					break;
 			}
 			continue;
 		}
@@ -1036,13 +1114,13 @@ requeue_req:
 				if (file_xfer_zlp_flag == 0)
 					goto requeue_req;
 
-				dev->rx_req = req;
-				mtp_req_put(dev, &dev->rx_idle, dev->rx_req);
+				mtp_req_put(dev, &dev->rx_idle, req);
 				INFO(cdev, "%s: got ZLP while file xfer.\n", __func__);
 				break;
 			}
 
 			dev->rx_req = req;
+			dev->rx_short = req->actual < req->length;
 			dev->read_count = req->actual;
 			dev->read_buf = req->buf;
 		}
@@ -1054,6 +1132,7 @@ requeue_req:
 	}
 
 done:
+	mtp_rx_drop(dev);
 	DBG(cdev, "receive_file_work returning %d\n", r);
 	if (htc_mtp_performance_debug) {
 		do_gettimeofday(&dev->st1);
@@ -1437,6 +1516,7 @@ mtp_function_unbind(struct usb_configuration *c, struct usb_function *f)
 
 	
 	usb_ep_nuke(dev->ep_out);
+	mtp_rx_drop(dev);
 
 	while ((req = mtp_req_get(dev, &dev->rx_idle))) {
 		DBG(dev->cdev, "%s: rx_idle release (%p)\n", __func__, req);
@@ -18,6 +18,8 @@
 #include <linux/ctype.h>
 #include <linux/etherdevice.h>
 #include <linux/ethtool.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "u_ether.h"
 
@@ -25,7 +27,9 @@
 
 #define UETH__VERSION	"29-May-2008"
 
-static struct workqueue_struct	*uether_wq;
+#define UETH_NAPI_WEIGHT	64
+
+#define UETH_HIST_SLOTS		8
 
 struct eth_dev {
 	spinlock_t		lock;
@@ -41,6 +45,7 @@ struct eth_dev {
 	int			no_tx_req_used;
 	int			tx_skb_hold_count;
 	u32			tx_req_bufsize;
+	unsigned int		dl_aggr_pkts;
 
 	struct sk_buff_head	rx_frames;
 
@@ -53,7 +58,10 @@ struct eth_dev {
 						struct sk_buff_head *list);
 
 	struct work_struct	work;
-	struct work_struct	rx_work;
+	struct napi_struct	napi;
+
+	unsigned long		ul_pkts_hist[UETH_HIST_SLOTS];
+	unsigned long		dl_pkts_hist[UETH_HIST_SLOTS];
 
 	unsigned long		todo;
 #define	WORK_RX_MEMORY		0
@@ -72,6 +80,10 @@ static unsigned qmult = 10;
 module_param(qmult, uint, S_IRUGO|S_IWUSR);
 MODULE_PARM_DESC(qmult, "queue length multiplier at high/super speed");
 
+static bool dl_aggr_adaptive = 1;
+module_param(dl_aggr_adaptive, bool, S_IRUGO|S_IWUSR);
+MODULE_PARM_DESC(dl_aggr_adaptive, "adapt packets per IN transfer to load");
+
 static inline int qlen(struct usb_gadget *gadget)
 {
 	if (gadget_is_dualspeed(gadget) && (gadget->speed == USB_SPEED_HIGH ||
@@ -169,6 +181,37 @@ static void defer_kevent(struct eth_dev *dev, int flag)
 		DBG(dev, "kevent %d scheduled\n", flag);
 }
 
+static inline void ueth_hist_add(unsigned long *hist, unsigned int pkts)
+{
+	if (pkts)
+		hist[min_t(unsigned int, fls(pkts) - 1, UETH_HIST_SLOTS - 1)]++;
+}
+
+/*
+ * Called with req_lock held whenever an aggregated IN transfer is sent.
+ * The aggregation target doubles while transfers leave full with the
+ * pipeline backed up, and halves whenever one has to leave short, i.e.
+ * when a packet sat in it waiting for company.
+ */
+static void eth_dl_aggr_update(struct eth_dev *dev, unsigned int pkts,
+			       bool busy)
+{
+	ueth_hist_add(dev->dl_pkts_hist, pkts);
+
+	if (!dl_aggr_adaptive) {
+		dev->dl_aggr_pkts = dev->dl_max_pkts_per_xfer;
+		return;
+	}
+
+	if (pkts >= dev->dl_aggr_pkts) {
+		if (busy)
+			dev->dl_aggr_pkts = min(dev->dl_aggr_pkts * 2,
+						dev->dl_max_pkts_per_xfer);
+	} else if (dev->dl_aggr_pkts > 1) {
+		dev->dl_aggr_pkts /= 2;
+	}
+}
+
 static void rx_complete(struct usb_ep *ep, struct usb_request *req);
 static void tx_complete(struct usb_ep *ep, struct usb_request *req);
 
@@ -242,13 +285,15 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 		skb_put(skb, req->actual);
 
 		if (dev->unwrap) {
+			struct sk_buff_head	frames;
 			unsigned long	flags;
 
+			skb_queue_head_init(&frames);
 			spin_lock_irqsave(&dev->lock, flags);
 			if (dev->port_usb) {
 				status = dev->unwrap(dev->port_usb,
 							skb,
-							&dev->rx_frames);
+							&frames);
 				if (status == -EINVAL)
 					dev->net->stats.rx_errors++;
 				else if (status == -EOVERFLOW)
@@ -258,7 +303,14 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 				status = -ENOTCONN;
 			}
 			spin_unlock_irqrestore(&dev->lock, flags);
+
+			ueth_hist_add(dev->ul_pkts_hist,
+				      skb_queue_len(&frames));
+			spin_lock_irqsave(&dev->rx_frames.lock, flags);
+			skb_queue_splice_tail(&frames, &dev->rx_frames);
+			spin_unlock_irqrestore(&dev->rx_frames.lock, flags);
 		} else {
+			ueth_hist_add(dev->ul_pkts_hist, 1);
 			skb_queue_tail(&dev->rx_frames, skb);
 		}
 
@@ -300,7 +352,7 @@ clean:
 	spin_unlock(&dev->req_lock);
 
 	if (queue)
-		queue_work(uether_wq, &dev->rx_work);
+		napi_schedule(&dev->napi);
 }
 
 static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
@@ -405,23 +457,21 @@ static void rx_fill(struct eth_dev *dev, gfp_t gfp_flags)
 	spin_unlock_irqrestore(&dev->req_lock, flags);
 }
 
-static void process_rx_w(struct work_struct *work)
+static int eth_poll(struct napi_struct *napi, int budget)
 {
-	struct eth_dev	*dev = container_of(work, struct eth_dev, rx_work);
+	struct eth_dev	*dev = container_of(napi, struct eth_dev, napi);
 	struct sk_buff	*skb;
-	int		status = 0;
+	int		work_done = 0;
 	unsigned int uiCurMtu = 0;
 
-	if (!dev->port_usb)
-		return;
-
 	uiCurMtu = dev->net->mtu + ETH_HLEN;
 	if ((uiCurMtu <= ETH_HLEN) || (uiCurMtu > ETH_FRAME_LEN_MAX))
 	    uiCurMtu = ETH_FRAME_LEN;
 
-	while ((skb = skb_dequeue(&dev->rx_frames))) {
-		if (status < 0
-				|| ETH_HLEN > skb->len
+	while (work_done < budget &&
+	       (skb = skb_dequeue(&dev->rx_frames))) {
+		work_done++;
+		if (ETH_HLEN > skb->len
 			
 			    || skb->len > uiCurMtu) {
 			dev->net->stats.rx_errors++;
@@ -434,11 +484,20 @@ static void process_rx_w(struct work_struct *work)
 		dev->net->stats.rx_packets++;
 		dev->net->stats.rx_bytes += skb->len;
 
-		status = netif_rx_ni(skb);
+		netif_receive_skb(skb);
+	}
+
+	if (dev->port_usb && netif_running(dev->net))
+		rx_fill(dev, GFP_ATOMIC);
+
+	if (work_done < budget) {
+		napi_complete(napi);
+		
+		if (!skb_queue_empty(&dev->rx_frames))
+			napi_schedule(napi);
 	}
 
-	if (netif_running(dev->net))
-		rx_fill(dev, GFP_KERNEL);
+	return work_done;
 }
 
 static void eth_work(struct work_struct *work)
@@ -505,6 +564,11 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 			new_req = container_of(dev->tx_reqs.next,
 					struct usb_request, list);
 			list_del(&new_req->list);
+			if (new_req->length > 0) {
+				eth_dl_aggr_update(dev, dev->tx_skb_hold_count,
+						   false);
+				dev->tx_skb_hold_count = 0;
+			}
 			spin_unlock(&dev->req_lock);
 			if (new_req->length > 0) {
 				length = new_req->length;
@@ -696,7 +760,7 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 
 		spin_lock_irqsave(&dev->req_lock, flags);
 		dev->tx_skb_hold_count++;
-		if (dev->tx_skb_hold_count < dev->dl_max_pkts_per_xfer) {
+		if (dev->tx_skb_hold_count < dev->dl_aggr_pkts) {
 			if (dev->no_tx_req_used > TX_REQ_THRESHOLD) {
 				list_add(&req->list, &dev->tx_reqs);
 				spin_unlock_irqrestore(&dev->req_lock, flags);
@@ -704,11 +768,14 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 			}
 		}
 
+		eth_dl_aggr_update(dev, dev->tx_skb_hold_count,
+				   dev->no_tx_req_used > TX_REQ_THRESHOLD);
 		dev->no_tx_req_used++;
 		dev->tx_skb_hold_count = 0;
 		spin_unlock_irqrestore(&dev->req_lock, flags);
 	} else {
 		spin_unlock_irqrestore(&dev->lock, flags);
+		ueth_hist_add(dev->dl_pkts_hist, 1);
 		length = skb->len;
 		req->buf = skb->data;
 		req->context = skb;
@@ -786,6 +853,7 @@ static int eth_open(struct net_device *net)
 	struct gether	*link;
 
 	DBG(dev, "%s\n", __func__);
+	napi_enable(&dev->napi);
 	if (netif_carrier_ok(dev->net))
 		eth_start(dev, GFP_KERNEL);
 
@@ -805,6 +873,8 @@ static int eth_stop(struct net_device *net)
 
 	VDBG(dev, "%s\n", __func__);
 	netif_stop_queue(net);
+	napi_disable(&dev->napi);
+	skb_queue_purge(&dev->rx_frames);
 
 	DBG(dev, "stop stats: rx/tx %ld/%ld, errs %ld/%ld\n",
 		dev->net->stats.rx_packets, dev->net->stats.tx_packets,
@@ -890,6 +960,78 @@ static struct device_type gadget_type = {
 	.name	= "gadget",
 };
 
+#if defined(CONFIG_DEBUG_FS)
+static struct dentry *ueth_dent;
+
+static int ueth_hist_show(struct seq_file *s, void *unused)
+{
+	struct eth_dev	*dev = s->private;
+	int		i;
+
+	seq_printf(s, "dl_aggr_pkts: %u (max %u)\n",
+		   dev->dl_aggr_pkts, dev->dl_max_pkts_per_xfer);
+	seq_printf(s, "%-10s %12s %12s\n", "pkts/xfer", "ul", "dl");
+	for (i = 0; i < UETH_HIST_SLOTS; i++) {
+		char	range[16];
+
+		if (i == 0)
+			snprintf(range, sizeof(range), "1");
+		else if (i == UETH_HIST_SLOTS - 1)
+			snprintf(range, sizeof(range), "%u+", 1U << i);
+		else
+			snprintf(range, sizeof(range), "%u-%u",
+				 1U << i, (2U << i) - 1);
+		seq_printf(s, "%-10s %12lu %12lu\n", range,
+			   dev->ul_pkts_hist[i], dev->dl_pkts_hist[i]);
+	}
+
+	return 0;
+}
+
+static int ueth_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ueth_hist_show, inode->i_private);
+}
+
+static ssize_t ueth_hist_reset(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct eth_dev	*dev = ((struct seq_file *)file->private_data)->private;
+
+	memset(dev->ul_pkts_hist, 0, sizeof(dev->ul_pkts_hist));
+	memset(dev->dl_pkts_hist, 0, sizeof(dev->dl_pkts_hist));
+
+	return count;
+}
+
+static const struct file_operations ueth_hist_ops = {
+	.open = ueth_hist_open,
+	.read = seq_read,
+	.write = ueth_hist_reset,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void ueth_debugfs_init(struct eth_dev *dev)
+{
+	ueth_dent = debugfs_create_dir("u_ether", 0);
+	if (!ueth_dent || IS_ERR(ueth_dent))
+		return;
+
+	debugfs_create_file("pkts_per_xfer", S_IRUGO | S_IWUSR, ueth_dent,
+			    dev, &ueth_hist_ops);
+}
+
+static void ueth_debugfs_remove(void)
+{
+	debugfs_remove_recursive(ueth_dent);
+	ueth_dent = NULL;
+}
+#else
+static inline void ueth_debugfs_init(struct eth_dev *dev) {}
+static inline void ueth_debugfs_remove(void) {}
+#endif
+
 int gether_setup(struct usb_gadget *g, u8 ethaddr[ETH_ALEN])
 {
 	return gether_setup_name(g, ethaddr, "usb");
@@ -920,11 +1062,11 @@ int gether_setup_name(struct usb_gadget *g, u8 ethaddr[ETH_ALEN],
 	spin_lock_init(&dev->lock);
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
-	INIT_WORK(&dev->rx_work, process_rx_w);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
 	skb_queue_head_init(&dev->rx_frames);
+	netif_napi_add(net, &dev->napi, eth_poll, UETH_NAPI_WEIGHT);
 
 	
 	dev->net = net;
@@ -963,6 +1105,7 @@ int gether_setup_name(struct usb_gadget *g, u8 ethaddr[ETH_ALEN],
                 the_dev->net->mtu = ETH_FRAME_LEN_MAX - ETH_HLEN;
         }
 		netif_carrier_off(net);
+		ueth_debugfs_init(dev);
 	}
 
 	return status;
@@ -973,8 +1116,10 @@ void gether_cleanup(void)
 	if (!the_dev)
 		return;
 
+	ueth_debugfs_remove();
 	unregister_netdev(the_dev->net);
 	flush_work_sync(&the_dev->work);
+	netif_napi_del(&the_dev->napi);
 	free_netdev(the_dev->net);
 
 	the_dev = NULL;
@@ -1047,6 +1192,8 @@ struct net_device *gether_connect(struct gether *link)
 		dev->wrap = link->wrap;
 		dev->ul_max_pkts_per_xfer = link->ul_max_pkts_per_xfer;
 		dev->dl_max_pkts_per_xfer = link->dl_max_pkts_per_xfer;
+		dev->dl_aggr_pkts = dl_aggr_adaptive ? 1 :
+					dev->dl_max_pkts_per_xfer;
 
 		spin_lock(&dev->lock);
 		dev->tx_skb_hold_count = 0;
@@ -1153,22 +1300,5 @@ void gether_disconnect(struct gether *link)
 	spin_unlock(&dev->lock);
 }
 
-static int __init gether_init(void)
-{
-	uether_wq  = create_singlethread_workqueue("uether");
-	if (!uether_wq) {
-		pr_err("%s: Unable to create workqueue: uether\n", __func__);
-		return -ENOMEM;
-	}
-	return 0;
-}
-module_init(gether_init);
-
-static void __exit gether_exit(void)
-{
-	destroy_workqueue(uether_wq);
-
-}
-module_exit(gether_exit);
 MODULE_DESCRIPTION("ethernet over USB driver");
 MODULE_LICENSE("GPL v2");
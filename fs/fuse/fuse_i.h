@@ -25,6 +25,8 @@
 
 #define FUSE_MAX_PAGES_PER_REQ 32
 
+#define FUSE_SUPER_MAGIC 0x65735546
+
 #define FUSE_NOWRITE INT_MIN
 
 #define FUSE_NAME_MAX 1024
@@ -80,6 +82,14 @@ struct fuse_inode {
 
 	
 	struct list_head writepages;
+
+	
+	unsigned long state;
+};
+
+enum {
+	
+	FUSE_I_MTIME_DIRTY,
 };
 
 struct fuse_conn;
@@ -117,6 +127,9 @@ struct fuse_file {
 
 	
 	bool flock:1;
+
+	
+	struct file *passthrough_filp;
 };
 
 struct fuse_in_arg {
@@ -268,6 +281,9 @@ struct fuse_req {
 
 	
 	struct file *stolen_file;
+
+	
+	struct file *passthrough_filp;
 };
 
 struct fuse_conn {
@@ -418,6 +434,15 @@ struct fuse_conn {
 	unsigned no_flock:1;
 
 	
+	unsigned passthrough:1;
+
+	
+	unsigned passthrough_allowed:1;
+
+	
+	unsigned writeback_cache:1;
+
+	
 	atomic_t num_waiting;
 
 	
@@ -611,4 +636,14 @@ int fuse_dev_release(struct inode *inode, struct file *file);
 
 void fuse_write_update_size(struct inode *inode, loff_t pos);
 
+int fuse_flush_mtime(struct file *file, bool nofail);
+
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_req *req);
+ssize_t fuse_passthrough_aio_read(struct kiocb *iocb, const struct iovec *iov,
+				  unsigned long nr_segs, loff_t pos);
+ssize_t fuse_passthrough_aio_write(struct kiocb *iocb, const struct iovec *iov,
+				   unsigned long nr_segs, loff_t pos);
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma);
+void fuse_passthrough_release(struct fuse_file *ff);
+
 #endif 
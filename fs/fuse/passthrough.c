@@ -0,0 +1,172 @@
+/*
+  FUSE: Filesystem in Userspace
+  Passthrough of read/write/mmap to a daemon supplied backing file
+
+  This program can be distributed under the terms of the GNU GPL.
+  See the file COPYING.
+*/
+
+#include "fuse_i.h"
+#include "../read_write.h"
+
+#include <linux/file.h>
+#include <linux/fsnotify.h>
+#include <linux/aio.h>
+#include <linux/uio.h>
+#include <linux/cred.h>
+
+/*
+ * Called in the context of the daemon writing an OPEN or CREATE reply, so
+ * that the descriptor is resolved against the daemon's file table.
+ */
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_req *req)
+{
+	struct fuse_open_out *open_out;
+	struct file *lower;
+	struct inode *inode;
+
+	if (!fc->passthrough)
+		return;
+
+	switch (req->in.h.opcode) {
+	case FUSE_OPEN:
+		open_out = req->out.args[0].value;
+		break;
+	case FUSE_CREATE:
+		open_out = req->out.args[1].value;
+		break;
+	default:
+		return;
+	}
+
+	if (!(open_out->open_flags & FOPEN_PASSTHROUGH))
+		return;
+	open_out->open_flags &= ~FOPEN_PASSTHROUGH;
+
+	lower = fget(open_out->passthrough_fd);
+	if (!lower)
+		return;
+
+	inode = lower->f_path.dentry->d_inode;
+	if (!S_ISREG(inode->i_mode) ||
+	    inode->i_sb->s_magic == FUSE_SUPER_MAGIC ||
+	    !lower->f_op || !lower->f_op->aio_read || !lower->f_op->aio_write) {
+		fput(lower);
+		return;
+	}
+
+	req->passthrough_filp = lower;
+}
+
+void fuse_passthrough_release(struct fuse_file *ff)
+{
+	if (ff->passthrough_filp) {
+		fput(ff->passthrough_filp);
+		ff->passthrough_filp = NULL;
+	}
+}
+
+/*
+ * Same checks and notifications as vfs_readv()/vfs_writev() on the lower
+ * file: its open mode, mandatory locks and the LSM hook run against the
+ * daemon's credentials the file was opened with.
+ */
+static ssize_t fuse_passthrough_rw(struct file *lower, const struct iovec *iov,
+				   unsigned long nr_segs, loff_t *ppos,
+				   int write)
+{
+	const struct cred *old_cred;
+	size_t len = iov_length(iov, nr_segs);
+	int type = write ? WRITE : READ;
+	ssize_t ret;
+
+	if (!(lower->f_mode & (write ? FMODE_WRITE : FMODE_READ)))
+		return -EBADF;
+
+	old_cred = override_creds(lower->f_cred);
+
+	ret = rw_verify_area(type, lower, ppos, len);
+	if (ret >= 0)
+		ret = do_sync_readv_writev(lower, iov, nr_segs, ret, ppos,
+					   write ? lower->f_op->aio_write :
+						   lower->f_op->aio_read);
+
+	revert_creds(old_cred);
+
+	if (ret > 0) {
+		if (write)
+			fsnotify_modify(lower);
+		else
+			fsnotify_access(lower);
+	}
+
+	return ret;
+}
+
+ssize_t fuse_passthrough_aio_read(struct kiocb *iocb, const struct iovec *iov,
+				  unsigned long nr_segs, loff_t pos)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	ssize_t ret;
+
+	ret = fuse_passthrough_rw(ff->passthrough_filp, iov, nr_segs, &pos, 0);
+	if (ret >= 0)
+		iocb->ki_pos = pos;
+
+	file_accessed(file);
+
+	return ret;
+}
+
+ssize_t fuse_passthrough_aio_write(struct kiocb *iocb, const struct iovec *iov,
+				   unsigned long nr_segs, loff_t pos)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	struct inode *inode = file->f_dentry->d_inode;
+	ssize_t ret;
+
+	if (file->f_flags & O_APPEND)
+		pos = i_size_read(ff->passthrough_filp->f_path.dentry->d_inode);
+
+	ret = fuse_passthrough_rw(ff->passthrough_filp, iov, nr_segs, &pos, 1);
+	if (ret > 0) {
+		iocb->ki_pos = pos;
+		fuse_write_update_size(inode, pos);
+		invalidate_inode_pages2_range(inode->i_mapping,
+			(pos - ret) >> PAGE_CACHE_SHIFT,
+			(pos - 1) >> PAGE_CACHE_SHIFT);
+	}
+
+	fuse_invalidate_attr(inode);
+
+	return ret;
+}
+
+/*
+ * Map the backing file directly.  mmap_region() already holds a reference
+ * on @file for the vma; swap it for one on the lower file on success, and
+ * leave the vma untouched on failure so the caller's cleanup stays valid.
+ */
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *lower = ff->passthrough_filp;
+	int err;
+
+	if (!lower->f_op->mmap)
+		return -ENODEV;
+
+	get_file(lower);
+	vma->vm_file = lower;
+	err = lower->f_op->mmap(lower, vma);
+	if (err) {
+		vma->vm_file = file;
+		fput(lower);
+		return err;
+	}
+
+	fput(file);
+	return 0;
+}
@@ -256,6 +256,7 @@ int rw_verify_area(int read_write, struct file *file, loff_t *ppos, size_t count
 		return retval;
 	return count > MAX_RW_COUNT ? MAX_RW_COUNT : count;
 }
+EXPORT_SYMBOL(rw_verify_area);
 
 static void wait_on_retry_sync_kiocb(struct kiocb *iocb)
 {
@@ -672,6 +673,7 @@ ssize_t do_sync_readv_writev(struct file *filp, const struct iovec *iov,
 	*ppos = kiocb.ki_pos;
 	return ret;
 }
+EXPORT_SYMBOL(do_sync_readv_writev);
 
 ssize_t do_loop_readv_writev(struct file *filp, struct iovec *iov,
 		unsigned long nr_segs, loff_t *ppos, io_fn_t fn)
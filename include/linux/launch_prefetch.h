@@ -0,0 +1,31 @@
+#ifndef _LINUX_LAUNCH_PREFETCH_H
+#define _LINUX_LAUNCH_PREFETCH_H
+
+#include <linux/fs.h>
+#include <linux/sched.h>
+
+#ifdef CONFIG_LAUNCH_PREFETCH
+
+extern pid_t launch_prefetch_tgid;
+
+extern void __launch_prefetch_record(struct file *file, pgoff_t start,
+				     unsigned long nr);
+
+static inline void launch_prefetch_record(struct file *file, pgoff_t start,
+					  unsigned long nr)
+{
+	if (unlikely(launch_prefetch_tgid) &&
+	    current->tgid == launch_prefetch_tgid)
+		__launch_prefetch_record(file, start, nr);
+}
+
+#else
+
+static inline void launch_prefetch_record(struct file *file, pgoff_t start,
+					  unsigned long nr)
+{
+}
+
+#endif
+
+#endif
@@ -160,6 +160,9 @@ struct vm_area_struct {
 #ifndef CONFIG_MMU
 	struct vm_region *vm_region;	
 #endif
+#ifdef CONFIG_SWAP
+	atomic_long_t swap_readahead_info;
+#endif
 #ifdef CONFIG_NUMA
 	struct mempolicy *vm_policy;	
 #endif
@@ -0,0 +1,103 @@
+#ifndef _LINUX_MM_PAGE_IDLE_H
+#define _LINUX_MM_PAGE_IDLE_H
+
+#include <linux/bitops.h>
+#include <linux/mm.h>
+
+#ifdef CONFIG_IDLE_PAGE_TRACKING
+
+extern unsigned long *page_idle_flags;
+extern unsigned long page_idle_start_pfn;
+extern unsigned long page_idle_end_pfn;
+
+#define PAGE_IDLE_BIT	0
+#define PAGE_YOUNG_BIT	1
+
+static inline long page_idle_index(struct page *page)
+{
+	unsigned long pfn = page_to_pfn(page);
+
+	if (unlikely(!page_idle_flags || pfn < page_idle_start_pfn ||
+		     pfn >= page_idle_end_pfn))
+		return -1;
+	return 2 * (pfn - page_idle_start_pfn);
+}
+
+static inline bool page_is_young(struct page *page)
+{
+	long i = page_idle_index(page);
+
+	return i >= 0 && test_bit(i + PAGE_YOUNG_BIT, page_idle_flags);
+}
+
+static inline void set_page_young(struct page *page)
+{
+	long i = page_idle_index(page);
+
+	if (i >= 0)
+		set_bit(i + PAGE_YOUNG_BIT, page_idle_flags);
+}
+
+static inline bool test_and_clear_page_young(struct page *page)
+{
+	long i = page_idle_index(page);
+
+	return i >= 0 &&
+	       test_and_clear_bit(i + PAGE_YOUNG_BIT, page_idle_flags);
+}
+
+static inline bool page_is_idle(struct page *page)
+{
+	long i = page_idle_index(page);
+
+	return i >= 0 && test_bit(i + PAGE_IDLE_BIT, page_idle_flags);
+}
+
+static inline void set_page_idle(struct page *page)
+{
+	long i = page_idle_index(page);
+
+	if (i >= 0)
+		set_bit(i + PAGE_IDLE_BIT, page_idle_flags);
+}
+
+static inline void clear_page_idle(struct page *page)
+{
+	long i = page_idle_index(page);
+
+	if (i >= 0 && test_bit(i + PAGE_IDLE_BIT, page_idle_flags))
+		clear_bit(i + PAGE_IDLE_BIT, page_idle_flags);
+}
+
+#else
+
+static inline bool page_is_young(struct page *page)
+{
+	return false;
+}
+
+static inline void set_page_young(struct page *page)
+{
+}
+
+static inline bool test_and_clear_page_young(struct page *page)
+{
+	return false;
+}
+
+static inline bool page_is_idle(struct page *page)
+{
+	return false;
+}
+
+static inline void set_page_idle(struct page *page)
+{
+}
+
+static inline void clear_page_idle(struct page *page)
+{
+}
+
+#endif
+
+#endif
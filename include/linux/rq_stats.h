@@ -12,11 +12,7 @@
  */
 
 struct rq_data {
-	unsigned int rq_avg;
-	unsigned long rq_poll_jiffies;
 	unsigned long def_timer_jiffies;
-	unsigned long rq_poll_last_jiffy;
-	unsigned long rq_poll_total_jiffies;
 	unsigned long def_timer_last_jiffy;
 	unsigned int def_interval;
 	unsigned int hotplug_disabled;
@@ -27,6 +23,4 @@ struct rq_data {
 	int init;
 };
 
-extern spinlock_t rq_lock;
 extern struct rq_data rq_info;
-extern struct workqueue_struct *rq_wq;
@@ -90,6 +90,7 @@ struct bio_list;
 struct fs_struct;
 struct perf_event_context;
 struct blk_plug;
+struct notifier_block;
 
 #define CLONE_KERNEL	(CLONE_FS | CLONE_FILES | CLONE_SIGHAND)
 
@@ -119,7 +120,12 @@ extern unsigned long nr_iowait_cpu(int cpu);
 extern unsigned long this_cpu_load(void);
 
 extern void sched_update_nr_prod(int cpu, unsigned long nr, bool inc);
-extern void sched_get_nr_running_avg(int *avg, int *iowait_avg);
+extern void sched_get_nr_running_avg_decayed(int *avg, int *iowait_avg);
+extern int sched_get_cpu_nr_running_avg(int cpu);
+extern int sched_register_nr_running_avg_notifier(struct notifier_block *nb);
+extern int sched_unregister_nr_running_avg_notifier(struct notifier_block *nb);
+extern unsigned int sched_get_nr_running_avg_period(void);
+extern void sched_set_nr_running_avg_period(unsigned int ms);
 
 extern void calc_global_load(unsigned long ticks);
 
@@ -879,6 +885,7 @@ struct sched_class {
 
 #ifdef CONFIG_SMP
 	int  (*select_task_rq)(struct task_struct *p, int sd_flag, int flags);
+	void (*migrate_task_rq)(struct task_struct *p, int next_cpu);
 
 	void (*pre_schedule) (struct rq *this_rq, struct task_struct *task);
 	void (*post_schedule) (struct rq *this_rq);
@@ -913,6 +920,14 @@ struct load_weight {
 	unsigned long weight, inv_weight;
 };
 
+struct sched_avg {
+	u32 runnable_avg_sum, runnable_avg_period;
+	u64 last_runnable_update;
+	u64 sleep_stamp;
+	unsigned long load_avg_contrib;
+	int rebase_clock;
+};
+
 #ifdef CONFIG_SCHEDSTATS
 struct sched_statistics {
 	u64			wait_start;
@@ -962,6 +977,8 @@ struct sched_entity {
 
 	u64			nr_migrations;
 
+	struct sched_avg	avg;
+
 #ifdef CONFIG_SCHEDSTATS
 	struct sched_statistics statistics;
 #endif
@@ -1719,6 +1736,13 @@ extern int task_nice(const struct task_struct *p);
 extern int can_nice(const struct task_struct *p, const int nice);
 extern int task_curr(const struct task_struct *p);
 extern int idle_cpu(int cpu);
+#ifdef CONFIG_SMP
+extern void sched_set_idle_exit_latency(unsigned int latency_us);
+#else
+static inline void sched_set_idle_exit_latency(unsigned int latency_us)
+{
+}
+#endif
 extern int sched_setscheduler(struct task_struct *, int,
 			      const struct sched_param *);
 extern int sched_setscheduler_nocheck(struct task_struct *, int,
@@ -2203,6 +2227,14 @@ static inline void set_task_cpu(struct task_struct *p, unsigned int cpu)
 
 extern struct atomic_notifier_head migration_notifier_head;
 
+struct migration_notify_data {
+	int src_cpu;
+	int dest_cpu;
+	int load;
+};
+
+extern unsigned int task_load_pct(struct task_struct *p);
+
 extern long sched_setaffinity(pid_t pid, const struct cpumask *new_mask);
 extern long sched_getaffinity(pid_t pid, struct cpumask *mask);
 
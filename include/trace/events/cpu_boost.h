@@ -0,0 +1,84 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cpu_boost
+
+#if !defined(_TRACE_CPU_BOOST_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_CPU_BOOST_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(cpu_boost_migration,
+	TP_PROTO(int src_cpu, int dest_cpu, int load,
+		 unsigned int src_freq, unsigned int boost_freq),
+	TP_ARGS(src_cpu, dest_cpu, load, src_freq, boost_freq),
+
+	TP_STRUCT__entry(
+	    __field(int,          src_cpu    )
+	    __field(int,          dest_cpu   )
+	    __field(int,          load       )
+	    __field(unsigned int, src_freq   )
+	    __field(unsigned int, boost_freq )
+	),
+
+	TP_fast_assign(
+	    __entry->src_cpu = src_cpu;
+	    __entry->dest_cpu = dest_cpu;
+	    __entry->load = load;
+	    __entry->src_freq = src_freq;
+	    __entry->boost_freq = boost_freq;
+	),
+
+	TP_printk("src=%d dest=%d load=%d src_freq=%u boost=%u",
+		  __entry->src_cpu, __entry->dest_cpu, __entry->load,
+		  __entry->src_freq, __entry->boost_freq)
+);
+
+TRACE_EVENT(cpu_boost_input,
+	TP_PROTO(unsigned int cpu, unsigned int stage, unsigned int freq),
+	TP_ARGS(cpu, stage, freq),
+
+	TP_STRUCT__entry(
+	    __field(unsigned int, cpu   )
+	    __field(unsigned int, stage )
+	    __field(unsigned int, freq  )
+	),
+
+	TP_fast_assign(
+	    __entry->cpu = cpu;
+	    __entry->stage = stage;
+	    __entry->freq = freq;
+	),
+
+	TP_printk("cpu=%u stage=%u freq=%u",
+		  __entry->cpu, __entry->stage, __entry->freq)
+);
+
+DECLARE_EVENT_CLASS(cpu_boost_rem,
+	TP_PROTO(unsigned int cpu, unsigned int freq),
+	TP_ARGS(cpu, freq),
+
+	TP_STRUCT__entry(
+	    __field(unsigned int, cpu  )
+	    __field(unsigned int, freq )
+	),
+
+	TP_fast_assign(
+	    __entry->cpu = cpu;
+	    __entry->freq = freq;
+	),
+
+	TP_printk("cpu=%u freq=%u", __entry->cpu, __entry->freq)
+);
+
+DEFINE_EVENT(cpu_boost_rem, cpu_boost_decay,
+	TP_PROTO(unsigned int cpu, unsigned int freq),
+	TP_ARGS(cpu, freq)
+);
+
+DEFINE_EVENT(cpu_boost_rem, cpu_boost_input_rem,
+	TP_PROTO(unsigned int cpu, unsigned int freq),
+	TP_ARGS(cpu, freq)
+);
+
+#endif
+
+#include <trace/define_trace.h>
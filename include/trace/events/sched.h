@@ -128,6 +128,26 @@ static inline long __trace_sched_switch_state(struct task_struct *p)
 }
 #endif
 
+TRACE_EVENT(sched_get_nr_running_avg,
+
+	TP_PROTO(int avg, int iowait_avg),
+
+	TP_ARGS(avg, iowait_avg),
+
+	TP_STRUCT__entry(
+		__field(	int,	avg			)
+		__field(	int,	iowait_avg		)
+	),
+
+	TP_fast_assign(
+		__entry->avg		= avg;
+		__entry->iowait_avg	= iowait_avg;
+	),
+
+	TP_printk("avg=%d iowait_avg=%d",
+		__entry->avg, __entry->iowait_avg)
+);
+
 TRACE_EVENT(sched_switch,
 
 	TP_PROTO(struct task_struct *prev,
@@ -439,6 +459,36 @@ TRACE_EVENT(sched_stat_runtime,
 			(unsigned long long)__entry->vruntime)
 );
 
+TRACE_EVENT(sched_task_load_avg,
+
+	TP_PROTO(struct task_struct *tsk, struct sched_avg *avg),
+
+	TP_ARGS(tsk, avg),
+
+	TP_STRUCT__entry(
+		__array( char,	comm,	TASK_COMM_LEN	)
+		__field( pid_t,	pid			)
+		__field( u32,	runnable_sum		)
+		__field( u32,	runnable_period		)
+		__field( unsigned long,	load_contrib	)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->comm, tsk->comm, TASK_COMM_LEN);
+		__entry->pid		= tsk->pid;
+		__entry->runnable_sum	= avg->runnable_avg_sum;
+		__entry->runnable_period = avg->runnable_avg_period;
+		__entry->load_contrib	= avg->load_avg_contrib;
+	),
+
+	TP_printk("comm=%s pid=%d runnable_sum=%u runnable_period=%u load_contrib=%lu load=%u%%",
+			__entry->comm, __entry->pid,
+			__entry->runnable_sum, __entry->runnable_period,
+			__entry->load_contrib,
+			__entry->runnable_sum * 100 /
+				(__entry->runnable_period + 1))
+);
+
 TRACE_EVENT(sched_pi_setprio,
 
 	TP_PROTO(struct task_struct *tsk, int newprio),
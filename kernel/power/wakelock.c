@@ -14,26 +14,30 @@
 #include <linux/err.h>
 #include <linux/hrtimer.h>
 #include <linux/list.h>
-#include <linux/rbtree.h>
+#include <linux/rculist.h>
+#include <linux/hash.h>
 #include <linux/slab.h>
 #include <linux/syscalls.h>
+#include <linux/fs.h>
+#include <linux/backing-dev.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
 
 #include <linux/suspend.h>
 
 static int suspend_sys_sync_count;
 static DEFINE_SPINLOCK(suspend_sys_sync_lock);
 static struct workqueue_struct *suspend_sys_sync_work_queue;
+static struct workqueue_struct *suspend_sync_bdi_work_queue;
 static DECLARE_COMPLETION(suspend_sys_sync_comp);
 
 static DEFINE_MUTEX(wakelocks_lock);
 
 struct wakelock {
 	char			*name;
-	struct rb_node		node;
+	struct hlist_node	node;
+	atomic_t		ref;
 	struct wakeup_source	ws;
-#ifdef CONFIG_PM_WAKELOCKS_GC
-	struct list_head	lru;
-#endif
 };
 
 static int __init sys_sync_queue_init(void)
@@ -47,36 +51,62 @@ static int __init sys_sync_queue_init(void)
 		ret = -ENOMEM;
 	}
 
+	suspend_sync_bdi_work_queue =
+		alloc_workqueue("suspend_sync_bdi", WQ_UNBOUND, 0);
+	if (suspend_sync_bdi_work_queue == NULL)
+		ret = -ENOMEM;
+
 	return ret;
 }
 
 static void  __exit sys_sync_queue_exit(void)
 {
+	destroy_workqueue(suspend_sync_bdi_work_queue);
 	destroy_workqueue(suspend_sys_sync_work_queue);
 }
 
-static struct rb_root wakelocks_tree = RB_ROOT;
+#define WL_HASH_BITS	6
+#define WL_HASH_SIZE	(1 << WL_HASH_BITS)
+
+/*
+ * Lookups are lockless under RCU; wakelocks_lock only serialises creation
+ * and garbage collection.  A wakelock found by a lockless lookup is pinned
+ * through ->ref so that the collector cannot free it under the caller.
+ * The collector briefly drops ->ref to zero while it decides, so a
+ * lockless miss is retried under wakelocks_lock before it is believed.
+ */
+static struct hlist_head wakelocks_hash[WL_HASH_SIZE];
+
+static inline struct hlist_head *wakelock_bucket(const char *name, size_t len)
+{
+	unsigned int hash = full_name_hash((const unsigned char *)name, len);
+
+	return &wakelocks_hash[hash_32(hash, WL_HASH_BITS)];
+}
 
 ssize_t pm_show_wakelocks(char *buf, bool show_active)
 {
-	struct rb_node *node;
+	struct hlist_node *pos;
 	struct wakelock *wl;
 	char *str = buf;
 	char *end = buf + PAGE_SIZE;
+	int i;
 
-	mutex_lock(&wakelocks_lock);
+	rcu_read_lock();
 
-	for (node = rb_first(&wakelocks_tree); node; node = rb_next(node)) {
-		wl = rb_entry(node, struct wakelock, node);
-		if (wl->ws.active == show_active)
-			str += scnprintf(str, end - str, "%s ", wl->name);
+	for (i = 0; i < WL_HASH_SIZE; i++) {
+		hlist_for_each_entry_rcu(wl, pos, &wakelocks_hash[i], node) {
+			if (wl->ws.active == show_active)
+				str += scnprintf(str, end - str, "%s ",
+						 wl->name);
+		}
 	}
 	if (str > buf)
 		str--;
 
 	str += scnprintf(str, end - str, "\n");
 
-	mutex_unlock(&wakelocks_lock);
+	rcu_read_unlock();
 	return (str - buf);
 }
 
@@ -103,87 +133,104 @@ static inline void increment_wakelocks_number(void) {}
 static inline void decrement_wakelocks_number(void) {}
 #endif 
 
+static struct wakelock *wakelock_lookup_get(const char *name, size_t len)
+{
+	struct hlist_node *pos;
+	struct wakelock *wl;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(wl, pos, wakelock_bucket(name, len), node) {
+		if (strncmp(name, wl->name, len) || wl->name[len])
+			continue;
+		if (!atomic_inc_not_zero(&wl->ref))
+			break;
+		rcu_read_unlock();
+		return wl;
+	}
+	rcu_read_unlock();
+	return NULL;
+}
+
+static inline void wakelock_put(struct wakelock *wl)
+{
+	atomic_dec(&wl->ref);
+}
+
 #ifdef CONFIG_PM_WAKELOCKS_GC
 #define WL_GC_COUNT_MAX	100
 #define WL_GC_TIME_SEC	300
 
-static LIST_HEAD(wakelocks_lru_list);
-static unsigned int wakelocks_gc_count;
+static atomic_t wakelocks_gc_count = ATOMIC_INIT(0);
 
-static inline void wakelocks_lru_add(struct wakelock *wl)
+static bool wakelock_collectable(struct wakelock *wl, ktime_t now)
 {
-	list_add(&wl->lru, &wakelocks_lru_list);
-}
+	u64 idle_time_ns;
+	bool active;
 
-static inline void wakelocks_lru_most_recent(struct wakelock *wl)
-{
-	list_move(&wl->lru, &wakelocks_lru_list);
+	spin_lock_irq(&wl->ws.lock);
+	idle_time_ns = ktime_to_ns(ktime_sub(now, wl->ws.last_time));
+	active = wl->ws.active;
+	spin_unlock_irq(&wl->ws.lock);
+
+	return !active && idle_time_ns >= ((u64)WL_GC_TIME_SEC * NSEC_PER_SEC);
 }
 
-static void wakelocks_gc(void)
+static void wakelocks_gc_func(struct work_struct *work)
 {
-	struct wakelock *wl, *aux;
+	struct hlist_node *pos, *aux;
+	struct wakelock *wl;
 	ktime_t now;
+	int i;
 
-	if (++wakelocks_gc_count <= WL_GC_COUNT_MAX)
-		return;
+	mutex_lock(&wakelocks_lock);
 
 	now = ktime_get();
-	list_for_each_entry_safe_reverse(wl, aux, &wakelocks_lru_list, lru) {
-		u64 idle_time_ns;
-		bool active;
+	for (i = 0; i < WL_HASH_SIZE; i++) {
+		hlist_for_each_entry_safe(wl, pos, aux, &wakelocks_hash[i],
+					  node) {
+			if (!wakelock_collectable(wl, now))
+				continue;
 
-		spin_lock_irq(&wl->ws.lock);
-		idle_time_ns = ktime_to_ns(ktime_sub(now, wl->ws.last_time));
-		active = wl->ws.active;
-		spin_unlock_irq(&wl->ws.lock);
+			if (atomic_cmpxchg(&wl->ref, 1, 0) != 1)
+				continue;
 
-		if (idle_time_ns < ((u64)WL_GC_TIME_SEC * NSEC_PER_SEC))
-			break;
+			if (!wakelock_collectable(wl, now)) {
+				atomic_set(&wl->ref, 1);
+				continue;
+			}
 
-		if (!active) {
+			hlist_del_rcu(&wl->node);
 			wakeup_source_remove(&wl->ws);
-			rb_erase(&wl->node, &wakelocks_tree);
-			list_del(&wl->lru);
 			kfree(wl->name);
 			kfree(wl);
 			decrement_wakelocks_number();
 		}
 	}
-	wakelocks_gc_count = 0;
+
+	mutex_unlock(&wakelocks_lock);
+}
+
+static DECLARE_WORK(wakelocks_gc_work, wakelocks_gc_func);
+
+static void wakelocks_gc(void)
+{
+	if (atomic_inc_return(&wakelocks_gc_count) <= WL_GC_COUNT_MAX)
+		return;
+
+	atomic_set(&wakelocks_gc_count, 0);
+	schedule_work(&wakelocks_gc_work);
 }
 #else 
-static inline void wakelocks_lru_add(struct wakelock *wl) {}
-static inline void wakelocks_lru_most_recent(struct wakelock *wl) {}
 static inline void wakelocks_gc(void) {}
 #endif 
 
-static struct wakelock *wakelock_lookup_add(const char *name, size_t len,
-					    bool add_if_not_found)
+static struct wakelock *wakelock_lookup_add(const char *name, size_t len)
 {
-	struct rb_node **node = &wakelocks_tree.rb_node;
-	struct rb_node *parent = *node;
 	struct wakelock *wl;
 
-	while (*node) {
-		int diff;
-
-		parent = *node;
-		wl = rb_entry(*node, struct wakelock, node);
-		diff = strncmp(name, wl->name, len);
-		if (diff == 0) {
-			if (wl->name[len])
-				diff = -1;
-			else
-				return wl;
-		}
-		if (diff < 0)
-			node = &(*node)->rb_left;
-		else
-			node = &(*node)->rb_right;
-	}
-	if (!add_if_not_found)
-		return ERR_PTR(-EINVAL);
+	wl = wakelock_lookup_get(name, len);
+	if (wl)
+		return wl;
 
 	if (wakelocks_limit_exceeded())
 		return ERR_PTR(-ENOSPC);
@@ -199,10 +246,9 @@ static struct wakelock *wakelock_lookup_add(const char *name, size_t len,
 		return ERR_PTR(-ENOMEM);
 	}
 	wl->ws.name = wl->name;
+	atomic_set(&wl->ref, 2);
 	wakeup_source_add(&wl->ws);
-	rb_link_node(&wl->node, parent, node);
-	rb_insert_color(&wl->node, &wakelocks_tree);
-	wakelocks_lru_add(wl);
+	hlist_add_head_rcu(&wl->node, wakelock_bucket(name, len));
 	increment_wakelocks_number();
 	return wl;
 }
@@ -229,13 +275,15 @@ int pm_wake_lock(const char *buf)
 			return -EINVAL;
 	}
 
-	mutex_lock(&wakelocks_lock);
-
-	wl = wakelock_lookup_add(buf, len, true);
-	if (IS_ERR(wl)) {
-		ret = PTR_ERR(wl);
-		goto out;
+	wl = wakelock_lookup_get(buf, len);
+	if (!wl) {
+		mutex_lock(&wakelocks_lock);
+		wl = wakelock_lookup_add(buf, len);
+		mutex_unlock(&wakelocks_lock);
+		if (IS_ERR(wl))
+			return PTR_ERR(wl);
 	}
+
 	if (timeout_ns) {
 		u64 timeout_ms = timeout_ns + NSEC_PER_MSEC - 1;
 
@@ -245,10 +293,7 @@ int pm_wake_lock(const char *buf)
 		__pm_stay_awake(&wl->ws);
 	}
 
-	wakelocks_lru_most_recent(wl);
-
- out:
-	mutex_unlock(&wakelocks_lock);
+	wakelock_put(wl);
 	return ret;
 }
 
@@ -256,7 +301,6 @@ int pm_wake_unlock(const char *buf)
 {
 	struct wakelock *wl;
 	size_t len;
-	int ret = 0;
 
 	len = strlen(buf);
 	if (!len)
@@ -268,33 +312,135 @@ int pm_wake_unlock(const char *buf)
 	if (!len)
 		return -EINVAL;
 
-	mutex_lock(&wakelocks_lock);
-
-	wl = wakelock_lookup_add(buf, len, false);
-	if (IS_ERR(wl)) {
-		ret = PTR_ERR(wl);
-		goto out;
+	wl = wakelock_lookup_get(buf, len);
+	if (!wl) {
+		mutex_lock(&wakelocks_lock);
+		wl = wakelock_lookup_get(buf, len);
+		mutex_unlock(&wakelocks_lock);
+		if (!wl)
+			return -EINVAL;
 	}
+
 	__pm_relax(&wl->ws);
+	wakelock_put(wl);
 
-	wakelocks_lru_most_recent(wl);
 	wakelocks_gc();
+	return 0;
+}
 
- out:
-	mutex_unlock(&wakelocks_lock);
-	return ret;
+/*
+ * Instead of a full sys_sync(), only filesystems with dirty inodes are
+ * written back before suspend.  Each backing device is handled by its own
+ * worker so that a slow card does not hold up eMMC, and every worker stops
+ * as soon as a wakeup event makes the suspend attempt pointless.
+ */
+#define SUSPEND_SYNC_MAX_BDI	8
+
+struct suspend_sync_bdi {
+	struct work_struct	work;
+	struct backing_dev_info	*bdi;
+};
+
+struct suspend_sync_scan {
+	int			nr_sb;
+	int			nr_dirty;
+	int			nr_bdi;
+	bool			overflow;
+	struct backing_dev_info	*bdi[SUSPEND_SYNC_MAX_BDI];
+};
+
+static struct suspend_sync_bdi suspend_sync_bdis[SUSPEND_SYNC_MAX_BDI];
+static atomic_t suspend_sync_bdi_pending;
+static bool suspend_sync_aborted;
+static DECLARE_COMPLETION(suspend_sync_bdi_comp);
+
+static bool suspend_sync_sb_dirty(struct super_block *sb)
+{
+	if (sb->s_flags & MS_RDONLY || sb->s_bdi == &noop_backing_dev_info)
+		return false;
+	return sb->s_dirt || bdi_has_dirty_io(sb->s_bdi);
+}
+
+static void suspend_sync_scan_sb(struct super_block *sb, void *arg)
+{
+	struct suspend_sync_scan *scan = arg;
+	int i;
+
+	if (sb->s_flags & MS_RDONLY || sb->s_bdi == &noop_backing_dev_info)
+		return;
+	scan->nr_sb++;
+
+	if (!suspend_sync_sb_dirty(sb))
+		return;
+	scan->nr_dirty++;
+
+	for (i = 0; i < scan->nr_bdi; i++)
+		if (scan->bdi[i] == sb->s_bdi)
+			return;
+	if (scan->nr_bdi == SUSPEND_SYNC_MAX_BDI) {
+		scan->overflow = true;
+		return;
+	}
+	scan->bdi[scan->nr_bdi++] = sb->s_bdi;
+}
+
+static void suspend_sync_one_sb(struct super_block *sb, void *arg)
+{
+	if (sb->s_bdi != arg)
+		return;
+	if (pm_wakeup_pending()) {
+		suspend_sync_aborted = true;
+		return;
+	}
+	if (suspend_sync_sb_dirty(sb))
+		sync_filesystem(sb);
+}
+
+static void suspend_sync_bdi_work(struct work_struct *work)
+{
+	struct suspend_sync_bdi *sync = container_of(work,
+					struct suspend_sync_bdi, work);
+
+	iterate_supers(suspend_sync_one_sb, sync->bdi);
+
+	if (atomic_dec_and_test(&suspend_sync_bdi_pending))
+		complete(&suspend_sync_bdi_comp);
 }
 
 static void suspend_sys_sync(struct work_struct *work)
 {
+	struct suspend_sync_scan scan = { 0 };
+	ktime_t start = ktime_get();
+	int i;
+
 	pr_info("PM: Syncing filesystems...\n");
 
-	sys_sync();
+	suspend_sync_aborted = false;
+	iterate_supers(suspend_sync_scan_sb, &scan);
+
+	if (scan.overflow) {
+		sys_sync();
+	} else if (scan.nr_bdi) {
+		INIT_COMPLETION(suspend_sync_bdi_comp);
+		atomic_set(&suspend_sync_bdi_pending, scan.nr_bdi);
+		for (i = 0; i < scan.nr_bdi; i++) {
+			suspend_sync_bdis[i].bdi = scan.bdi[i];
+			INIT_WORK(&suspend_sync_bdis[i].work,
+				  suspend_sync_bdi_work);
+			queue_work(suspend_sync_bdi_work_queue,
+				   &suspend_sync_bdis[i].work);
+		}
+		wait_for_completion(&suspend_sync_bdi_comp);
+	}
 
-	pr_info("sync done.\n");
+	pr_info("sync %s in %lld ms (%d of %d filesystems dirty)\n",
+		suspend_sync_aborted ? "aborted" : "done",
+		ktime_to_ms(ktime_sub(ktime_get(), start)),
+		scan.nr_dirty, scan.nr_sb);
 
 	spin_lock(&suspend_sys_sync_lock);
-	suspend_sys_sync_count--;
+	if (!--suspend_sys_sync_count)
+		complete(&suspend_sys_sync_comp);
 	spin_unlock(&suspend_sys_sync_lock);
 }
 static DECLARE_WORK(suspend_sys_sync_work, suspend_sys_sync);
@@ -305,40 +451,23 @@ void suspend_sys_sync_queue(void)
 
 	spin_lock(&suspend_sys_sync_lock);
 	ret = queue_work(suspend_sys_sync_work_queue, &suspend_sys_sync_work);
-	if (ret)
-		suspend_sys_sync_count++;
+	if (ret && !suspend_sys_sync_count++)
+		INIT_COMPLETION(suspend_sys_sync_comp);
 	spin_unlock(&suspend_sys_sync_lock);
 }
 
-static bool suspend_sys_sync_abort;
-static void suspend_sys_sync_handler(unsigned long);
-static DEFINE_TIMER(suspend_sys_sync_timer, suspend_sys_sync_handler, 0, 0);
-#define SUSPEND_SYS_SYNC_TIMEOUT (HZ/4)
-static void suspend_sys_sync_handler(unsigned long arg)
-{
-	if (suspend_sys_sync_count == 0) {
-		complete(&suspend_sys_sync_comp);
-	} else if (pm_wakeup_pending()) {
-		suspend_sys_sync_abort = true;
-		complete(&suspend_sys_sync_comp);
-	} else {
-		mod_timer(&suspend_sys_sync_timer, jiffies +
-						SUSPEND_SYS_SYNC_TIMEOUT);
-	}
-}
+#define SUSPEND_SYS_SYNC_POLL	msecs_to_jiffies(10)
 
 int suspend_sys_sync_wait(void)
 {
-	suspend_sys_sync_abort = false;
-
-	if (suspend_sys_sync_count != 0) {
-		mod_timer(&suspend_sys_sync_timer, jiffies +
-				SUSPEND_SYS_SYNC_TIMEOUT);
-		wait_for_completion(&suspend_sys_sync_comp);
-	}
-	if (suspend_sys_sync_abort) {
-		pr_info("suspend aborted....while waiting for sys_sync\n");
-		return -EAGAIN;
+	while (ACCESS_ONCE(suspend_sys_sync_count)) {
+		if (wait_for_completion_timeout(&suspend_sys_sync_comp,
+						SUSPEND_SYS_SYNC_POLL))
+			break;
+		if (pm_wakeup_pending()) {
+			pr_info("suspend aborted....while waiting for sys_sync\n");
+			return -EAGAIN;
+		}
 	}
 
 	return 0;
@@ -41,6 +41,7 @@
 #include <linux/cpu.h>
 #include <linux/notifier.h>
 #include <linux/rculist.h>
+#include <linux/kthread.h>
 
 #include <asm/uaccess.h>
 
@@ -728,7 +729,18 @@ static const char recursion_bug_msg [] =
 		KERN_CRIT "BUG: recent printk recursion!\n";
 static int recursion_bug;
 static int new_text_line = 1;
-static char printk_buf[1024];
+
+/*
+ * Messages are formatted into a per-CPU buffer before logbuf_lock is
+ * taken, so CPUs printing at the same time only serialise on copying
+ * the text into log_buf.
+ */
+#define PRINTK_LINE_MAX		1024
+
+static DEFINE_PER_CPU(char [PRINTK_LINE_MAX], printk_line_buf);
+static DEFINE_PER_CPU(int, printk_formatting);
+
+static bool console_offloaded(void);
 
 int printk_delay_msec __read_mostly;
 
@@ -744,47 +756,14 @@ static inline void printk_delay(void)
 	}
 }
 
-asmlinkage int vprintk(const char *fmt, va_list args)
+static int log_emit_text(const char *text)
 {
-	int printed_len = 0;
 	int current_log_level = default_message_loglevel;
-	unsigned long flags;
-	int this_cpu;
-	char *p;
+	int printed_len = 0;
+	const char *p = text;
 	size_t plen;
 	char special;
 
-	boot_delay_msec();
-	printk_delay();
-
-	
-	local_irq_save(flags);
-	this_cpu = smp_processor_id();
-
-	if (unlikely(printk_cpu == this_cpu)) {
-		if (!oops_in_progress && !lockdep_recursing(current)) {
-			recursion_bug = 1;
-			goto out_restore_irqs;
-		}
-		zap_locks();
-	}
-
-	lockdep_off();
-	raw_spin_lock(&logbuf_lock);
-	printk_cpu = this_cpu;
-
-	if (recursion_bug) {
-		recursion_bug = 0;
-		strcpy(printk_buf, recursion_bug_msg);
-		printed_len = strlen(recursion_bug_msg);
-	}
-	
-	printed_len += vscnprintf(printk_buf + printed_len,
-				  sizeof(printk_buf) - printed_len, fmt, args);
-
-
-	p = printk_buf;
-
 	
 	plen = log_prefix(p, &current_log_level, &special);
 	if (plen) {
@@ -813,7 +792,7 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 				int i;
 
 				for (i = 0; i < plen; i++)
-					emit_log_char(printk_buf[i]);
+					emit_log_char(text[i]);
 				printed_len += plen;
 			} else {
 				
@@ -874,7 +853,54 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 			new_text_line = 1;
 	}
 
-	if (console_trylock_for_printk(this_cpu))
+	return printed_len;
+}
+
+asmlinkage int vprintk(const char *fmt, va_list args)
+{
+	int printed_len = 0;
+	unsigned long flags;
+	int this_cpu;
+	char *printk_buf;
+
+	boot_delay_msec();
+	printk_delay();
+
+	
+	local_irq_save(flags);
+	this_cpu = smp_processor_id();
+
+	if (unlikely(printk_cpu == this_cpu ||
+		     __this_cpu_read(printk_formatting))) {
+		if (!oops_in_progress && !lockdep_recursing(current)) {
+			recursion_bug = 1;
+			goto out_restore_irqs;
+		}
+		if (printk_cpu == this_cpu)
+			zap_locks();
+	}
+
+	__this_cpu_write(printk_formatting, 1);
+	printk_buf = __get_cpu_var(printk_line_buf);
+	printed_len = vscnprintf(printk_buf, PRINTK_LINE_MAX, fmt, args);
+	__this_cpu_write(printk_formatting, 0);
+
+	lockdep_off();
+	raw_spin_lock(&logbuf_lock);
+	printk_cpu = this_cpu;
+
+	if (recursion_bug) {
+		recursion_bug = 0;
+		printed_len += strlen(recursion_bug_msg);
+		printed_len += log_emit_text(recursion_bug_msg);
+	}
+
+	printed_len += log_emit_text(printk_buf);
+
+	if (console_offloaded()) {
+		printk_cpu = UINT_MAX;
+		raw_spin_unlock(&logbuf_lock);
+	} else if (console_trylock_for_printk(this_cpu))
 		console_unlock();
 
 	lockdep_on();
@@ -1088,10 +1114,13 @@ int is_console_locked(void)
 
 #define PRINTK_PENDING_WAKEUP	0x01
 #define PRINTK_PENDING_SCHED	0x02
+#define PRINTK_PENDING_FLUSH	0x04
 
 static DEFINE_PER_CPU(int, printk_pending);
 static DEFINE_PER_CPU(char [PRINTK_BUF_SIZE], printk_sched_buf);
 
+static struct task_struct *printk_kthread;
+
 void printk_tick(void)
 {
 	if (__this_cpu_read(printk_pending)) {
@@ -1102,9 +1131,62 @@ void printk_tick(void)
 		}
 		if (pending & PRINTK_PENDING_WAKEUP)
 			wake_up_interruptible(&log_wait);
+		if (pending & PRINTK_PENDING_FLUSH)
+			wake_up_process(printk_kthread);
+	}
+}
+
+#ifdef CONFIG_PRINTK
+static bool printk_offload = 1;
+module_param_named(offload, printk_offload, bool, S_IRUGO | S_IWUSR);
+
+/*
+ * Called from vprintk() with logbuf_lock held.  Once the flush thread is
+ * up, console output is left to it instead of the printing CPU; the
+ * thread is woken from the next tick, as printk may be called with
+ * runqueue locks held.  Oopses and shutdown still write synchronously.
+ */
+static bool console_offloaded(void)
+{
+	if (!printk_offload || !printk_kthread || oops_in_progress ||
+	    system_state != SYSTEM_RUNNING)
+		return false;
+
+	__this_cpu_or(printk_pending, PRINTK_PENDING_FLUSH);
+	return true;
+}
+
+static int printk_flush_thread(void *unused)
+{
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (console_suspended ||
+		    ACCESS_ONCE(con_start) == ACCESS_ONCE(log_end))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		console_lock();
+		console_unlock();
 	}
+
+	return 0;
 }
 
+static int __init printk_flush_init(void)
+{
+	struct task_struct *tsk;
+
+	tsk = kthread_run(printk_flush_thread, NULL, "printk");
+	if (IS_ERR(tsk)) {
+		pr_err("printk: unable to start flush thread\n");
+		return PTR_ERR(tsk);
+	}
+	printk_kthread = tsk;
+	return 0;
+}
+early_initcall(printk_flush_init);
+#endif
+
 int printk_needs_cpu(int cpu)
 {
 	if (cpu_is_offline(cpu))
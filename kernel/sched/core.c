@@ -89,6 +89,14 @@
 
 ATOMIC_NOTIFIER_HEAD(migration_notifier_head);
 
+unsigned int task_load_pct(struct task_struct *p)
+{
+	struct sched_avg *sa = &p->se.avg;
+
+	return sa->runnable_avg_sum * 100 / (sa->runnable_avg_period + 1);
+}
+EXPORT_SYMBOL_GPL(task_load_pct);
+
 void start_bandwidth_timer(struct hrtimer *period_timer, ktime_t period)
 {
 	unsigned long delta;
@@ -927,6 +935,8 @@ void set_task_cpu(struct task_struct *p, unsigned int new_cpu)
 	trace_sched_migrate_task(p, new_cpu);
 
 	if (task_cpu(p) != new_cpu) {
+		if (p->sched_class->migrate_task_rq)
+			p->sched_class->migrate_task_rq(p, new_cpu);
 		p->se.nr_migrations++;
 		perf_sw_event(PERF_COUNT_SW_CPU_MIGRATIONS, 1, NULL, 0);
 	}
@@ -1263,6 +1273,7 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 {
 	unsigned long flags;
 	int cpu, src_cpu, success = 0;
+	struct migration_notify_data mnd;
 
 	smp_wmb();
 	raw_spin_lock_irqsave(&p->pi_lock, flags);
@@ -1304,12 +1315,16 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 	ttwu_queue(p, cpu);
 stat:
 	ttwu_stat(p, cpu, wake_flags);
+	mnd.load = (src_cpu != cpu) ? task_load_pct(p) : 0;
 out:
 	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
 
-	if (src_cpu != cpu && task_notify_on_migrate(p))
+	if (src_cpu != cpu && task_notify_on_migrate(p)) {
+		mnd.src_cpu = src_cpu;
+		mnd.dest_cpu = cpu;
 		atomic_notifier_call_chain(&migration_notifier_head,
-					   cpu, (void *)src_cpu);
+					   0, (void *)&mnd);
+	}
 	return success;
 }
 
@@ -1362,6 +1377,12 @@ static void __sched_fork(struct task_struct *p)
 	p->se.prev_sum_exec_runtime	= 0;
 	p->se.nr_migrations		= 0;
 	p->se.vruntime			= 0;
+	p->se.avg.runnable_avg_sum	= 0;
+	p->se.avg.runnable_avg_period	= 0;
+	p->se.avg.last_runnable_update	= 0;
+	p->se.avg.sleep_stamp		= 0;
+	p->se.avg.load_avg_contrib	= 0;
+	p->se.avg.rebase_clock		= 0;
 	INIT_LIST_HEAD(&p->se.group_node);
 
 #ifdef CONFIG_SCHEDSTATS
@@ -2976,6 +2997,13 @@ int idle_cpu(int cpu)
 	return 1;
 }
 
+#ifdef CONFIG_SMP
+void sched_set_idle_exit_latency(unsigned int latency_us)
+{
+	this_rq()->idle_exit_latency = latency_us;
+}
+#endif
+
 struct task_struct *idle_task(int cpu)
 {
 	return cpu_rq(cpu)->idle;
@@ -3801,6 +3829,7 @@ EXPORT_SYMBOL_GPL(set_cpus_allowed_ptr);
 static int __migrate_task(struct task_struct *p, int src_cpu, int dest_cpu)
 {
 	struct rq *rq_dest, *rq_src;
+	struct migration_notify_data mnd;
 	bool moved = false;
 	int ret = 0;
 
@@ -3830,10 +3859,15 @@ done:
 	ret = 1;
 fail:
 	double_rq_unlock(rq_src, rq_dest);
+	if (moved && task_notify_on_migrate(p)) {
+		mnd.src_cpu = src_cpu;
+		mnd.dest_cpu = dest_cpu;
+		mnd.load = task_load_pct(p);
+	}
 	raw_spin_unlock(&p->pi_lock);
 	if (moved && task_notify_on_migrate(p))
 		atomic_notifier_call_chain(&migration_notifier_head,
-					   dest_cpu, (void *)src_cpu);
+					   0, (void *)&mnd);
 	return ret;
 }
 
@@ -789,6 +789,184 @@ static inline void update_entity_shares_tick(struct cfs_rq *cfs_rq)
 }
 #endif 
 
+#define LOAD_AVG_PERIOD	32
+#define LOAD_AVG_MAX	47742
+#define LOAD_AVG_MAX_N	345
+
+static const u32 runnable_avg_yN_inv[] = {
+	0xffffffff, 0xfa83b2db, 0xf5257d15, 0xefe4b99b, 0xeac0c6e7, 0xe5b906e7,
+	0xe0ccdeec, 0xdbfbb797, 0xd744fcca, 0xd2a81d91, 0xce248c15, 0xc9b9bd86,
+	0xc5672a11, 0xc12c4cca, 0xbd08a39f, 0xb8fbaf47, 0xb504f333, 0xb123f581,
+	0xad583eea, 0xa9a15ab4, 0xa5fed6a9, 0xa2704303, 0x9ef53260, 0x9b8d39b9,
+	0x9837f051, 0x94f4efa8, 0x91c3d373, 0x8ea4398b, 0x8b95c1e3, 0x88980e80,
+	0x85aac367, 0x82cd8698,
+};
+
+static const u32 runnable_avg_yN_sum[] = {
+	    0,  1002,  1982,  2941,  3879,  4797,  5696,  6575,  7436,  8278,  9102,
+	 9908, 10697, 11469, 12225, 12965, 13689, 14397, 15090, 15768, 16432, 17081,
+	17716, 18338, 18947, 19543, 20126, 20696, 21254, 21800, 22334, 22857, 23369,
+};
+
+static __always_inline u64 decay_load(u64 val, u64 n)
+{
+	unsigned int local_n;
+
+	if (!n)
+		return val;
+	else if (unlikely(n > LOAD_AVG_PERIOD * 63))
+		return 0;
+
+	local_n = n;
+	if (unlikely(local_n >= LOAD_AVG_PERIOD)) {
+		val >>= local_n / LOAD_AVG_PERIOD;
+		local_n %= LOAD_AVG_PERIOD;
+	}
+
+	val *= runnable_avg_yN_inv[local_n];
+	return val >> 32;
+}
+
+static u32 __compute_runnable_contrib(u64 n)
+{
+	u32 contrib = 0;
+
+	if (likely(n <= LOAD_AVG_PERIOD))
+		return runnable_avg_yN_sum[n];
+	else if (unlikely(n >= LOAD_AVG_MAX_N))
+		return LOAD_AVG_MAX;
+
+	do {
+		contrib /= 2;
+		contrib += runnable_avg_yN_sum[LOAD_AVG_PERIOD];
+		n -= LOAD_AVG_PERIOD;
+	} while (n > LOAD_AVG_PERIOD);
+
+	contrib = decay_load(contrib, n);
+	return contrib + runnable_avg_yN_sum[n];
+}
+
+/*
+ * Runnable time is accounted in ~1ms (1024us) periods; the contribution of
+ * a period i periods ago is scaled by y^i with y^32 = 1/2.  Returns true
+ * when at least one period boundary was crossed.
+ */
+static __always_inline int __update_entity_runnable_avg(u64 now,
+							struct sched_avg *sa,
+							int runnable)
+{
+	u64 delta, periods;
+	u32 runnable_contrib;
+	int delta_w, decayed = 0;
+
+	delta = now - sa->last_runnable_update;
+	if ((s64)delta < 0) {
+		sa->last_runnable_update = now;
+		return 0;
+	}
+
+	delta >>= 10;
+	if (!delta)
+		return 0;
+	sa->last_runnable_update = now;
+
+	delta_w = sa->runnable_avg_period % 1024;
+	if (delta + delta_w >= 1024) {
+		decayed = 1;
+
+		delta_w = 1024 - delta_w;
+		if (runnable)
+			sa->runnable_avg_sum += delta_w;
+		sa->runnable_avg_period += delta_w;
+
+		delta -= delta_w;
+		periods = delta >> 10;
+		delta &= 1023;
+
+		sa->runnable_avg_sum = decay_load(sa->runnable_avg_sum,
+						  periods + 1);
+		sa->runnable_avg_period = decay_load(sa->runnable_avg_period,
+						     periods + 1);
+
+		runnable_contrib = __compute_runnable_contrib(periods);
+		if (runnable)
+			sa->runnable_avg_sum += runnable_contrib;
+		sa->runnable_avg_period += runnable_contrib;
+	}
+
+	if (runnable)
+		sa->runnable_avg_sum += delta;
+	sa->runnable_avg_period += delta;
+
+	return decayed;
+}
+
+static inline void __update_task_entity_contrib(struct sched_entity *se)
+{
+	u32 contrib;
+
+	contrib = se->avg.runnable_avg_sum * scale_load_down(se->load.weight);
+	contrib /= (se->avg.runnable_avg_period + 1);
+	se->avg.load_avg_contrib = scale_load(contrib);
+}
+
+static void update_entity_load_avg(struct cfs_rq *cfs_rq,
+				   struct sched_entity *se, int runnable)
+{
+	struct rq *rq = rq_of(cfs_rq);
+
+	if (!entity_is_task(se))
+		return;
+
+	if (!__update_entity_runnable_avg(rq->clock_task, &se->avg, runnable))
+		return;
+
+	__update_task_entity_contrib(se);
+	trace_sched_task_load_avg(task_of(se), &se->avg);
+}
+
+/*
+ * last_runnable_update is a timestamp of the rq clock_task the entity was
+ * last accounted against; clocks of different rqs are not comparable, so
+ * after a migration the first enqueue restarts accounting from the new
+ * rq's clock instead of computing a delta across the two.
+ */
+static void enqueue_entity_load_avg(struct cfs_rq *cfs_rq,
+				    struct sched_entity *se, int flags)
+{
+	struct rq *rq = rq_of(cfs_rq);
+
+	if (!entity_is_task(se))
+		return;
+
+	if (se->avg.rebase_clock) {
+		se->avg.last_runnable_update = rq->clock_task;
+		se->avg.rebase_clock = 0;
+	} else
+		update_entity_load_avg(cfs_rq, se, !(flags & ENQUEUE_WAKEUP));
+}
+
+static void dequeue_entity_load_avg(struct cfs_rq *cfs_rq,
+				    struct sched_entity *se, int flags)
+{
+	if (!entity_is_task(se))
+		return;
+
+	update_entity_load_avg(cfs_rq, se, 1);
+	if (flags & DEQUEUE_SLEEP)
+		se->avg.sleep_stamp = cpu_clock(cpu_of(rq_of(cfs_rq)));
+}
+
+static void init_task_load_avg(struct cfs_rq *cfs_rq, struct sched_entity *se)
+{
+	u32 slice = sched_slice(cfs_rq, se) >> 10;
+
+	se->avg.last_runnable_update = rq_of(cfs_rq)->clock_task;
+	se->avg.runnable_avg_sum = slice;
+	se->avg.runnable_avg_period = slice;
+	__update_task_entity_contrib(se);
+}
+
 static void enqueue_sleeper(struct cfs_rq *cfs_rq, struct sched_entity *se)
 {
 #ifdef CONFIG_SCHEDSTATS
@@ -892,6 +1070,7 @@ enqueue_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 		se->vruntime += cfs_rq->min_vruntime;
 
 	update_curr(cfs_rq);
+	enqueue_entity_load_avg(cfs_rq, se, flags);
 	update_cfs_load(cfs_rq, 0);
 	account_entity_enqueue(cfs_rq, se);
 	update_cfs_shares(cfs_rq);
@@ -964,6 +1143,7 @@ static void
 dequeue_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 {
 	update_curr(cfs_rq);
+	dequeue_entity_load_avg(cfs_rq, se, flags);
 
 	update_stats_dequeue(cfs_rq, se);
 	if (flags & DEQUEUE_SLEEP) {
@@ -1093,6 +1273,7 @@ static void
 entity_tick(struct cfs_rq *cfs_rq, struct sched_entity *curr, int queued)
 {
 	update_curr(cfs_rq);
+	update_entity_load_avg(cfs_rq, curr, 1);
 
 	update_entity_shares_tick(cfs_rq);
 
@@ -1911,6 +2092,31 @@ static unsigned long cpu_avg_load_per_task(int cpu)
 }
 
 
+/*
+ * A waking task's average was last updated when it went to sleep.  Decay
+ * the sleep before select_task_rq() and the wakeup load hooks read it.
+ * task_waking runs before set_task_cpu(), so task_cpu(p) is still the CPU
+ * the task slept on and both stamps come from that CPU's sched_clock_cpu();
+ * local_clock() of the waker is not comparable with it.  A negative delta
+ * from clock resync is clamped, and the next enqueue restarts from
+ * whichever rq the task lands on.
+ */
+static void task_sleep_load_avg(struct task_struct *p)
+{
+	struct sched_entity *se = &p->se;
+	s64 slept = cpu_clock(task_cpu(p)) - se->avg.sleep_stamp;
+
+	if (slept < 0)
+		slept = 0;
+
+	if (__update_entity_runnable_avg(se->avg.last_runnable_update + slept,
+					 &se->avg, 0)) {
+		__update_task_entity_contrib(se);
+		trace_sched_task_load_avg(p, &se->avg);
+	}
+	se->avg.rebase_clock = 1;
+}
+
 static void task_waking_fair(struct task_struct *p)
 {
 	struct sched_entity *se = &p->se;
@@ -1930,6 +2136,13 @@ static void task_waking_fair(struct task_struct *p)
 #endif
 
 	se->vruntime -= min_vruntime;
+
+	task_sleep_load_avg(p);
+}
+
+static void migrate_task_rq_fair(struct task_struct *p, int next_cpu)
+{
+	p->se.avg.rebase_clock = 1;
 }
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -2083,6 +2296,44 @@ find_idlest_group(struct sched_domain *sd, struct task_struct *p,
 	return idlest;
 }
 
+static inline unsigned int idle_exit_latency(int cpu)
+{
+	if (!sched_feat(WAKE_SHALLOW_IDLE) || !idle_cpu(cpu))
+		return 0;
+
+	return ACCESS_ONCE(cpu_rq(cpu)->idle_exit_latency);
+}
+
+static int shallowest_idle_cpu(const struct cpumask *cpus,
+			       struct task_struct *p, int prefer)
+{
+	unsigned int latency, min_latency = UINT_MAX;
+	int i, shallowest = -1;
+
+	if (cpumask_test_cpu(prefer, cpus) &&
+	    cpumask_test_cpu(prefer, tsk_cpus_allowed(p)) && idle_cpu(prefer)) {
+		min_latency = idle_exit_latency(prefer);
+		if (!min_latency)
+			return prefer;
+		shallowest = prefer;
+	}
+
+	for_each_cpu_and(i, cpus, tsk_cpus_allowed(p)) {
+		if (!idle_cpu(i))
+			continue;
+
+		latency = idle_exit_latency(i);
+		if (latency < min_latency) {
+			min_latency = latency;
+			shallowest = i;
+			if (!latency)
+				break;
+		}
+	}
+
+	return shallowest;
+}
+
 static int
 find_idlest_cpu(struct sched_group *group, struct task_struct *p, int this_cpu)
 {
@@ -2097,6 +2348,9 @@ find_idlest_cpu(struct sched_group *group, struct task_struct *p, int this_cpu)
 		if (load < min_load || (load == min_load && i == this_cpu)) {
 			min_load = load;
 			idlest = i;
+		} else if (load == min_load && idlest != this_cpu &&
+			   idle_exit_latency(i) < idle_exit_latency(idlest)) {
+			idlest = i;
 		}
 	}
 
@@ -2114,8 +2368,19 @@ static int select_idle_sibling(struct task_struct *p, int target)
 	if (target == cpu && idle_cpu(cpu))
 		return cpu;
 
-	if (target == prev_cpu && idle_cpu(prev_cpu))
+	if (target == prev_cpu && idle_cpu(prev_cpu)) {
+		if (!idle_exit_latency(prev_cpu))
+			return prev_cpu;
+
+		sd = rcu_dereference(per_cpu(sd_llc, prev_cpu));
+		if (sd) {
+			i = shallowest_idle_cpu(sched_domain_span(sd), p,
+						prev_cpu);
+			if (i >= 0)
+				return i;
+		}
 		return prev_cpu;
+	}
 
 	if (!sysctl_sched_wake_to_idle &&
 	    !(current->flags & PF_WAKE_UP_IDLE) &&
@@ -2135,8 +2400,12 @@ static int select_idle_sibling(struct task_struct *p, int target)
 					goto next;
 			}
 
-			target = cpumask_first_and(sched_group_cpus(sg),
-					tsk_cpus_allowed(p));
+			i = shallowest_idle_cpu(sched_group_cpus(sg), p,
+						prev_cpu);
+			if (i < 0)
+				i = cpumask_first_and(sched_group_cpus(sg),
+						      tsk_cpus_allowed(p));
+			target = i;
 			goto done;
 next:
 			sg = sg->next;
@@ -2452,6 +2721,7 @@ struct lb_env {
 };
 
 static DEFINE_PER_CPU(bool, dbs_boost_needed);
+static DEFINE_PER_CPU(int, dbs_boost_load_moved);
 
 static void move_task(struct task_struct *p, struct lb_env *env)
 {
@@ -2459,8 +2729,10 @@ static void move_task(struct task_struct *p, struct lb_env *env)
 	set_task_cpu(p, env->dst_cpu);
 	activate_task(env->dst_rq, p, 0);
 	check_preempt_curr(env->dst_rq, p, 0);
-	if (task_notify_on_migrate(p))
+	if (task_notify_on_migrate(p)) {
 		per_cpu(dbs_boost_needed, env->dst_cpu) = true;
+		per_cpu(dbs_boost_load_moved, env->dst_cpu) += task_load_pct(p);
+	}
 }
 
 static int
@@ -3482,10 +3754,16 @@ more_balance:
 	} else {
 		sd->nr_balance_failed = 0;
 		if (per_cpu(dbs_boost_needed, this_cpu)) {
+			struct migration_notify_data mnd;
+
+			mnd.src_cpu = cpu_of(busiest);
+			mnd.dest_cpu = this_cpu;
+			mnd.load = min(per_cpu(dbs_boost_load_moved, this_cpu),
+				       100);
 			per_cpu(dbs_boost_needed, this_cpu) = false;
+			per_cpu(dbs_boost_load_moved, this_cpu) = 0;
 			atomic_notifier_call_chain(&migration_notifier_head,
-						   this_cpu,
-						   (void *)cpu_of(busiest));
+						   0, (void *)&mnd);
 		}
 	}
 	if (likely(!active_balance)) {
@@ -3619,10 +3897,15 @@ out_unlock:
 	busiest_rq->active_balance = 0;
 	raw_spin_unlock_irq(&busiest_rq->lock);
 	if (per_cpu(dbs_boost_needed, target_cpu)) {
+		struct migration_notify_data mnd;
+
+		mnd.src_cpu = cpu_of(busiest_rq);
+		mnd.dest_cpu = target_cpu;
+		mnd.load = min(per_cpu(dbs_boost_load_moved, target_cpu), 100);
 		per_cpu(dbs_boost_needed, target_cpu) = false;
+		per_cpu(dbs_boost_load_moved, target_cpu) = 0;
 		atomic_notifier_call_chain(&migration_notifier_head,
-					   target_cpu,
-					   (void *)cpu_of(busiest_rq));
+					   0, (void *)&mnd);
 	}
 	return 0;
 }
@@ -4008,6 +4291,7 @@ static void task_fork_fair(struct task_struct *p)
 	if (curr)
 		se->vruntime = curr->vruntime;
 	place_entity(cfs_rq, se, 1);
+	init_task_load_avg(cfs_rq, se);
 
 	if (sysctl_sched_child_runs_first && curr && entity_before(curr, se)) {
 		swap(curr->vruntime, se->vruntime);
@@ -4266,6 +4550,7 @@ const struct sched_class fair_sched_class = {
 	.rq_online		= rq_online_fair,
 	.rq_offline		= rq_offline_fair,
 
+	.migrate_task_rq	= migrate_task_rq_fair,
 	.task_waking		= task_waking_fair,
 #endif
 
@@ -4,6 +4,8 @@ SCHED_FEAT(START_DEBIT, true)
 
 SCHED_FEAT(AFFINE_WAKEUPS, true)
 
+SCHED_FEAT(WAKE_SHALLOW_IDLE, true)
+
 SCHED_FEAT(NEXT_BUDDY, false)
 
 SCHED_FEAT(LAST_BUDDY, true)
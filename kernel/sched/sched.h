@@ -324,6 +324,7 @@ struct rq {
 	u64 age_stamp;
 	u64 idle_stamp;
 	u64 avg_idle;
+	unsigned int idle_exit_latency;
 #endif
 
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
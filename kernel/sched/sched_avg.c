@@ -15,60 +15,158 @@
 #include <linux/hrtimer.h>
 #include <linux/sched.h>
 #include <linux/math64.h>
+#include <linux/notifier.h>
+#include <linux/mutex.h>
+#include <linux/timer.h>
+#include <linux/jiffies.h>
+
+#include <trace/events/sched.h>
+
+#define NR_AVG_SHIFT		10
+#define NR_AVG_SCALE		(1 << NR_AVG_SHIFT)
+#define NR_AVG_HALFLIFE_SHIFT	25
+
+#define NR_AVG_NOTIFY_JIFFIES	DIV_ROUND_UP(20 * HZ, MSEC_PER_SEC)
 
-static DEFINE_PER_CPU(u64, nr_prod_sum);
 static DEFINE_PER_CPU(u64, last_time);
 static DEFINE_PER_CPU(u64, nr);
-static DEFINE_PER_CPU(unsigned long, iowait_prod_sum);
+static DEFINE_PER_CPU(u32, nr_avg);
+static DEFINE_PER_CPU(u32, iowait_avg);
 static DEFINE_PER_CPU(spinlock_t, nr_lock) = __SPIN_LOCK_UNLOCKED(nr_lock);
-static s64 last_get_time;
 
-void sched_get_nr_running_avg(int *avg, int *iowait_avg)
+static ATOMIC_NOTIFIER_HEAD(nr_running_avg_notifier_head);
+static DEFINE_MUTEX(nr_avg_notify_mutex);
+static unsigned long nr_avg_notify_jiffies = NR_AVG_NOTIFY_JIFFIES;
+static int nr_avg_notify_users;
+
+static void nr_avg_notify_fn(unsigned long data);
+static struct timer_list nr_avg_notify_timer =
+	TIMER_DEFERRED_INITIALIZER(nr_avg_notify_fn, 0, 0);
+
+static u32 nr_avg_decay(u32 avg, u32 target, u64 delta)
+{
+	u64 periods = delta >> NR_AVG_HALFLIFE_SHIFT;
+	u32 frac;
+	s64 diff;
+
+	if (periods >= 32)
+		return target;
+
+	diff = (s64)avg - (s64)target;
+	if (diff < 0)
+		diff = -((-diff) >> periods);
+	else
+		diff >>= periods;
+
+	frac = (delta & ((1ULL << NR_AVG_HALFLIFE_SHIFT) - 1)) >>
+		(NR_AVG_HALFLIFE_SHIFT - NR_AVG_SHIFT);
+	diff -= div_s64(diff * frac, 2 * NR_AVG_SCALE);
+
+	return (u32)((s64)target + diff);
+}
+
+void sched_get_nr_running_avg_decayed(int *avg, int *iowait_avg)
 {
 	int cpu;
 	u64 curr_time = sched_clock();
-	u64 diff = curr_time - last_get_time;
 	u64 tmp_avg = 0, tmp_iowait = 0;
 
-	*avg = 0;
-	*iowait_avg = 0;
-
-	if (!diff)
-		return;
-
-	last_get_time = curr_time;
-	
-	for_each_possible_cpu(cpu) {
+	for_each_online_cpu(cpu) {
 		unsigned long flags;
+		u64 delta;
 
 		spin_lock_irqsave(&per_cpu(nr_lock, cpu), flags);
-		tmp_avg += per_cpu(nr_prod_sum, cpu);
-		tmp_avg += per_cpu(nr, cpu) *
-			(curr_time - per_cpu(last_time, cpu));
-		tmp_iowait = per_cpu(iowait_prod_sum, cpu);
-		tmp_iowait +=  nr_iowait_cpu(cpu) *
-			(curr_time - per_cpu(last_time, cpu));
-		per_cpu(last_time, cpu) = curr_time;
-		per_cpu(nr_prod_sum, cpu) = 0;
-		per_cpu(iowait_prod_sum, cpu) = 0;
+		delta = curr_time - per_cpu(last_time, cpu);
+		tmp_avg += nr_avg_decay(per_cpu(nr_avg, cpu),
+				per_cpu(nr, cpu) << NR_AVG_SHIFT, delta);
+		tmp_iowait += nr_avg_decay(per_cpu(iowait_avg, cpu),
+				nr_iowait_cpu(cpu) << NR_AVG_SHIFT, delta);
 		spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
 	}
 
-	*avg = (int)div64_u64(tmp_avg * 100, diff);
-	*iowait_avg = (int)div64_u64(tmp_iowait * 100, diff);
+	*avg = (int)((tmp_avg * 100) >> NR_AVG_SHIFT);
+	*iowait_avg = (int)((tmp_iowait * 100) >> NR_AVG_SHIFT);
+
+	trace_sched_get_nr_running_avg(*avg, *iowait_avg);
+}
+EXPORT_SYMBOL(sched_get_nr_running_avg_decayed);
+
+int sched_get_cpu_nr_running_avg(int cpu)
+{
+	unsigned long flags;
+	u32 avg;
+
+	spin_lock_irqsave(&per_cpu(nr_lock, cpu), flags);
+	avg = nr_avg_decay(per_cpu(nr_avg, cpu),
+			per_cpu(nr, cpu) << NR_AVG_SHIFT,
+			sched_clock() - per_cpu(last_time, cpu));
+	spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
 
-	BUG_ON(*avg < 0);
-	pr_debug("%s - avg:%d\n", __func__, *avg);
-	BUG_ON(*iowait_avg < 0);
-	pr_debug("%s - avg:%d\n", __func__, *iowait_avg);
+	return (int)((avg * 100) >> NR_AVG_SHIFT);
+}
+EXPORT_SYMBOL(sched_get_cpu_nr_running_avg);
+
+static void nr_avg_notify_fn(unsigned long data)
+{
+	int avg, iowait_avg;
+
+	sched_get_nr_running_avg_decayed(&avg, &iowait_avg);
+	atomic_notifier_call_chain(&nr_running_avg_notifier_head,
+				   avg, &iowait_avg);
+
+	if (ACCESS_ONCE(nr_avg_notify_users))
+		mod_timer(&nr_avg_notify_timer,
+			  jiffies + ACCESS_ONCE(nr_avg_notify_jiffies));
+}
+
+int sched_register_nr_running_avg_notifier(struct notifier_block *nb)
+{
+	int ret;
+
+	mutex_lock(&nr_avg_notify_mutex);
+	ret = atomic_notifier_chain_register(&nr_running_avg_notifier_head, nb);
+	if (!ret && !nr_avg_notify_users++)
+		mod_timer(&nr_avg_notify_timer,
+			  jiffies + nr_avg_notify_jiffies);
+	mutex_unlock(&nr_avg_notify_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(sched_register_nr_running_avg_notifier);
+
+int sched_unregister_nr_running_avg_notifier(struct notifier_block *nb)
+{
+	int ret;
+
+	mutex_lock(&nr_avg_notify_mutex);
+	ret = atomic_notifier_chain_unregister(&nr_running_avg_notifier_head,
+					       nb);
+	if (!ret && !--nr_avg_notify_users)
+		del_timer_sync(&nr_avg_notify_timer);
+	mutex_unlock(&nr_avg_notify_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(sched_unregister_nr_running_avg_notifier);
+
+unsigned int sched_get_nr_running_avg_period(void)
+{
+	return jiffies_to_msecs(nr_avg_notify_jiffies);
+}
+EXPORT_SYMBOL(sched_get_nr_running_avg_period);
+
+void sched_set_nr_running_avg_period(unsigned int ms)
+{
+	nr_avg_notify_jiffies = max(msecs_to_jiffies(ms), 1UL);
 }
-EXPORT_SYMBOL(sched_get_nr_running_avg);
+EXPORT_SYMBOL(sched_set_nr_running_avg_period);
 
 void sched_update_nr_prod(int cpu, unsigned long nr_running, bool inc)
 {
-	int diff;
+	u64 diff;
 	s64 curr_time;
 	unsigned long flags;
+	unsigned long nr_iowait = nr_iowait_cpu(cpu);
 
 	spin_lock_irqsave(&per_cpu(nr_lock, cpu), flags);
 	curr_time = sched_clock();
@@ -78,8 +176,10 @@ void sched_update_nr_prod(int cpu, unsigned long nr_running, bool inc)
 
 	BUG_ON(per_cpu(nr, cpu) < 0);
 
-	per_cpu(nr_prod_sum, cpu) += nr_running * diff;
-	per_cpu(iowait_prod_sum, cpu) += nr_iowait_cpu(cpu) * diff;
+	per_cpu(nr_avg, cpu) = nr_avg_decay(per_cpu(nr_avg, cpu),
+				nr_running << NR_AVG_SHIFT, diff);
+	per_cpu(iowait_avg, cpu) = nr_avg_decay(per_cpu(iowait_avg, cpu),
+				nr_iowait << NR_AVG_SHIFT, diff);
 	spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
 }
 EXPORT_SYMBOL(sched_update_nr_prod);
@@ -230,6 +230,8 @@ static int max_sched_tunable_scaling = SCHED_TUNABLESCALING_END-1;
 #ifdef CONFIG_COMPACTION
 static int min_extfrag_threshold;
 static int max_extfrag_threshold = 1000;
+static int max_proactive_order = MAX_ORDER - 1;
+static int min_proactive_interval = 100;
 #endif
 
 static struct ctl_table kern_table[] = {
@@ -1183,6 +1185,32 @@ static struct ctl_table vm_table[] = {
 		.extra1		= &min_extfrag_threshold,
 		.extra2		= &max_extfrag_threshold,
 	},
+	{
+		.procname	= "compaction_proactive_threshold",
+		.data		= &sysctl_compaction_proactive_threshold,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= sysctl_compaction_proactive_handler,
+		.extra1		= &zero,
+		.extra2		= &max_extfrag_threshold,
+	},
+	{
+		.procname	= "compaction_proactive_order",
+		.data		= &sysctl_compaction_proactive_order,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= sysctl_compaction_proactive_handler,
+		.extra1		= &one,
+		.extra2		= &max_proactive_order,
+	},
+	{
+		.procname	= "compaction_proactive_interval_ms",
+		.data		= &sysctl_compaction_proactive_interval,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= sysctl_compaction_proactive_handler,
+		.extra1		= &min_proactive_interval,
+	},
 
 #endif 
 	{
@@ -18,6 +18,9 @@
 #include <linux/errno.h>
 #include <linux/io.h>
 #include <linux/string.h>
+#include <linux/rculist.h>
+#include <linux/spinlock.h>
+#include <linux/hash.h>
 #include <linux/qmi_encdec.h>
 
 #include "qmi_encdec_priv.h"
@@ -25,6 +28,26 @@
 #define TLV_LEN_SIZE sizeof(uint16_t)
 #define TLV_TYPE_SIZE sizeof(uint8_t)
 
+/*
+ * Per message decode plan, built the first time a top level elem_info
+ * array is decoded and looked up by the array's address afterwards.  It
+ * maps a TLV type straight to its first element instead of walking the
+ * array for every TLV in the message.  Plans are only cached for arrays
+ * in the core kernel image, since a module's array may be unloaded and
+ * its address reused.
+ */
+#define QMI_PLAN_HASH_BITS 6
+#define QMI_PLAN_MAX_ELEMS 0xFFFF
+
+struct qmi_codec_plan {
+	struct hlist_node node;
+	struct elem_info *ei_array;
+	uint16_t tlv_map[256];
+};
+
+static struct hlist_head qmi_plan_hash[1 << QMI_PLAN_HASH_BITS];
+static DEFINE_SPINLOCK(qmi_plan_lock);
+
 #ifdef CONFIG_QMI_ENCDEC_DEBUG
 
 #define qmi_encdec_dump(prefix_str, buf, buf_len) do { \
@@ -85,10 +108,13 @@ static int _qmi_kernel_encode(struct elem_info *ei_array,
 			      uint32_t out_buf_len, int enc_level);
 
 static int _qmi_kernel_decode(struct elem_info *ei_array,
+			      struct qmi_codec_plan *plan,
 			      void *out_c_struct,
 			      void *in_buf, uint32_t in_buf_len,
 			      int dec_level);
 
+static struct qmi_codec_plan *qmi_get_plan(struct elem_info *ei_array);
+
 static int qmi_calc_max_msg_len(struct elem_info *ei_array,
 				int level)
 {
@@ -166,13 +192,9 @@ EXPORT_SYMBOL(qmi_kernel_encode);
 static int qmi_encode_basic_elem(void *buf_dst, void *buf_src,
 				 uint32_t elem_len, uint32_t elem_size)
 {
-	uint32_t i, rc = 0;
-
-	for (i = 0; i < elem_len; i++) {
-		QMI_ENCDEC_ENCODE_N_BYTES(buf_dst, buf_src, elem_size);
-		rc += elem_size;
-	}
+	uint32_t rc = elem_len * elem_size;
 
+	QMI_ENCDEC_ENCODE_N_BYTES(buf_dst, buf_src, rc);
 	return rc;
 }
 
@@ -346,8 +368,8 @@ int qmi_kernel_decode(struct msg_desc *desc, void *out_c_struct,
 	if (desc->max_msg_len < in_buf_len)
 		return -EINVAL;
 
-	rc = _qmi_kernel_decode(desc->ei_array, out_c_struct,
-				in_buf, in_buf_len, dec_level);
+	rc = _qmi_kernel_decode(desc->ei_array, qmi_get_plan(desc->ei_array),
+				out_c_struct, in_buf, in_buf_len, dec_level);
 	if (rc < 0)
 		return rc;
 	else
@@ -358,13 +380,9 @@ EXPORT_SYMBOL(qmi_kernel_decode);
 static int qmi_decode_basic_elem(void *buf_dst, void *buf_src,
 				 uint32_t elem_len, uint32_t elem_size)
 {
-	uint32_t i, rc = 0;
-
-	for (i = 0; i < elem_len; i++) {
-		QMI_ENCDEC_DECODE_N_BYTES(buf_dst, buf_src, elem_size);
-		rc += elem_size;
-	}
+	uint32_t rc = elem_len * elem_size;
 
+	QMI_ENCDEC_DECODE_N_BYTES(buf_dst, buf_src, rc);
 	return rc;
 }
 
@@ -376,8 +394,8 @@ static int qmi_decode_struct_elem(struct elem_info *ei_array, void *buf_dst,
 	struct elem_info *temp_ei = ei_array;
 
 	for (i = 0; i < elem_len; i++) {
-		rc = _qmi_kernel_decode(temp_ei->ei_array, buf_dst, buf_src,
-					(tlv_len/elem_len), dec_level);
+		rc = _qmi_kernel_decode(temp_ei->ei_array, NULL, buf_dst,
+					buf_src, (tlv_len/elem_len), dec_level);
 		if (rc < 0)
 			return rc;
 		if (rc != (tlv_len/elem_len)) {
@@ -404,7 +422,78 @@ static struct elem_info *find_ei(struct elem_info *ei_array,
 	return NULL;
 }
 
+static struct qmi_codec_plan *qmi_build_plan(struct elem_info *ei_array)
+{
+	struct qmi_codec_plan *plan;
+	uint32_t i;
+
+	plan = kzalloc(sizeof(struct qmi_codec_plan), GFP_KERNEL);
+	if (!plan)
+		return NULL;
+
+	plan->ei_array = ei_array;
+	for (i = 0; ei_array[i].data_type != QMI_EOTI; i++) {
+		if (i >= QMI_PLAN_MAX_ELEMS) {
+			kfree(plan);
+			return NULL;
+		}
+		if (!plan->tlv_map[ei_array[i].tlv_type])
+			plan->tlv_map[ei_array[i].tlv_type] = i + 1;
+	}
+	return plan;
+}
+
+static struct qmi_codec_plan *qmi_get_plan(struct elem_info *ei_array)
+{
+	struct hlist_head *head;
+	struct hlist_node *pos;
+	struct qmi_codec_plan *plan, *new_plan;
+
+	if (!core_kernel_data((unsigned long)ei_array))
+		return NULL;
+
+	head = &qmi_plan_hash[hash_ptr(ei_array, QMI_PLAN_HASH_BITS)];
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(plan, pos, head, node) {
+		if (plan->ei_array == ei_array) {
+			rcu_read_unlock();
+			return plan;
+		}
+	}
+	rcu_read_unlock();
+
+	new_plan = qmi_build_plan(ei_array);
+	if (!new_plan)
+		return NULL;
+
+	spin_lock(&qmi_plan_lock);
+	hlist_for_each_entry(plan, pos, head, node) {
+		if (plan->ei_array == ei_array) {
+			spin_unlock(&qmi_plan_lock);
+			kfree(new_plan);
+			return plan;
+		}
+	}
+	hlist_add_head_rcu(&new_plan->node, head);
+	spin_unlock(&qmi_plan_lock);
+	return new_plan;
+}
+
+static struct elem_info *qmi_plan_find_ei(struct qmi_codec_plan *plan,
+					  struct elem_info *ei_array,
+					  uint32_t type)
+{
+	uint16_t idx;
+
+	if (!plan)
+		return find_ei(ei_array, type);
+
+	idx = plan->tlv_map[(uint8_t)type];
+	return idx ? &ei_array[idx - 1] : NULL;
+}
+
 static int _qmi_kernel_decode(struct elem_info *ei_array,
+			      struct qmi_codec_plan *plan,
 			      void *out_c_struct,
 			      void *in_buf, uint32_t in_buf_len,
 			      int dec_level)
@@ -431,7 +520,7 @@ static int _qmi_kernel_decode(struct elem_info *ei_array,
 			QMI_DECODE_LOG_TLV(tlv_type, tlv_len);
 			buf_src += (TLV_TYPE_SIZE + TLV_LEN_SIZE);
 			decoded_bytes += (TLV_TYPE_SIZE + TLV_LEN_SIZE);
-			temp_ei = find_ei(ei_array, tlv_type);
+			temp_ei = qmi_plan_find_ei(plan, ei_array, tlv_type);
 			if (!temp_ei) {
 				pr_err("%s: Inval element info\n", __func__);
 				return -EINVAL;
@@ -14,6 +14,8 @@
 #include <linux/backing-dev.h>
 #include <linux/sysctl.h>
 #include <linux/sysfs.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
 #include "internal.h"
 
 #ifdef CONFIG_COMPACTION
@@ -694,7 +696,10 @@ static int compact_zone(struct zone *zone, struct compact_control *cc)
 	unsigned long start_pfn = zone->zone_start_pfn;
 	unsigned long end_pfn = zone->zone_start_pfn + zone->spanned_pages;
 
-	ret = compaction_suitable(zone, cc->order);
+	if (cc->proactive)
+		ret = COMPACT_CONTINUE;
+	else
+		ret = compaction_suitable(zone, cc->order);
 	switch (ret) {
 	case COMPACT_PARTIAL:
 	case COMPACT_SKIPPED:
@@ -922,6 +927,280 @@ int sysctl_extfrag_handler(struct ctl_table *table, int write,
 	return 0;
 }
 
+/*
+ * kcompactd compacts a node in the background, either on behalf of a
+ * failed high order allocation or, every compaction_proactive_interval_ms,
+ * when a zone has no free block of compaction_proactive_order left and its
+ * fragmentation index is above compaction_proactive_threshold (0 disables).
+ */
+int sysctl_compaction_proactive_threshold;
+int sysctl_compaction_proactive_order = PAGE_ALLOC_COSTLY_ORDER + 1;
+int sysctl_compaction_proactive_interval = 2000;
+
+static bool kcompactd_zone_fragmented(struct zone *zone, int order)
+{
+	unsigned long watermark = low_wmark_pages(zone) + (2UL << order);
+
+	if (!zone_watermark_ok(zone, 0, watermark, 0, 0))
+		return false;
+
+	return fragmentation_index(zone, order) >
+		sysctl_compaction_proactive_threshold;
+}
+
+static int kcompactd_compact_zone(struct zone *zone, struct compact_control *cc)
+{
+	int status;
+
+	cc->nr_freepages = 0;
+	cc->nr_migratepages = 0;
+	cc->zone = zone;
+	INIT_LIST_HEAD(&cc->freepages);
+	INIT_LIST_HEAD(&cc->migratepages);
+
+	status = compact_zone(zone, cc);
+
+	VM_BUG_ON(!list_empty(&cc->freepages));
+	VM_BUG_ON(!list_empty(&cc->migratepages));
+
+	return status;
+}
+
+static void kcompactd_do_work(pg_data_t *pgdat)
+{
+	int classzone_idx = pgdat->kcompactd_classzone_idx;
+	struct compact_control cc = {
+		.order = pgdat->kcompactd_max_order,
+		.sync = true,
+	};
+	int zoneid;
+
+	for (zoneid = 0; zoneid <= classzone_idx; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+		int status;
+
+		if (!populated_zone(zone))
+			continue;
+
+		if (compaction_deferred(zone, cc.order))
+			continue;
+
+		if (compaction_suitable(zone, cc.order) != COMPACT_CONTINUE)
+			continue;
+
+		if (kthread_should_stop())
+			return;
+
+		status = kcompactd_compact_zone(zone, &cc);
+
+		if (zone_watermark_ok(zone, cc.order, low_wmark_pages(zone),
+				      0, 0)) {
+			if (cc.order >= zone->compact_order_failed)
+				zone->compact_order_failed = cc.order + 1;
+			count_compact_event(KCOMPACTD_SUCCESS);
+		} else if (status == COMPACT_COMPLETE) {
+			defer_compaction(zone, cc.order);
+			count_compact_event(KCOMPACTD_FAIL);
+		}
+	}
+
+	if (pgdat->kcompactd_max_order <= cc.order)
+		pgdat->kcompactd_max_order = 0;
+	if (pgdat->kcompactd_classzone_idx >= classzone_idx)
+		pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
+}
+
+static void kcompactd_do_proactive(pg_data_t *pgdat)
+{
+	struct compact_control cc = {
+		.order = sysctl_compaction_proactive_order,
+		.sync = false,
+		.proactive = true,
+	};
+	int zoneid;
+
+	for (zoneid = 0; zoneid < pgdat->nr_zones; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+
+		if (!populated_zone(zone))
+			continue;
+
+		if (!kcompactd_zone_fragmented(zone, cc.order))
+			continue;
+
+		if (kthread_should_stop())
+			return;
+
+		count_compact_event(KCOMPACTD_WAKE);
+		kcompactd_compact_zone(zone, &cc);
+
+		if (kcompactd_zone_fragmented(zone, cc.order))
+			count_compact_event(KCOMPACTD_FAIL);
+		else
+			count_compact_event(KCOMPACTD_SUCCESS);
+	}
+}
+
+static atomic_t kcompactd_tunables_gen = ATOMIC_INIT(0);
+
+static bool kcompactd_work_requested(pg_data_t *pgdat, int gen)
+{
+	return pgdat->kcompactd_max_order > 0 || kthread_should_stop() ||
+		atomic_read(&kcompactd_tunables_gen) != gen;
+}
+
+static void kcompactd_timeout(unsigned long data)
+{
+	wake_up_process((struct task_struct *)data);
+}
+
+/*
+ * Sleep until kcompactd has work or, with proactive compaction enabled,
+ * until the interval expires.  The interval runs on a deferrable timer so
+ * that the periodic check never wakes an idle CPU by itself; it is simply
+ * folded into the next wakeup that happens anyway.
+ */
+static bool kcompactd_wait_work(pg_data_t *pgdat, int gen, long timeout)
+{
+	struct timer_list timer;
+	unsigned long expire = jiffies + timeout;
+	bool requested;
+	DEFINE_WAIT(wait);
+
+	setup_deferrable_timer_on_stack(&timer, kcompactd_timeout,
+					(unsigned long)current);
+	for (;;) {
+		prepare_to_wait(&pgdat->kcompactd_wait, &wait,
+				TASK_INTERRUPTIBLE);
+		requested = kcompactd_work_requested(pgdat, gen);
+		if (requested || freezing(current))
+			break;
+		if (timeout != MAX_SCHEDULE_TIMEOUT) {
+			if (time_after_eq(jiffies, expire))
+				break;
+			mod_timer(&timer, expire);
+		}
+		schedule();
+	}
+	finish_wait(&pgdat->kcompactd_wait, &wait);
+	del_singleshot_timer_sync(&timer);
+	destroy_timer_on_stack(&timer);
+
+	if (!requested && try_to_freeze())
+		requested = kcompactd_work_requested(pgdat, gen);
+
+	return requested;
+}
+
+static int kcompactd(void *p)
+{
+	pg_data_t *pgdat = (pg_data_t *)p;
+	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
+
+	if (!cpumask_empty(cpumask))
+		set_cpus_allowed_ptr(current, cpumask);
+
+	set_freezable();
+
+	pgdat->kcompactd_max_order = 0;
+	pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
+
+	while (!kthread_should_stop()) {
+		long timeout = MAX_SCHEDULE_TIMEOUT;
+		int gen = atomic_read(&kcompactd_tunables_gen);
+
+		if (sysctl_compaction_proactive_threshold)
+			timeout = msecs_to_jiffies(
+					sysctl_compaction_proactive_interval);
+
+		if (!kcompactd_wait_work(pgdat, gen, timeout)) {
+			if (sysctl_compaction_proactive_threshold)
+				kcompactd_do_proactive(pgdat);
+			continue;
+		}
+
+		if (kthread_should_stop())
+			break;
+		if (!pgdat->kcompactd_max_order)
+			continue;
+
+		count_compact_event(KCOMPACTD_WAKE);
+		kcompactd_do_work(pgdat);
+	}
+
+	return 0;
+}
+
+void wakeup_kcompactd(pg_data_t *pgdat, int order, int classzone_idx)
+{
+	if (!order)
+		return;
+
+	if (pgdat->kcompactd_max_order < order)
+		pgdat->kcompactd_max_order = order;
+
+	if (pgdat->kcompactd_classzone_idx > classzone_idx)
+		pgdat->kcompactd_classzone_idx = classzone_idx;
+
+	if (!waitqueue_active(&pgdat->kcompactd_wait))
+		return;
+
+	wake_up_interruptible(&pgdat->kcompactd_wait);
+}
+
+int kcompactd_run(int nid)
+{
+	pg_data_t *pgdat = NODE_DATA(nid);
+	int ret = 0;
+
+	if (pgdat->kcompactd)
+		return 0;
+
+	pgdat->kcompactd = kthread_run(kcompactd, pgdat, "kcompactd%d", nid);
+	if (IS_ERR(pgdat->kcompactd)) {
+		pr_err("Failed to start kcompactd on node %d\n", nid);
+		ret = PTR_ERR(pgdat->kcompactd);
+		pgdat->kcompactd = NULL;
+	}
+	return ret;
+}
+
+void kcompactd_stop(int nid)
+{
+	struct task_struct *kcompactd = NODE_DATA(nid)->kcompactd;
+
+	if (kcompactd) {
+		kthread_stop(kcompactd);
+		NODE_DATA(nid)->kcompactd = NULL;
+	}
+}
+
+int sysctl_compaction_proactive_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int ret, nid;
+
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+
+	atomic_inc(&kcompactd_tunables_gen);
+	for_each_node_state(nid, N_HIGH_MEMORY)
+		wake_up_interruptible(&NODE_DATA(nid)->kcompactd_wait);
+
+	return 0;
+}
+
+static int __init kcompactd_init(void)
+{
+	int nid;
+
+	for_each_node_state(nid, N_HIGH_MEMORY)
+		kcompactd_run(nid);
+	return 0;
+}
+subsys_initcall(kcompactd_init)
+
 #if defined(CONFIG_SYSFS) && defined(CONFIG_NUMA)
 ssize_t sysfs_compact_node(struct device *dev,
 			struct device_attribute *attr,
@@ -85,6 +85,7 @@ struct compact_control {
 	int migratetype;		
 	struct zone *zone;
 	bool contended;			
+	bool proactive;			
 };
 
 unsigned long
@@ -0,0 +1,553 @@
+/*
+ * App launch page cache prefetcher
+ *
+ * While a thread group is being recorded, every readahead it triggers
+ * through __do_page_cache_readahead() is logged as a (file, page range)
+ * pair into a per-CPU buffer, without locks or allocations.  Paths are
+ * only resolved when recording stops.  The log can be read back from
+ * debugfs, stored by userspace and written back on a later boot.  A
+ * replay sorts the ranges per file, merges overlapping ones and submits
+ * them as readahead from a worker, so the launching process finds the
+ * pages already in the page cache.
+ *
+ * Control is through /sys/kernel/debug/launch_prefetch/:
+ *   control  "record <tgid>", "stop", "replay" or "clear"; reads back state
+ *   trace    "<start> <nr_pages> <path>" per line; writes append entries
+ */
+
+#include <linux/debugfs.h>
+#include <linux/file.h>
+#include <linux/fs.h>
+#include <linux/init.h>
+#include <linux/launch_prefetch.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/pagemap.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+#define LP_MAX_FILES	512
+#define LP_MAX_RANGES	8192
+#define LP_CPU_EVENTS	1024
+
+struct lp_file {
+	struct super_block *sb;
+	unsigned long ino;
+	char *path;
+};
+
+struct lp_range {
+	unsigned int file;
+	pgoff_t start;
+	unsigned long nr;
+};
+
+struct lp_event {
+	struct file *file;
+	pgoff_t start;
+	unsigned long nr;
+};
+
+struct lp_cpu_buf {
+	struct lp_event *ev;
+	unsigned int nr;
+	unsigned long dropped;
+};
+
+static DEFINE_PER_CPU(struct lp_cpu_buf, lp_cpu_buf);
+
+pid_t launch_prefetch_tgid;
+
+static DEFINE_MUTEX(lp_mutex);
+static struct lp_file *lp_files;
+static unsigned int lp_nr_files;
+static struct lp_range *lp_ranges;
+static unsigned int lp_nr_ranges;
+static bool lp_replaying;
+static unsigned long lp_dropped;
+static unsigned long lp_replayed_pages;
+
+static int lp_find_path(const char *path)
+{
+	int i;
+
+	for (i = lp_nr_files - 1; i >= 0; i--)
+		if (!strcmp(lp_files[i].path, path))
+			return i;
+	return -1;
+}
+
+static int lp_add_file(struct super_block *sb, unsigned long ino,
+		       const char *path)
+{
+	struct lp_file *f;
+
+	if (lp_nr_files == LP_MAX_FILES)
+		return -ENOSPC;
+
+	f = &lp_files[lp_nr_files];
+	f->path = kstrdup(path, GFP_KERNEL);
+	if (!f->path)
+		return -ENOMEM;
+	f->sb = sb;
+	f->ino = ino;
+
+	return lp_nr_files++;
+}
+
+static int lp_file_id(struct file *file)
+{
+	struct inode *inode = file->f_mapping->host;
+	char *buf, *path;
+	int i;
+
+	for (i = lp_nr_files - 1; i >= 0; i--)
+		if (lp_files[i].sb == inode->i_sb &&
+		    lp_files[i].ino == inode->i_ino)
+			return i;
+
+	buf = __getname();
+	if (!buf)
+		return -ENOMEM;
+
+	path = d_path(&file->f_path, buf, PATH_MAX);
+	if (IS_ERR(path)) {
+		i = PTR_ERR(path);
+		goto out;
+	}
+
+	i = lp_find_path(path);
+	if (i >= 0) {
+		lp_files[i].sb = inode->i_sb;
+		lp_files[i].ino = inode->i_ino;
+	} else {
+		i = lp_add_file(inode->i_sb, inode->i_ino, path);
+	}
+out:
+	__putname(buf);
+	return i;
+}
+
+static void lp_add_range(unsigned int id, pgoff_t start, unsigned long nr)
+{
+	struct lp_range *r;
+
+	if (lp_nr_ranges) {
+		r = &lp_ranges[lp_nr_ranges - 1];
+		if (r->file == id && start >= r->start &&
+		    start <= r->start + r->nr) {
+			if (start + nr > r->start + r->nr)
+				r->nr = start + nr - r->start;
+			return;
+		}
+	}
+
+	if (lp_nr_ranges == LP_MAX_RANGES) {
+		lp_dropped++;
+		return;
+	}
+
+	r = &lp_ranges[lp_nr_ranges++];
+	r->file = id;
+	r->start = start;
+	r->nr = nr;
+}
+
+void __launch_prefetch_record(struct file *file, pgoff_t start,
+			      unsigned long nr)
+{
+	struct lp_cpu_buf *buf = &get_cpu_var(lp_cpu_buf);
+	struct lp_event *ev;
+
+	if (!buf->ev || current->tgid != ACCESS_ONCE(launch_prefetch_tgid))
+		goto out;
+
+	if (buf->nr) {
+		ev = &buf->ev[buf->nr - 1];
+		if (ev->file == file && start >= ev->start &&
+		    start <= ev->start + ev->nr) {
+			if (start + nr > ev->start + ev->nr)
+				ev->nr = start + nr - ev->start;
+			goto out;
+		}
+	}
+
+	if (buf->nr == LP_CPU_EVENTS) {
+		buf->dropped++;
+		goto out;
+	}
+
+	ev = &buf->ev[buf->nr++];
+	get_file(file);
+	ev->file = file;
+	ev->start = start;
+	ev->nr = nr;
+out:
+	put_cpu_var(lp_cpu_buf);
+}
+
+static void lp_drain(void)
+{
+	struct lp_cpu_buf *buf;
+	struct lp_event *ev;
+	unsigned int i;
+	int cpu, id;
+
+	for_each_possible_cpu(cpu) {
+		buf = &per_cpu(lp_cpu_buf, cpu);
+		for (i = 0; i < buf->nr; i++) {
+			ev = &buf->ev[i];
+			id = lp_file_id(ev->file);
+			if (id < 0)
+				lp_dropped++;
+			else
+				lp_add_range(id, ev->start, ev->nr);
+			fput(ev->file);
+		}
+		lp_dropped += buf->dropped;
+		buf->nr = 0;
+		buf->dropped = 0;
+	}
+}
+
+/*
+ * Recorders check the tgid with preemption disabled, so once
+ * synchronize_sched() returns no CPU is still appending to its buffer.
+ */
+static void lp_stop(void)
+{
+	if (!launch_prefetch_tgid)
+		return;
+
+	launch_prefetch_tgid = 0;
+	synchronize_sched();
+	lp_drain();
+}
+
+static void lp_clear(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < lp_nr_files; i++)
+		kfree(lp_files[i].path);
+	lp_nr_files = 0;
+	lp_nr_ranges = 0;
+	lp_dropped = 0;
+}
+
+static int lp_range_cmp(const void *a, const void *b)
+{
+	const struct lp_range *ra = a, *rb = b;
+
+	if (ra->file != rb->file)
+		return ra->file < rb->file ? -1 : 1;
+	if (ra->start != rb->start)
+		return ra->start < rb->start ? -1 : 1;
+	return 0;
+}
+
+static void lp_sort_ranges(void)
+{
+	unsigned int i, n = 0;
+
+	if (!lp_nr_ranges)
+		return;
+
+	sort(lp_ranges, lp_nr_ranges, sizeof(*lp_ranges), lp_range_cmp, NULL);
+
+	for (i = 1; i < lp_nr_ranges; i++) {
+		struct lp_range *prev = &lp_ranges[n], *r = &lp_ranges[i];
+
+		if (r->file == prev->file &&
+		    r->start <= prev->start + prev->nr) {
+			if (r->start + r->nr > prev->start + prev->nr)
+				prev->nr = r->start + r->nr - prev->start;
+			continue;
+		}
+		lp_ranges[++n] = *r;
+	}
+	lp_nr_ranges = n + 1;
+}
+
+static void lp_replay_fn(struct work_struct *work)
+{
+	struct file *filp = NULL;
+	unsigned int i, cur = UINT_MAX;
+	int ret;
+
+	mutex_lock(&lp_mutex);
+	lp_sort_ranges();
+
+	for (i = 0; i < lp_nr_ranges; i++) {
+		struct lp_range *r = &lp_ranges[i];
+
+		if (r->file != cur) {
+			if (filp)
+				filp_close(filp, NULL);
+			cur = r->file;
+			filp = filp_open(lp_files[cur].path,
+					 O_RDONLY | O_LARGEFILE, 0);
+			if (IS_ERR(filp))
+				filp = NULL;
+		}
+		if (!filp)
+			continue;
+
+		ret = force_page_cache_readahead(filp->f_mapping, filp,
+						 r->start, r->nr);
+		if (ret > 0)
+			lp_replayed_pages += ret;
+		cond_resched();
+	}
+	if (filp)
+		filp_close(filp, NULL);
+
+	lp_replaying = false;
+	mutex_unlock(&lp_mutex);
+}
+
+static DECLARE_WORK(lp_replay_work, lp_replay_fn);
+
+static int lp_control_show(struct seq_file *m, void *v)
+{
+	mutex_lock(&lp_mutex);
+	if (launch_prefetch_tgid)
+		seq_printf(m, "state: recording %d\n", launch_prefetch_tgid);
+	else
+		seq_printf(m, "state: %s\n",
+			   lp_replaying ? "replaying" : "idle");
+	seq_printf(m, "files: %u\n", lp_nr_files);
+	seq_printf(m, "ranges: %u\n", lp_nr_ranges);
+	seq_printf(m, "dropped: %lu\n", lp_dropped);
+	seq_printf(m, "replayed_pages: %lu\n", lp_replayed_pages);
+	mutex_unlock(&lp_mutex);
+
+	return 0;
+}
+
+static int lp_control_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lp_control_show, NULL);
+}
+
+static ssize_t lp_control_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	char buf[32];
+	int tgid;
+	int err = 0;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	mutex_lock(&lp_mutex);
+	if (lp_replaying) {
+		err = -EBUSY;
+	} else if (sscanf(buf, "record %d", &tgid) == 1) {
+		if (tgid <= 0)
+			err = -EINVAL;
+		else
+			launch_prefetch_tgid = tgid;
+	} else if (sysfs_streq(buf, "stop")) {
+		lp_stop();
+	} else if (sysfs_streq(buf, "clear")) {
+		lp_stop();
+		lp_clear();
+	} else if (sysfs_streq(buf, "replay")) {
+		lp_stop();
+		lp_replaying = true;
+		lp_replayed_pages = 0;
+		queue_work(system_unbound_wq, &lp_replay_work);
+	} else {
+		err = -EINVAL;
+	}
+	mutex_unlock(&lp_mutex);
+
+	return err ? err : count;
+}
+
+static const struct file_operations lp_control_fops = {
+	.open		= lp_control_open,
+	.read		= seq_read,
+	.write		= lp_control_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/*
+ * lp_mutex is only taken around each line, never across seq_read(), so a
+ * fault on the user buffer cannot come back into it.
+ */
+static void *lp_trace_start(struct seq_file *m, loff_t *pos)
+{
+	if (*pos >= ACCESS_ONCE(lp_nr_ranges))
+		return NULL;
+	return (void *)(unsigned long)(*pos + 1);
+}
+
+static void *lp_trace_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	++*pos;
+	return lp_trace_start(m, pos);
+}
+
+static void lp_trace_stop(struct seq_file *m, void *v)
+{
+}
+
+static int lp_trace_show(struct seq_file *m, void *v)
+{
+	unsigned long i = (unsigned long)v - 1;
+	struct lp_range *r;
+
+	mutex_lock(&lp_mutex);
+	if (i < lp_nr_ranges) {
+		r = &lp_ranges[i];
+		seq_printf(m, "%lu %lu %s\n", (unsigned long)r->start, r->nr,
+			   lp_files[r->file].path);
+	}
+	mutex_unlock(&lp_mutex);
+	return 0;
+}
+
+static const struct seq_operations lp_trace_seq_ops = {
+	.start	= lp_trace_start,
+	.next	= lp_trace_next,
+	.stop	= lp_trace_stop,
+	.show	= lp_trace_show,
+};
+
+static int lp_trace_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &lp_trace_seq_ops);
+}
+
+static int lp_trace_parse(char *line)
+{
+	unsigned long start, nr;
+	int pos = 0;
+	int id;
+
+	if (sscanf(line, "%lu %lu %n", &start, &nr, &pos) != 2 || !pos ||
+	    line[pos] != '/' || !nr)
+		return -EINVAL;
+
+	id = lp_find_path(line + pos);
+	if (id < 0)
+		id = lp_add_file(NULL, 0, line + pos);
+	if (id < 0)
+		return id;
+
+	lp_add_range(id, start, nr);
+	return 0;
+}
+
+/*
+ * Only whole lines are consumed; a trailing partial line is left for the
+ * next write, unless it is all that was passed in.
+ */
+static ssize_t lp_trace_write(struct file *file, const char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	char *buf, *line, *end;
+	size_t len = min_t(size_t, count, PAGE_SIZE - 1);
+	ssize_t done = 0;
+	int err = 0;
+
+	buf = (char *)__get_free_page(GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	if (copy_from_user(buf, ubuf, len)) {
+		free_page((unsigned long)buf);
+		return -EFAULT;
+	}
+	buf[len] = '\0';
+
+	mutex_lock(&lp_mutex);
+	if (lp_replaying || launch_prefetch_tgid) {
+		err = -EBUSY;
+		goto out;
+	}
+
+	for (line = buf; line < buf + len; line = end + 1) {
+		end = strchr(line, '\n');
+		if (!end) {
+			if (done)
+				break;
+			end = buf + len;
+		}
+		*end = '\0';
+		if (*line) {
+			err = lp_trace_parse(line);
+			if (err)
+				break;
+		}
+		done = end + 1 - buf;
+	}
+out:
+	mutex_unlock(&lp_mutex);
+	free_page((unsigned long)buf);
+
+	if (done)
+		return min_t(size_t, done, count);
+	return err;
+}
+
+static const struct file_operations lp_trace_fops = {
+	.open		= lp_trace_open,
+	.read		= seq_read,
+	.write		= lp_trace_write,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int __init launch_prefetch_init(void)
+{
+	struct dentry *dir;
+	int cpu;
+
+	lp_files = kcalloc(LP_MAX_FILES, sizeof(*lp_files), GFP_KERNEL);
+	lp_ranges = vmalloc(LP_MAX_RANGES * sizeof(*lp_ranges));
+	if (!lp_files || !lp_ranges)
+		goto err;
+
+	for_each_possible_cpu(cpu) {
+		struct lp_cpu_buf *buf = &per_cpu(lp_cpu_buf, cpu);
+
+		buf->ev = vmalloc(LP_CPU_EVENTS * sizeof(*buf->ev));
+		if (!buf->ev)
+			goto err;
+	}
+
+	dir = debugfs_create_dir("launch_prefetch", NULL);
+	if (IS_ERR_OR_NULL(dir))
+		goto err;
+
+	debugfs_create_file("control", 0600, dir, NULL, &lp_control_fops);
+	debugfs_create_file("trace", 0600, dir, NULL, &lp_trace_fops);
+
+	return 0;
+
+err:
+	for_each_possible_cpu(cpu) {
+		vfree(per_cpu(lp_cpu_buf, cpu).ev);
+		per_cpu(lp_cpu_buf, cpu).ev = NULL;
+	}
+	kfree(lp_files);
+	vfree(lp_ranges);
+	lp_files = NULL;
+	lp_ranges = NULL;
+	return -ENOMEM;
+}
+late_initcall(launch_prefetch_init);
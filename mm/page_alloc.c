@@ -1843,6 +1843,23 @@ void wake_all_kswapd(unsigned int order, struct zonelist *zonelist,
 		wakeup_kswapd(zone, order, classzone_idx);
 }
 
+static inline
+void wake_all_kcompactd(unsigned int order, struct zonelist *zonelist,
+			enum zone_type high_zoneidx,
+			enum zone_type classzone_idx)
+{
+	struct zoneref *z;
+	struct zone *zone;
+	pg_data_t *last_pgdat = NULL;
+
+	for_each_zone_zonelist(zone, z, zonelist, high_zoneidx) {
+		if (zone->zone_pgdat == last_pgdat)
+			continue;
+		last_pgdat = zone->zone_pgdat;
+		wakeup_kcompactd(last_pgdat, order, classzone_idx);
+	}
+}
+
 static inline int
 gfp_to_alloc_flags(gfp_t gfp_mask)
 {
@@ -1898,9 +1915,17 @@ __alloc_pages_slowpath(gfp_t gfp_mask, unsigned int order,
 		goto nopage;
 
 restart:
+	/*
+	 * kswapd compacts after reclaiming for high order requests. Users
+	 * such as ion opt out of kswapd and fall back to smaller orders
+	 * instead, so let kcompactd rebuild blocks for their next attempt.
+	 */
 	if (!(gfp_mask & __GFP_NO_KSWAPD))
 		wake_all_kswapd(order, zonelist, high_zoneidx,
 						zone_idx(preferred_zone));
+	else if (order)
+		wake_all_kcompactd(order, zonelist, high_zoneidx,
+				   zone_idx(preferred_zone));
 
 	alloc_flags = gfp_to_alloc_flags(gfp_mask);
 
@@ -3488,6 +3513,9 @@ static void __paginginit free_area_init_core(struct pglist_data *pgdat,
 	pgdat->nr_zones = 0;
 	init_waitqueue_head(&pgdat->kswapd_wait);
 	pgdat->kswapd_max_order = 0;
+#ifdef CONFIG_COMPACTION
+	init_waitqueue_head(&pgdat->kcompactd_wait);
+#endif
 	pgdat_page_cgroup_init(pgdat);
 
 	for (j = 0; j < MAX_NR_ZONES; j++) {
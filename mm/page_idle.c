@@ -0,0 +1,228 @@
+/*
+ * Idle page tracking
+ *
+ * /sys/kernel/mm/page_idle/bitmap is a PFN indexed bitmap, read and
+ * written in 8 byte chunks. Setting a bit marks the corresponding user
+ * page idle after clearing the accessed bits of all ptes mapping it;
+ * reading returns the pages that are still idle, i.e. that have not been
+ * accessed since. Pages that are not on the LRU are ignored.
+ *
+ * The accessed bits are harvested through a dedicated rmap walk that only
+ * clears pte young bits. Any reference found that way clears the idle flag
+ * and is remembered in a per page young flag, which page_referenced()
+ * consumes, so reclaim does not lose aging information.
+ */
+
+#include <linux/init.h>
+#include <linux/kobject.h>
+#include <linux/mm.h>
+#include <linux/mmu_notifier.h>
+#include <linux/mmzone.h>
+#include <linux/pagemap.h>
+#include <linux/page_idle.h>
+#include <linux/rmap.h>
+#include <linux/sched.h>
+#include <linux/sysfs.h>
+#include <linux/vmalloc.h>
+
+#define BITMAP_CHUNK_SIZE	sizeof(u64)
+#define BITMAP_CHUNK_BITS	(BITMAP_CHUNK_SIZE * BITS_PER_BYTE)
+
+unsigned long *page_idle_flags;
+unsigned long page_idle_start_pfn;
+unsigned long page_idle_end_pfn;
+
+static struct page *page_idle_get_page(unsigned long pfn)
+{
+	struct page *page;
+
+	if (!pfn_valid(pfn))
+		return NULL;
+
+	page = pfn_to_page(pfn);
+	if (!page || !PageLRU(page) || !get_page_unless_zero(page))
+		return NULL;
+
+	if (unlikely(!PageLRU(page))) {
+		put_page(page);
+		page = NULL;
+	}
+	return page;
+}
+
+static int page_idle_clear_pte_refs_one(struct page *page,
+					struct vm_area_struct *vma,
+					unsigned long addr, void *arg)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	int referenced = 0;
+
+	if (unlikely(PageTransHuge(page))) {
+		pmd_t *pmd;
+
+		spin_lock(&mm->page_table_lock);
+		pmd = page_check_address_pmd(page, mm, addr,
+					     PAGE_CHECK_ADDRESS_PMD_FLAG);
+		if (pmd)
+			referenced = pmdp_clear_flush_young_notify(vma, addr,
+								   pmd);
+		spin_unlock(&mm->page_table_lock);
+	} else {
+		pte_t *pte;
+		spinlock_t *ptl;
+
+		pte = page_check_address(page, mm, addr, &ptl, 0);
+		if (pte) {
+			referenced = ptep_clear_flush_young_notify(vma, addr,
+								   pte);
+			pte_unmap_unlock(pte, ptl);
+		}
+	}
+
+	if (referenced) {
+		clear_page_idle(page);
+		set_page_young(page);
+	}
+	return SWAP_AGAIN;
+}
+
+static void page_idle_clear_pte_refs(struct page *page)
+{
+	if (!page_mapped(page) || !page_rmapping(page))
+		return;
+
+	if (!trylock_page(page))
+		return;
+
+	rmap_walk(page, page_idle_clear_pte_refs_one, NULL);
+	unlock_page(page);
+}
+
+static ssize_t page_idle_bitmap_read(struct file *file, struct kobject *kobj,
+				     struct bin_attribute *attr, char *buf,
+				     loff_t pos, size_t count)
+{
+	u64 *out = (u64 *)buf;
+	struct page *page;
+	unsigned long pfn, end_pfn;
+	int bit;
+
+	if (pos % BITMAP_CHUNK_SIZE || count % BITMAP_CHUNK_SIZE)
+		return -EINVAL;
+
+	pfn = pos * BITS_PER_BYTE;
+	if (pfn >= page_idle_end_pfn)
+		return 0;
+
+	end_pfn = pfn + count * BITS_PER_BYTE;
+	if (end_pfn > page_idle_end_pfn)
+		end_pfn = ALIGN(page_idle_end_pfn, BITMAP_CHUNK_BITS);
+
+	for (; pfn < end_pfn; pfn++) {
+		bit = pfn % BITMAP_CHUNK_BITS;
+		if (!bit)
+			*out = 0ULL;
+		page = page_idle_get_page(pfn);
+		if (page) {
+			if (page_is_idle(page)) {
+				page_idle_clear_pte_refs(page);
+				if (page_is_idle(page))
+					*out |= 1ULL << bit;
+			}
+			put_page(page);
+		}
+		if (bit == BITMAP_CHUNK_BITS - 1)
+			out++;
+		cond_resched();
+	}
+	return (char *)out - buf;
+}
+
+static ssize_t page_idle_bitmap_write(struct file *file, struct kobject *kobj,
+				      struct bin_attribute *attr, char *buf,
+				      loff_t pos, size_t count)
+{
+	const u64 *in = (u64 *)buf;
+	struct page *page;
+	unsigned long pfn, end_pfn;
+	int bit;
+
+	if (pos % BITMAP_CHUNK_SIZE || count % BITMAP_CHUNK_SIZE)
+		return -EINVAL;
+
+	pfn = pos * BITS_PER_BYTE;
+	if (pfn >= page_idle_end_pfn)
+		return -ENXIO;
+
+	end_pfn = pfn + count * BITS_PER_BYTE;
+	if (end_pfn > page_idle_end_pfn)
+		end_pfn = ALIGN(page_idle_end_pfn, BITMAP_CHUNK_BITS);
+
+	for (; pfn < end_pfn; pfn++) {
+		bit = pfn % BITMAP_CHUNK_BITS;
+		if ((*in >> bit) & 1) {
+			page = page_idle_get_page(pfn);
+			if (page) {
+				page_idle_clear_pte_refs(page);
+				set_page_idle(page);
+				put_page(page);
+			}
+		}
+		if (bit == BITMAP_CHUNK_BITS - 1)
+			in++;
+		cond_resched();
+	}
+	return (char *)in - buf;
+}
+
+static struct bin_attribute page_idle_bitmap_attr = {
+	.attr = {
+		.name = "bitmap",
+		.mode = S_IRUSR | S_IWUSR,
+	},
+	.read = page_idle_bitmap_read,
+	.write = page_idle_bitmap_write,
+};
+
+static int __init page_idle_init(void)
+{
+	struct kobject *kobj;
+	struct zone *zone;
+	unsigned long start = ULONG_MAX, end = 0;
+	int err;
+
+	for_each_populated_zone(zone) {
+		start = min(start, zone->zone_start_pfn);
+		end = max(end, zone->zone_start_pfn + zone->spanned_pages);
+	}
+	if (start >= end)
+		return -ENODEV;
+
+	page_idle_flags = vzalloc(BITS_TO_LONGS(2 * (end - start)) *
+				  sizeof(unsigned long));
+	if (!page_idle_flags)
+		return -ENOMEM;
+
+	kobj = kobject_create_and_add("page_idle", mm_kobj);
+	if (!kobj) {
+		err = -ENOMEM;
+		goto err_free;
+	}
+
+	err = sysfs_create_bin_file(kobj, &page_idle_bitmap_attr);
+	if (err) {
+		kobject_put(kobj);
+		goto err_free;
+	}
+
+	page_idle_start_pfn = start;
+	smp_wmb();
+	page_idle_end_pfn = end;
+	return 0;
+
+err_free:
+	vfree(page_idle_flags);
+	page_idle_flags = NULL;
+	return err;
+}
+late_initcall(page_idle_init);
@@ -17,6 +17,7 @@
 #include <linux/task_io_accounting_ops.h>
 #include <linux/pagevec.h>
 #include <linux/pagemap.h>
+#include <linux/launch_prefetch.h>
 
 #include <trace/events/mmcio.h>
 void
@@ -161,6 +162,10 @@ __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 
 	if (ret) {
 		trace_readahead(filp, ret);
+		if (filp)
+			launch_prefetch_record(filp, offset,
+				min_t(unsigned long, nr_to_read,
+				      end_index - offset + 1));
 		read_pages(mapping, filp, &page_pool, ret);
 	}
 	BUG_ON(!list_empty(&page_pool));
@@ -196,6 +201,7 @@ int force_page_cache_readahead(struct address_space *mapping, struct file *filp,
 	}
 	return ret;
 }
+EXPORT_SYMBOL_GPL(force_page_cache_readahead);
 
 unsigned long max_sane_readahead(unsigned long nr)
 {
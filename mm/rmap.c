@@ -31,6 +31,7 @@
 #include <linux/memcontrol.h>
 #include <linux/mmu_notifier.h>
 #include <linux/migrate.h>
+#include <linux/page_idle.h>
 #include <linux/hugetlb.h>
 
 #include <htc_debug/stability/htc_report_meminfo.h>
@@ -617,6 +618,11 @@ int page_referenced(struct page *page,
 		if (page_test_and_clear_young(page_to_pfn(page)))
 			referenced++;
 	}
+
+	if (test_and_clear_page_young(page))
+		referenced++;
+	if (referenced)
+		clear_page_idle(page);
 out:
 	return referenced;
 }
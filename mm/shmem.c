@@ -778,7 +778,7 @@ repeat:
 
 	if (swap.val) {
 		
-		page = lookup_swap_cache(swap);
+		page = lookup_swap_cache(swap, NULL, 0);
 		if (!page) {
 			
 			if (fault_type)
@@ -22,6 +22,7 @@
 #include <linux/backing-dev.h>
 #include <linux/memcontrol.h>
 #include <linux/gfp.h>
+#include <linux/page_idle.h>
 #include <htc_debug/stability/htc_report_meminfo.h>
 
 #include "internal.h"
@@ -305,6 +306,7 @@ void mark_page_accessed(struct page *page)
 	} else if (!PageReferenced(page)) {
 		SetPageReferenced(page);
 	}
+	clear_page_idle(page);
 }
 EXPORT_SYMBOL(mark_page_accessed);
 
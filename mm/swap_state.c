@@ -18,6 +18,9 @@
 #include <linux/migrate.h>
 #include <linux/page_cgroup.h>
 #include <linux/export.h>
+#include <linux/pfn.h>
+#include <linux/kobject.h>
+#include <linux/sysfs.h>
 
 #include <asm/pgtable.h>
 
@@ -117,6 +120,8 @@ void __delete_from_swap_cache(struct page *page)
 	total_swapcache_pages--;
 	__dec_zone_page_state(page, NR_FILE_PAGES);
 	INC_CACHE_INFO(del_total);
+	if (TestClearPageReadahead(page))
+		count_vm_event(SWAP_RA_MISS);
 }
 
 int add_to_swap(struct page *page)
@@ -194,21 +199,57 @@ void free_pages_and_swap_cache(struct page **pages, int nr)
 	}
 }
 
-struct page * lookup_swap_cache(swp_entry_t entry)
+#define SWAP_RA_WIN_SHIFT	(PAGE_SHIFT / 2)
+#define SWAP_RA_HITS_MASK	((1UL << SWAP_RA_WIN_SHIFT) - 1)
+#define SWAP_RA_HITS_MAX	SWAP_RA_HITS_MASK
+#define SWAP_RA_WIN_MASK	(~PAGE_MASK & ~SWAP_RA_HITS_MASK)
+#define SWAP_RA_WIN_MAX		32
+
+#define SWAP_RA_HITS(v)		((v) & SWAP_RA_HITS_MASK)
+#define SWAP_RA_WIN(v)		(((v) & SWAP_RA_WIN_MASK) >> SWAP_RA_WIN_SHIFT)
+#define SWAP_RA_ADDR(v)		((v) & PAGE_MASK)
+
+#define SWAP_RA_VAL(addr, win, hits)				\
+	(((addr) & PAGE_MASK) |					\
+	 (((win) << SWAP_RA_WIN_SHIFT) & SWAP_RA_WIN_MASK) |	\
+	 ((hits) & SWAP_RA_HITS_MASK))
+
+static bool swap_vma_ra_enabled = true;
+
+static void swap_ra_hit(struct vm_area_struct *vma, unsigned long addr)
+{
+	unsigned long ra_val = atomic_long_read(&vma->swap_readahead_info);
+	unsigned long hits = SWAP_RA_HITS(ra_val);
+
+	if (hits < SWAP_RA_HITS_MAX)
+		hits++;
+	atomic_long_set(&vma->swap_readahead_info,
+			SWAP_RA_VAL(addr, SWAP_RA_WIN(ra_val), hits));
+}
+
+struct page *lookup_swap_cache(swp_entry_t entry, struct vm_area_struct *vma,
+			       unsigned long addr)
 {
 	struct page *page;
 
 	page = find_get_page(&swapper_space, entry.val);
 
-	if (page)
+	if (page) {
 		INC_CACHE_INFO(find_success);
+		if (TestClearPageReadahead(page)) {
+			count_vm_event(SWAP_RA_HIT);
+			if (vma)
+				swap_ra_hit(vma, addr);
+		}
+	}
 
 	INC_CACHE_INFO(find_total);
 	return page;
 }
 
-struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
-			struct vm_area_struct *vma, unsigned long addr)
+static struct page *__read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr,
+			bool readahead)
 {
 	struct page *found_page, *new_page = NULL;
 	int err;
@@ -245,6 +286,10 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 		if (likely(!err)) {
 			radix_tree_preload_end();
 			lru_cache_add_anon(new_page);
+			if (readahead) {
+				SetPageReadahead(new_page);
+				count_vm_event(SWAP_RA);
+			}
 			swap_readpage(new_page);
 			return new_page;
 		}
@@ -259,24 +304,31 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
+struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr)
+{
+	return __read_swap_cache_async(entry, gfp_mask, vma, addr, false);
+}
+
 struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			struct vm_area_struct *vma, unsigned long addr)
 {
 	struct page *page;
-	unsigned long offset = swp_offset(entry);
+	unsigned long offset;
 	unsigned long start_offset, end_offset;
 	unsigned long mask = (1UL << page_cluster) - 1;
 
 	
-	start_offset = offset & ~mask;
-	end_offset = offset | mask;
+	start_offset = swp_offset(entry) & ~mask;
+	end_offset = swp_offset(entry) | mask;
 	if (!start_offset)	
 		start_offset++;
 
 	for (offset = start_offset; offset <= end_offset ; offset++) {
 		
-		page = read_swap_cache_async(swp_entry(swp_type(entry), offset),
-						gfp_mask, vma, addr);
+		page = __read_swap_cache_async(swp_entry(swp_type(entry),
+						offset), gfp_mask, vma, addr,
+						offset != swp_offset(entry));
 		if (!page)
 			continue;
 		page_cache_release(page);
@@ -284,3 +336,164 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 	lru_add_drain();	
 	return read_swap_cache_async(entry, gfp_mask, vma, addr);
 }
+
+static unsigned int swap_ra_window(unsigned long prev_pfn, unsigned long pfn,
+				   unsigned int hits, unsigned int max_win,
+				   unsigned int prev_win)
+{
+	unsigned int win, roundup;
+
+	win = hits + 2;
+	if (win == 2) {
+		if (pfn != prev_pfn + 1 && pfn != prev_pfn - 1)
+			win = 1;
+	} else {
+		for (roundup = 4; roundup < win; roundup <<= 1)
+			;
+		win = roundup;
+	}
+
+	if (win > max_win)
+		win = max_win;
+
+	if (win < prev_win / 2)
+		win = prev_win / 2;
+
+	return win;
+}
+
+static void swap_ra_clamp_pfn(struct vm_area_struct *vma, unsigned long faddr,
+			      unsigned long lpfn, unsigned long rpfn,
+			      unsigned long *start, unsigned long *end)
+{
+	*start = max3(lpfn, PFN_DOWN(vma->vm_start),
+		      PFN_DOWN(faddr & PMD_MASK));
+	*end = min3(rpfn, PFN_DOWN(vma->vm_end),
+		    PFN_DOWN((faddr & PMD_MASK) + PMD_SIZE));
+}
+
+struct page *swap_vma_readahead(swp_entry_t fentry, gfp_t gfp_mask,
+				struct vm_area_struct *vma, unsigned long addr,
+				pmd_t *pmd)
+{
+	pte_t ptes[SWAP_RA_WIN_MAX];
+	unsigned long ra_val, faddr, fpfn, pfn, start, end, left;
+	unsigned int max_win, win, prev_win, hits, i, nr_pte;
+	pte_t *pte;
+	struct page *page;
+
+	if (!swap_vma_ra_enabled)
+		return swapin_readahead(fentry, gfp_mask, vma, addr);
+
+	max_win = min_t(unsigned int, 1 << page_cluster, SWAP_RA_WIN_MAX);
+	if (max_win == 1)
+		goto skip;
+
+	faddr = addr & PAGE_MASK;
+	fpfn = PFN_DOWN(faddr);
+	ra_val = atomic_long_read(&vma->swap_readahead_info);
+	pfn = PFN_DOWN(SWAP_RA_ADDR(ra_val));
+	prev_win = SWAP_RA_WIN(ra_val);
+	hits = SWAP_RA_HITS(ra_val);
+	win = swap_ra_window(pfn, fpfn, hits, max_win, prev_win);
+	atomic_long_set(&vma->swap_readahead_info, SWAP_RA_VAL(faddr, win, 0));
+
+	if (win == 1)
+		goto skip;
+
+	if (fpfn == pfn + 1) {
+		swap_ra_clamp_pfn(vma, faddr, fpfn, fpfn + win, &start, &end);
+	} else if (pfn == fpfn + 1) {
+		swap_ra_clamp_pfn(vma, faddr, fpfn - win + 1, fpfn + 1,
+				  &start, &end);
+	} else {
+		left = (win - 1) / 2;
+		swap_ra_clamp_pfn(vma, faddr, fpfn - left, fpfn + win - left,
+				  &start, &end);
+	}
+
+	if (start >= end)
+		goto skip;
+
+	nr_pte = end - start;
+	pte = pte_offset_map(pmd, start << PAGE_SHIFT);
+	for (i = 0; i < nr_pte; i++)
+		ptes[i] = pte[i];
+	pte_unmap(pte);
+
+	for (i = 0; i < nr_pte; i++) {
+		swp_entry_t entry;
+		unsigned long ra_addr = (start + i) << PAGE_SHIFT;
+
+		if (ra_addr == faddr)
+			continue;
+		if (pte_none(ptes[i]) || pte_present(ptes[i]) ||
+		    pte_file(ptes[i]))
+			continue;
+		entry = pte_to_swp_entry(ptes[i]);
+		if (unlikely(non_swap_entry(entry)))
+			continue;
+		page = __read_swap_cache_async(entry, gfp_mask, vma, ra_addr,
+					       true);
+		if (!page)
+			continue;
+		page_cache_release(page);
+	}
+	lru_add_drain();
+skip:
+	return read_swap_cache_async(fentry, gfp_mask, vma, addr);
+}
+
+#ifdef CONFIG_SYSFS
+static ssize_t vma_ra_enabled_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%s\n", swap_vma_ra_enabled ? "true" : "false");
+}
+
+static ssize_t vma_ra_enabled_store(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    const char *buf, size_t count)
+{
+	if (!strncmp(buf, "true", 4) || !strncmp(buf, "1", 1))
+		swap_vma_ra_enabled = true;
+	else if (!strncmp(buf, "false", 5) || !strncmp(buf, "0", 1))
+		swap_vma_ra_enabled = false;
+	else
+		return -EINVAL;
+
+	return count;
+}
+
+static struct kobj_attribute vma_ra_enabled_attr =
+	__ATTR(vma_ra_enabled, 0644, vma_ra_enabled_show,
+	       vma_ra_enabled_store);
+
+static struct attribute *swap_attrs[] = {
+	&vma_ra_enabled_attr.attr,
+	NULL,
+};
+
+static struct attribute_group swap_attr_group = {
+	.attrs = swap_attrs,
+};
+
+static int __init swap_init_sysfs(void)
+{
+	struct kobject *swap_kobj;
+	int err;
+
+	swap_kobj = kobject_create_and_add("swap", mm_kobj);
+	if (!swap_kobj)
+		return -ENOMEM;
+
+	err = sysfs_create_group(swap_kobj, &swap_attr_group);
+	if (err) {
+		kobject_put(swap_kobj);
+		return err;
+	}
+
+	return 0;
+}
+late_initcall(swap_init_sysfs);
+#endif
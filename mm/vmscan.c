@@ -748,6 +748,47 @@ unsigned long reclaim_clean_pages_from_list(struct zone *zone,
 	return ret;
 }
 
+#ifdef CONFIG_PROCESS_RECLAIM
+unsigned long reclaim_pages_from_list(struct list_head *page_list)
+{
+	struct scan_control sc = {
+		.gfp_mask = GFP_KERNEL,
+		.priority = DEF_PRIORITY,
+		.may_writepage = 1,
+		.may_unmap = 1,
+		.may_swap = 1,
+	};
+	unsigned long nr_reclaimed = 0;
+	unsigned long dummy1, dummy2;
+	struct page *page;
+	LIST_HEAD(single);
+
+	while (!list_empty(page_list)) {
+		struct zone *zone;
+		int file;
+
+		page = lru_to_page(page_list);
+		zone = page_zone(page);
+		file = page_is_file_cache(page);
+		list_move(&page->lru, &single);
+		ClearPageActive(page);
+
+		nr_reclaimed += shrink_page_list(&single, zone, &sc,
+					TTU_UNMAP|TTU_IGNORE_ACCESS,
+					&dummy1, &dummy2, true);
+		mod_zone_page_state(zone, NR_ISOLATED_ANON + file, -1);
+
+		if (!list_empty(&single)) {
+			page = lru_to_page(&single);
+			list_del(&page->lru);
+			putback_lru_page(page);
+		}
+	}
+
+	return nr_reclaimed;
+}
+#endif
+
 int __isolate_lru_page(struct page *page, isolate_mode_t mode)
 {
 	int ret = -EINVAL;
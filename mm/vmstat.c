@@ -596,6 +596,9 @@ const char * const vmstat_text[] = {
 	"compact_stall",
 	"compact_fail",
 	"compact_success",
+	"compact_daemon_wake",
+	"compact_daemon_success",
+	"compact_daemon_fail",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
@@ -610,6 +613,11 @@ const char * const vmstat_text[] = {
 	"unevictable_pgs_cleared",
 	"unevictable_pgs_stranded",
 	"unevictable_pgs_mlockfreed",
+#ifdef CONFIG_SWAP
+	"swap_ra",
+	"swap_ra_hit",
+	"swap_ra_miss",
+#endif
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	"thp_fault_alloc",
@@ -0,0 +1,398 @@
+/*
+ * FUSE passthrough throughput test.
+ *
+ * A minimal daemon speaking the raw /dev/fuse protocol exports a single
+ * file backed by a regular file in /tmp.  The file is written and read
+ * sequentially in large chunks and then read at random 4k offsets, once
+ * with every READ and WRITE served by the daemon and once with the
+ * backing file handed to the kernel through FOPEN_PASSTHROUGH.  Caches of
+ * both files are dropped before each read phase.  Throughput of each
+ * phase is printed for both modes, and the passthrough run checks that no
+ * READ or WRITE reached the daemon.
+ * Please run as root.
+ *
+ * usage: fuse_passthrough [MB]
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include "../../../../include/linux/fuse.h"
+
+#define FILE_NAME	"file"
+#define FILE_INO	2
+#define CHUNK		(128 * 1024)
+#define RAND_LEN	4096
+#define RAND_COUNT	4096
+#define DEFAULT_MB	32
+
+struct daemon_state {
+	int use_passthrough;
+	int passthrough;
+	unsigned long reads;
+	unsigned long writes;
+};
+
+static struct daemon_state *st;
+static char mnt[] = "/tmp/fuse_pt.XXXXXX";
+static char backing[] = "/tmp/fuse_pt_file.XXXXXX";
+static int backing_fd;
+static size_t file_len;
+
+static void fill_attr(struct fuse_attr *attr, unsigned long long ino)
+{
+	struct stat s;
+
+	memset(attr, 0, sizeof(*attr));
+	attr->ino = ino;
+	attr->nlink = 1;
+	attr->blksize = 4096;
+	if (ino == FUSE_ROOT_ID) {
+		attr->mode = S_IFDIR | 0755;
+		attr->nlink = 2;
+		return;
+	}
+	fstat(backing_fd, &s);
+	attr->mode = S_IFREG | 0644;
+	attr->size = s.st_size;
+	attr->blocks = s.st_blocks;
+	attr->mtime = s.st_mtime;
+	attr->ctime = s.st_ctime;
+	attr->atime = s.st_atime;
+}
+
+static void reply(int fd, struct fuse_in_header *in, int error,
+		  const void *arg, size_t len)
+{
+	struct fuse_out_header out;
+	struct iovec iov[2];
+
+	out.len = sizeof(out) + (error ? 0 : len);
+	out.error = error;
+	out.unique = in->unique;
+	iov[0].iov_base = &out;
+	iov[0].iov_len = sizeof(out);
+	iov[1].iov_base = (void *)arg;
+	iov[1].iov_len = error ? 0 : len;
+	if (writev(fd, iov, 2) < 0 && errno != ENOENT)
+		perror("fuse reply");
+}
+
+static void handle(int fd, struct fuse_in_header *in, void *arg, char *data)
+{
+	union {
+		struct fuse_init_out init;
+		struct fuse_entry_out entry;
+		struct fuse_attr_out attr;
+		struct fuse_open_out open;
+		struct fuse_write_out write;
+	} out;
+	int lower;
+
+	memset(&out, 0, sizeof(out));
+
+	switch (in->opcode) {
+	case FUSE_INIT: {
+		struct fuse_init_in *init = arg;
+
+		out.init.major = FUSE_KERNEL_VERSION;
+		out.init.minor = FUSE_KERNEL_MINOR_VERSION;
+		out.init.max_readahead = init->max_readahead;
+		out.init.flags = init->flags & FUSE_BIG_WRITES;
+		if (st->use_passthrough)
+			out.init.flags |= init->flags & FUSE_PASSTHROUGH;
+		out.init.max_background = 16;
+		out.init.congestion_threshold = 12;
+		out.init.max_write = CHUNK;
+		st->passthrough = !!(out.init.flags & FUSE_PASSTHROUGH);
+		reply(fd, in, 0, &out.init, sizeof(out.init));
+		break;
+	}
+	case FUSE_LOOKUP:
+		if (in->nodeid != FUSE_ROOT_ID || strcmp(arg, FILE_NAME)) {
+			reply(fd, in, -ENOENT, NULL, 0);
+			break;
+		}
+		out.entry.nodeid = FILE_INO;
+		fill_attr(&out.entry.attr, FILE_INO);
+		reply(fd, in, 0, &out.entry, sizeof(out.entry));
+		break;
+	case FUSE_GETATTR:
+	case FUSE_SETATTR:
+		fill_attr(&out.attr.attr, in->nodeid);
+		reply(fd, in, 0, &out.attr, sizeof(out.attr));
+		break;
+	case FUSE_OPEN:
+		out.open.passthrough_fd = -1;
+		lower = -1;
+		if (st->passthrough) {
+			lower = open(backing, O_RDWR);
+			if (lower >= 0) {
+				out.open.open_flags = FOPEN_PASSTHROUGH;
+				out.open.passthrough_fd = lower;
+			}
+		}
+		reply(fd, in, 0, &out.open, sizeof(out.open));
+		/* the kernel took its own reference while reading the reply */
+		if (lower >= 0)
+			close(lower);
+		break;
+	case FUSE_OPENDIR:
+		out.open.passthrough_fd = -1;
+		reply(fd, in, 0, &out.open, sizeof(out.open));
+		break;
+	case FUSE_READ: {
+		struct fuse_read_in *rd = arg;
+		ssize_t n;
+
+		st->reads++;
+		n = pread(backing_fd, data, rd->size, rd->offset);
+		reply(fd, in, n < 0 ? -errno : 0, data, n < 0 ? 0 : n);
+		break;
+	}
+	case FUSE_WRITE: {
+		struct fuse_write_in *wr = arg;
+		ssize_t n;
+
+		st->writes++;
+		n = pwrite(backing_fd, wr + 1, wr->size, wr->offset);
+		out.write.size = n < 0 ? 0 : n;
+		reply(fd, in, n < 0 ? -errno : 0, &out.write,
+		      sizeof(out.write));
+		break;
+	}
+	case FUSE_FSYNC:
+		reply(fd, in, fdatasync(backing_fd) ? -errno : 0, NULL, 0);
+		break;
+	case FUSE_FLUSH:
+	case FUSE_RELEASE:
+	case FUSE_RELEASEDIR:
+		reply(fd, in, 0, NULL, 0);
+		break;
+	case FUSE_FORGET:
+	case FUSE_BATCH_FORGET:
+		break;
+	default:
+		reply(fd, in, -ENOSYS, NULL, 0);
+		break;
+	}
+}
+
+static void serve(int fd)
+{
+	char *buf = malloc(CHUNK + 4096);
+	char *data = malloc(CHUNK);
+	ssize_t n;
+
+	if (!buf || !data)
+		exit(1);
+	for (;;) {
+		n = read(fd, buf, CHUNK + 4096);
+		if (n < 0) {
+			if (errno == EINTR || errno == ENOENT)
+				continue;
+			break;
+		}
+		if (n < (ssize_t)sizeof(struct fuse_in_header))
+			continue;
+		handle(fd, (struct fuse_in_header *)buf,
+		       buf + sizeof(struct fuse_in_header), data);
+	}
+	exit(0);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void drop_caches(int fd)
+{
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	posix_fadvise(backing_fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+static int run_test(const char *name, const char *expect)
+{
+	char path[64], *buf;
+	double t0, wr, rd, rnd;
+	size_t off;
+	int fd, i;
+
+	snprintf(path, sizeof(path), "%s/" FILE_NAME, mnt);
+	fd = open(path, O_RDWR);
+	if (fd < 0) {
+		perror(path);
+		return 1;
+	}
+	if (st->use_passthrough && !st->passthrough) {
+		printf("kernel did not offer FUSE_PASSTHROUGH, skipping\n");
+		close(fd);
+		return -1;
+	}
+	buf = malloc(CHUNK);
+	if (!buf) {
+		close(fd);
+		return 1;
+	}
+
+	t0 = now();
+	for (off = 0; off < file_len; off += CHUNK)
+		if (pwrite(fd, expect + off, CHUNK, off) != CHUNK) {
+			perror("write");
+			goto fail;
+		}
+	if (fsync(fd)) {
+		perror("fsync");
+		goto fail;
+	}
+	wr = now() - t0;
+
+	drop_caches(fd);
+	t0 = now();
+	for (off = 0; off < file_len; off += CHUNK)
+		if (pread(fd, buf, CHUNK, off) != CHUNK ||
+		    memcmp(buf, expect + off, CHUNK)) {
+			printf("FAIL: sequential read at %zu\n", off);
+			goto fail;
+		}
+	rd = now() - t0;
+
+	drop_caches(fd);
+	t0 = now();
+	for (i = 0; i < RAND_COUNT; i++) {
+		off = (size_t)(rand() % (file_len / RAND_LEN)) * RAND_LEN;
+		if (pread(fd, buf, RAND_LEN, off) != RAND_LEN ||
+		    memcmp(buf, expect + off, RAND_LEN)) {
+			printf("FAIL: random read at %zu\n", off);
+			goto fail;
+		}
+	}
+	rnd = now() - t0;
+
+	close(fd);
+	free(buf);
+
+	printf("%-12s write %7.1f MB/s  read %7.1f MB/s  "
+	       "4k random read %7.0f IOPS  (%lu READ, %lu WRITE)\n", name,
+	       file_len / wr / 1e6, file_len / rd / 1e6, RAND_COUNT / rnd,
+	       st->reads, st->writes);
+
+	if (st->use_passthrough && (st->reads || st->writes)) {
+		printf("FAIL: passthrough I/O reached the daemon\n");
+		return 1;
+	}
+	return 0;
+fail:
+	close(fd);
+	free(buf);
+	return 1;
+}
+
+static int mount_and_run(int use_passthrough, const char *expect)
+{
+	char opts[128];
+	int fd, ret, status;
+	pid_t pid;
+
+	memset(st, 0, sizeof(*st));
+	st->use_passthrough = use_passthrough;
+	if (ftruncate(backing_fd, 0)) {
+		perror("ftruncate");
+		return 1;
+	}
+
+	fd = open("/dev/fuse", O_RDWR);
+	if (fd < 0) {
+		printf("no /dev/fuse, skipping\n");
+		return -1;
+	}
+	snprintf(opts, sizeof(opts),
+		 "fd=%d,rootmode=40000,user_id=0,group_id=0", fd);
+	if (mount("fuse_pt", mnt, "fuse", MS_NOSUID | MS_NODEV, opts)) {
+		perror("mount");
+		close(fd);
+		return 1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		umount2(mnt, MNT_DETACH);
+		close(fd);
+		return 1;
+	}
+	if (pid == 0)
+		serve(fd);
+
+	ret = run_test(use_passthrough ? "passthrough" : "daemon", expect);
+
+	umount2(mnt, MNT_DETACH);
+	close(fd);
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int mb = argc > 1 ? atoi(argv[1]) : DEFAULT_MB;
+	char *expect;
+	size_t i;
+	int ret;
+
+	if (mb < 1) {
+		fprintf(stderr, "usage: %s [MB]\n", argv[0]);
+		return 1;
+	}
+	file_len = (size_t)mb * 1024 * 1024;
+
+	st = mmap(NULL, sizeof(*st), PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	expect = malloc(file_len);
+	if (st == MAP_FAILED || !expect) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i = 0; i < file_len; i++)
+		expect[i] = (char)(i * 7 + (i >> 8) + (i >> 20));
+	srand(getpid());
+
+	backing_fd = mkstemp(backing);
+	if (backing_fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	if (!mkdtemp(mnt)) {
+		perror("mkdtemp");
+		unlink(backing);
+		return 1;
+	}
+
+	ret = mount_and_run(0, expect);
+	if (!ret)
+		ret = mount_and_run(1, expect);
+
+	rmdir(mnt);
+	close(backing_fd);
+	unlink(backing);
+
+	if (ret < 0)
+		return 0;
+	return ret;
+}
@@ -0,0 +1,355 @@
+/*
+ * FUSE writeback cache test.
+ *
+ * A minimal daemon speaking the raw /dev/fuse protocol exports a single
+ * empty file and accepts FUSE_WRITEBACK_CACHE at FUSE_INIT.  Its attribute
+ * replies are never cached and always carry what the daemon itself has
+ * seen, so right after a buffered write they still report the old size
+ * and mtime.  The test checks that
+ *  - i_size and mtime of the dirty file are not rolled back by those
+ *    replies, and the data reads back from the page cache;
+ *  - fsync() writes the data and then sends the local mtime with
+ *    FUSE_SETATTR, after the last FUSE_WRITE;
+ *  - size and mtime still agree with the daemon after close().
+ * Please run as root.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include "../../../../include/linux/fuse.h"
+
+#define FILE_NAME	"file"
+#define FILE_INO	2
+#define FILE_MAX	(1024 * 1024)
+#define WRITE_LEN	10000
+#define MAX_WRITE	65536
+#define OLD_MTIME	1000000000ULL
+
+struct daemon_state {
+	int wb_cache;
+	unsigned long seq;
+	unsigned long last_write_seq;
+	unsigned long mtime_setattr_seq;
+	unsigned long long size;
+	unsigned long long mtime;
+	unsigned int mtimensec;
+	unsigned long writes;
+	char data[FILE_MAX];
+};
+
+static struct daemon_state *st;
+static char mnt[] = "/tmp/fuse_wb.XXXXXX";
+
+static void fill_attr(struct fuse_attr *attr, unsigned long long ino)
+{
+	memset(attr, 0, sizeof(*attr));
+	attr->ino = ino;
+	attr->nlink = 1;
+	attr->blksize = 4096;
+	if (ino == FUSE_ROOT_ID) {
+		attr->mode = S_IFDIR | 0755;
+		attr->nlink = 2;
+		return;
+	}
+	attr->mode = S_IFREG | 0644;
+	attr->size = st->size;
+	attr->blocks = (st->size + 511) / 512;
+	attr->mtime = st->mtime;
+	attr->mtimensec = st->mtimensec;
+	attr->ctime = st->mtime;
+	attr->atime = st->mtime;
+}
+
+static void reply(int fd, struct fuse_in_header *in, int error,
+		  const void *arg, size_t len)
+{
+	struct fuse_out_header out;
+	struct iovec iov[2];
+
+	out.len = sizeof(out) + (error ? 0 : len);
+	out.error = error;
+	out.unique = in->unique;
+	iov[0].iov_base = &out;
+	iov[0].iov_len = sizeof(out);
+	iov[1].iov_base = (void *)arg;
+	iov[1].iov_len = error ? 0 : len;
+	if (writev(fd, iov, 2) < 0 && errno != ENOENT)
+		perror("fuse reply");
+}
+
+static void handle(int fd, struct fuse_in_header *in, void *arg)
+{
+	union {
+		struct fuse_init_out init;
+		struct fuse_entry_out entry;
+		struct fuse_attr_out attr;
+		struct fuse_open_out open;
+		struct fuse_write_out write;
+	} out;
+
+	memset(&out, 0, sizeof(out));
+	st->seq++;
+
+	switch (in->opcode) {
+	case FUSE_INIT: {
+		struct fuse_init_in *init = arg;
+
+		out.init.major = FUSE_KERNEL_VERSION;
+		out.init.minor = FUSE_KERNEL_MINOR_VERSION;
+		out.init.max_readahead = init->max_readahead;
+		out.init.flags = init->flags & (FUSE_WRITEBACK_CACHE |
+						FUSE_BIG_WRITES);
+		out.init.max_background = 16;
+		out.init.congestion_threshold = 12;
+		out.init.max_write = MAX_WRITE;
+		st->wb_cache = !!(out.init.flags & FUSE_WRITEBACK_CACHE);
+		reply(fd, in, 0, &out.init, sizeof(out.init));
+		break;
+	}
+	case FUSE_LOOKUP:
+		if (in->nodeid != FUSE_ROOT_ID || strcmp(arg, FILE_NAME)) {
+			reply(fd, in, -ENOENT, NULL, 0);
+			break;
+		}
+		out.entry.nodeid = FILE_INO;
+		fill_attr(&out.entry.attr, FILE_INO);
+		reply(fd, in, 0, &out.entry, sizeof(out.entry));
+		break;
+	case FUSE_GETATTR:
+		fill_attr(&out.attr.attr, in->nodeid);
+		reply(fd, in, 0, &out.attr, sizeof(out.attr));
+		break;
+	case FUSE_SETATTR: {
+		struct fuse_setattr_in *sa = arg;
+
+		if (sa->valid & FATTR_SIZE)
+			st->size = sa->size;
+		if (sa->valid & FATTR_MTIME) {
+			st->mtime = sa->mtime;
+			st->mtimensec = sa->mtimensec;
+			st->mtime_setattr_seq = st->seq;
+		}
+		fill_attr(&out.attr.attr, in->nodeid);
+		reply(fd, in, 0, &out.attr, sizeof(out.attr));
+		break;
+	}
+	case FUSE_OPEN:
+	case FUSE_OPENDIR:
+		out.open.passthrough_fd = -1;
+		reply(fd, in, 0, &out.open, sizeof(out.open));
+		break;
+	case FUSE_READ: {
+		struct fuse_read_in *rd = arg;
+		size_t len = 0;
+
+		if (rd->offset < st->size)
+			len = st->size - rd->offset;
+		if (len > rd->size)
+			len = rd->size;
+		reply(fd, in, 0, st->data + rd->offset, len);
+		break;
+	}
+	case FUSE_WRITE: {
+		struct fuse_write_in *wr = arg;
+
+		if (wr->offset + wr->size > FILE_MAX) {
+			reply(fd, in, -EFBIG, NULL, 0);
+			break;
+		}
+		memcpy(st->data + wr->offset, wr + 1, wr->size);
+		if (wr->offset + wr->size > st->size)
+			st->size = wr->offset + wr->size;
+		st->last_write_seq = st->seq;
+		st->writes++;
+		out.write.size = wr->size;
+		reply(fd, in, 0, &out.write, sizeof(out.write));
+		break;
+	}
+	case FUSE_RELEASE:
+	case FUSE_RELEASEDIR:
+		reply(fd, in, 0, NULL, 0);
+		break;
+	case FUSE_FORGET:
+	case FUSE_BATCH_FORGET:
+		break;
+	default:
+		reply(fd, in, -ENOSYS, NULL, 0);
+		break;
+	}
+}
+
+static void serve(int fd)
+{
+	char *buf = malloc(MAX_WRITE + 4096);
+	ssize_t n;
+
+	if (!buf)
+		exit(1);
+	for (;;) {
+		n = read(fd, buf, MAX_WRITE + 4096);
+		if (n < 0) {
+			if (errno == EINTR || errno == ENOENT)
+				continue;
+			break;
+		}
+		if (n < (ssize_t)sizeof(struct fuse_in_header))
+			continue;
+		handle(fd, (struct fuse_in_header *)buf,
+		       buf + sizeof(struct fuse_in_header));
+	}
+	exit(0);
+}
+
+static int check(int cond, const char *what)
+{
+	if (!cond)
+		printf("FAIL: %s\n", what);
+	return !cond;
+}
+
+static int run_test(void)
+{
+	char path[64], buf[WRITE_LEN], back[WRITE_LEN];
+	struct timespec before;
+	struct stat s1, s2;
+	int fd, i, err = 0;
+	unsigned long writes_before;
+
+	snprintf(path, sizeof(path), "%s/" FILE_NAME, mnt);
+	fd = open(path, O_RDWR);
+	if (fd < 0) {
+		perror(path);
+		return 1;
+	}
+	if (!st->wb_cache) {
+		printf("kernel did not offer FUSE_WRITEBACK_CACHE, skipping\n");
+		close(fd);
+		return -1;
+	}
+
+	for (i = 0; i < WRITE_LEN; i++)
+		buf[i] = (char)(i * 7 + (i >> 8));
+
+	clock_gettime(CLOCK_REALTIME, &before);
+	if (write(fd, buf, WRITE_LEN) != WRITE_LEN) {
+		perror("write");
+		close(fd);
+		return 1;
+	}
+
+	/* the daemon has not seen the data yet; its attributes are stale */
+	writes_before = st->writes;
+	if (fstat(fd, &s1)) {
+		perror("fstat");
+		close(fd);
+		return 1;
+	}
+	if (writes_before)
+		printf("note: data was written back before fstat\n");
+	err |= check(s1.st_size == WRITE_LEN,
+		     "dirty i_size rolled back by GETATTR");
+	err |= check(s1.st_mtime >= before.tv_sec &&
+		     (unsigned long long)s1.st_mtime != OLD_MTIME,
+		     "dirty mtime rolled back by GETATTR");
+
+	if (pread(fd, back, WRITE_LEN, 0) != WRITE_LEN ||
+	    memcmp(buf, back, WRITE_LEN))
+		err |= check(0, "data does not read back before flush");
+
+	if (fsync(fd)) {
+		perror("fsync");
+		close(fd);
+		return 1;
+	}
+	err |= check(st->size == WRITE_LEN && !memcmp(st->data, buf, WRITE_LEN),
+		     "daemon does not have the data after fsync");
+	err |= check(st->mtime_setattr_seq != 0,
+		     "no FUSE_SETATTR with FATTR_MTIME after fsync");
+	err |= check(st->mtime_setattr_seq > st->last_write_seq,
+		     "mtime was sent before the last FUSE_WRITE");
+	err |= check(st->mtime == (unsigned long long)s1.st_mtime &&
+		     st->mtimensec == (unsigned int)s1.st_mtim.tv_nsec,
+		     "daemon mtime differs from the local mtime");
+	close(fd);
+
+	if (stat(path, &s2)) {
+		perror("stat");
+		return 1;
+	}
+	err |= check(s2.st_size == WRITE_LEN, "size changed after close");
+	err |= check(s2.st_mtime == s1.st_mtime &&
+		     s2.st_mtim.tv_nsec == s1.st_mtim.tv_nsec,
+		     "mtime changed after close");
+
+	printf("fuse_writeback: %lu FUSE_WRITE requests, size %llu, "
+	       "mtime %llu.%09u\n", st->writes, st->size, st->mtime,
+	       st->mtimensec);
+	return err;
+}
+
+int main(void)
+{
+	char opts[128];
+	int fd, ret, status;
+	pid_t pid;
+
+	st = mmap(NULL, sizeof(*st), PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (st == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	memset(st, 0, sizeof(*st));
+	st->mtime = OLD_MTIME;
+
+	fd = open("/dev/fuse", O_RDWR);
+	if (fd < 0) {
+		printf("no /dev/fuse, skipping\n");
+		return 0;
+	}
+	if (!mkdtemp(mnt)) {
+		perror("mkdtemp");
+		return 1;
+	}
+	snprintf(opts, sizeof(opts),
+		 "fd=%d,rootmode=40000,user_id=0,group_id=0", fd);
+	if (mount("fuse_wb", mnt, "fuse", MS_NOSUID | MS_NODEV, opts)) {
+		perror("mount");
+		rmdir(mnt);
+		return 1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		umount2(mnt, MNT_DETACH);
+		rmdir(mnt);
+		return 1;
+	}
+	if (pid == 0)
+		serve(fd);
+
+	ret = run_test();
+
+	umount2(mnt, MNT_DETACH);
+	close(fd);
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	rmdir(mnt);
+
+	if (ret < 0)
+		return 0;
+	return ret;
+}
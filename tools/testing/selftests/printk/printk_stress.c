@@ -0,0 +1,177 @@
+/*
+ * printk stress and caller latency benchmark.
+ *
+ * One writer per online CPU logs lines through /dev/kmsg, which the
+ * kernel passes to printk() from the writer's own context, and records
+ * how long each write() took.  The messages are logged at KERN_WARNING so
+ * that they reach the consoles under the default console loglevel.  The
+ * run is repeated with printk.offload off and on, and for both the caller
+ * latency percentiles and the aggregate line rate are printed.
+ *
+ * The parameter is restored to its original setting on exit.  Needs root.
+ *
+ * usage: printk_stress [lines per writer]
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define KMSG		"/dev/kmsg"
+#define OFFLOAD		"/sys/module/printk/parameters/offload"
+#define DEFAULT_LINES	1000
+
+static int offload_state(void)
+{
+	FILE *f = fopen(OFFLOAD, "r");
+	int c;
+
+	if (!f)
+		return -1;
+	c = fgetc(f);
+	fclose(f);
+	if (c == 'Y' || c == '1')
+		return 1;
+	if (c == 'N' || c == '0')
+		return 0;
+	return -1;
+}
+
+static int set_offload(int on)
+{
+	FILE *f = fopen(OFFLOAD, "w");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fprintf(f, "%d", on) > 0 ? 0 : -1;
+	if (fclose(f))
+		ret = -1;
+	return ret;
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void writer(int cpu, long long *s, int n)
+{
+	char line[128];
+	cpu_set_t set;
+	int fd, i, len;
+	long long t0;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+
+	fd = open(KMSG, O_WRONLY);
+	if (fd < 0)
+		exit(1);
+
+	for (i = 0; i < n; i++) {
+		len = snprintf(line, sizeof(line),
+			       "<4>printk_stress: cpu %d line %d "
+			       "................................\n", cpu, i);
+		t0 = now_ns();
+		if (write(fd, line, len) != len)
+			exit(1);
+		s[i] = now_ns() - t0;
+	}
+	close(fd);
+	exit(0);
+}
+
+static int run(long long *s, int n, int nr_cpus, long long *wall)
+{
+	int cpu, status, ret = 0;
+	long long t0;
+	pid_t pid;
+
+	t0 = now_ns();
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			ret = -1;
+			break;
+		}
+		if (pid == 0)
+			writer(cpu, s + cpu * n, n);
+	}
+	while (wait(&status) > 0)
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			ret = -1;
+	*wall = now_ns() - t0;
+	return ret;
+}
+
+static int cmp_ns(const void *a, const void *b)
+{
+	const long long *sa = a, *sb = b;
+
+	return *sa < *sb ? -1 : *sa > *sb;
+}
+
+static void report(const char *name, long long *s, int n, long long wall)
+{
+	qsort(s, n, sizeof(*s), cmp_ns);
+	printf("%-12s p50 %6lld us  p90 %6lld us  p99 %6lld us  "
+	       "max %6lld us  %8.0f lines/s\n", name,
+	       s[n / 2] / 1000, s[n * 9 / 10] / 1000,
+	       s[n * 99 / 100] / 1000, s[n - 1] / 1000,
+	       n * 1e9 / wall);
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : DEFAULT_LINES;
+	int nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	long long *s, wall;
+	int orig, on, ret = 0;
+
+	if (n < 100) {
+		fprintf(stderr, "need at least 100 lines per writer\n");
+		return 1;
+	}
+	orig = offload_state();
+	if (orig < 0) {
+		printf("no " OFFLOAD ", skipping\n");
+		return 0;
+	}
+
+	s = mmap(NULL, (size_t)n * nr_cpus * sizeof(*s),
+		 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (s == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	for (on = 0; on <= 1 && !ret; on++) {
+		if (set_offload(on)) {
+			perror("writing " OFFLOAD);
+			ret = 1;
+			break;
+		}
+		if (run(s, n, nr_cpus, &wall)) {
+			ret = 1;
+			break;
+		}
+		report(on ? "offload=1" : "offload=0", s, n * nr_cpus, wall);
+	}
+
+	set_offload(orig);
+	return ret;
+}
@@ -0,0 +1,202 @@
+/*
+ * Wakeup latency benchmark for shallowest-idle wakeup placement.
+ *
+ * A waker sleeps for a random 5-20 ms, long enough for the other CPUs to
+ * reach their deeper idle states, and then wakes a blocked task through
+ * a pipe.  The wakee records how long it took from the write() to its
+ * read() returning.  The run is repeated with the WAKE_SHALLOW_IDLE sched
+ * feature off and on, and the latency percentiles and the number of
+ * wakeups placed on another CPU are printed for both.
+ *
+ * The feature is restored to its original setting on exit.  Needs root
+ * and debugfs mounted at /sys/kernel/debug.
+ *
+ * usage: wakeup_latency [samples]
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define FEATURES	"/sys/kernel/debug/sched_features"
+#define FEATURE		"WAKE_SHALLOW_IDLE"
+#define DEFAULT_SAMPLES	500
+
+struct sample {
+	long long ns;
+	int prev_cpu;
+	int cpu;
+};
+
+static int feature_state(void)
+{
+	char word[64];
+	FILE *f = fopen(FEATURES, "r");
+	int ret = -1;
+
+	if (!f)
+		return -1;
+	while (fscanf(f, "%63s", word) == 1) {
+		if (!strcmp(word, FEATURE))
+			ret = 1;
+		else if (!strcmp(word, "NO_" FEATURE))
+			ret = 0;
+	}
+	fclose(f);
+	return ret;
+}
+
+static int set_feature(int on)
+{
+	FILE *f = fopen(FEATURES, "w");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fprintf(f, "%s%s", on ? "" : "NO_", FEATURE) > 0 ? 0 : -1;
+	if (fclose(f))
+		ret = -1;
+	return ret;
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void wakee(int rfd, int ackfd, struct sample *s, int n)
+{
+	long long stamp;
+	int i, cpu = sched_getcpu();
+
+	for (i = 0; i < n; i++) {
+		if (read(rfd, &stamp, sizeof(stamp)) != sizeof(stamp))
+			exit(1);
+		s[i].ns = now_ns() - stamp;
+		s[i].prev_cpu = cpu;
+		s[i].cpu = cpu = sched_getcpu();
+		if (write(ackfd, &i, sizeof(i)) != sizeof(i))
+			exit(1);
+	}
+	exit(0);
+}
+
+static int run(struct sample *s, int n)
+{
+	int wake[2], ack[2], i, status;
+	long long stamp;
+	struct timespec delay;
+	pid_t pid;
+
+	if (pipe(wake) || pipe(ack)) {
+		perror("pipe");
+		return -1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0)
+		wakee(wake[0], ack[1], s, n);
+
+	for (i = 0; i < n; i++) {
+		delay.tv_sec = 0;
+		delay.tv_nsec = (5 + rand() % 16) * 1000000L;
+		nanosleep(&delay, NULL);
+
+		stamp = now_ns();
+		if (write(wake[1], &stamp, sizeof(stamp)) != sizeof(stamp) ||
+		    read(ack[0], &status, sizeof(status)) != sizeof(status)) {
+			perror("pipe io");
+			kill(pid, SIGKILL);
+			break;
+		}
+	}
+
+	waitpid(pid, &status, 0);
+	close(wake[0]);
+	close(wake[1]);
+	close(ack[0]);
+	close(ack[1]);
+	return (i == n && WIFEXITED(status) && !WEXITSTATUS(status)) ? 0 : -1;
+}
+
+static int cmp_ns(const void *a, const void *b)
+{
+	const struct sample *sa = a, *sb = b;
+
+	return sa->ns < sb->ns ? -1 : sa->ns > sb->ns;
+}
+
+static void report(const char *name, struct sample *s, int n)
+{
+	int i, migrated = 0;
+
+	for (i = 0; i < n; i++)
+		if (s[i].cpu != s[i].prev_cpu)
+			migrated++;
+
+	qsort(s, n, sizeof(*s), cmp_ns);
+	printf("%-20s p50 %6lld us  p90 %6lld us  p99 %6lld us  "
+	       "max %6lld us  migrated %d/%d\n", name,
+	       s[n / 2].ns / 1000, s[n * 9 / 10].ns / 1000,
+	       s[n * 99 / 100].ns / 1000, s[n - 1].ns / 1000, migrated, n);
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : DEFAULT_SAMPLES;
+	struct sample *s;
+	int orig, on, ret = 0;
+
+	if (n < 100) {
+		fprintf(stderr, "need at least 100 samples\n");
+		return 1;
+	}
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2) {
+		printf("single CPU, skipping\n");
+		return 0;
+	}
+	orig = feature_state();
+	if (orig < 0) {
+		printf("no " FEATURE " in " FEATURES ", skipping\n");
+		return 0;
+	}
+
+	s = mmap(NULL, n * sizeof(*s), PROT_READ | PROT_WRITE,
+		 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (s == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	srand(getpid());
+
+	for (on = 0; on <= 1 && !ret; on++) {
+		if (set_feature(on)) {
+			perror("writing " FEATURES);
+			ret = 1;
+			break;
+		}
+		if (run(s, n)) {
+			ret = 1;
+			break;
+		}
+		report(on ? FEATURE : "NO_" FEATURE, s, n);
+	}
+
+	set_feature(orig);
+	return ret;
+}
@@ -0,0 +1,216 @@
+/*
+ * ADB gadget bulk throughput test, run against dummy_hcd.
+ *
+ * The host side streams bulk OUT transfers through usbfs while the gadget
+ * side drains /dev/android_adb, then the gadget side writes a stream back
+ * that the host reads from the bulk IN endpoint.  Both directions carry a
+ * byte pattern that is checked at the receiving end, and the throughput of
+ * each is reported.
+ *
+ * usage: adb_bench /dev/bus/usb/BBB/DDD
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <linux/usbdevice_fs.h>
+#include <linux/usb/ch9.h>
+
+#define ADB_DEV		"/dev/android_adb"
+#define ADB_SUBCLASS	0x42
+#define ADB_PROTOCOL	1
+#define STREAM_LEN	16384
+#define STREAM_COUNT	2048
+#define TIMEOUT_MS	5000
+
+static unsigned char pattern(unsigned long off)
+{
+	return (unsigned char)(off * 7 + (off >> 8));
+}
+
+static void fill(unsigned char *buf, unsigned long off, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = pattern(off + i);
+}
+
+static int check(const unsigned char *buf, unsigned long off, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		if (buf[i] != pattern(off + i)) {
+			fprintf(stderr, "mismatch at %lu\n", off + i);
+			return -1;
+		}
+	return 0;
+}
+
+static int find_adb_eps(int fd, int *intf, int *ep_in, int *ep_out)
+{
+	unsigned char desc[4096];
+	ssize_t len;
+	int pos = 0, cur_intf = -1, is_adb = 0;
+
+	*ep_in = *ep_out = -1;
+	len = read(fd, desc, sizeof(desc));
+	if (len < USB_DT_DEVICE_SIZE)
+		return -1;
+
+	while (pos + 2 <= len && desc[pos] >= 2) {
+		unsigned char type = desc[pos + 1];
+
+		if (type == USB_DT_INTERFACE) {
+			cur_intf = desc[pos + 2];
+			is_adb = desc[pos + 5] == USB_CLASS_VENDOR_SPEC &&
+				 desc[pos + 6] == ADB_SUBCLASS &&
+				 desc[pos + 7] == ADB_PROTOCOL;
+		} else if (type == USB_DT_ENDPOINT && is_adb &&
+			   (desc[pos + 3] & USB_ENDPOINT_XFERTYPE_MASK) ==
+			   USB_ENDPOINT_XFER_BULK) {
+			*intf = cur_intf;
+			if (desc[pos + 2] & USB_DIR_IN)
+				*ep_in = desc[pos + 2];
+			else
+				*ep_out = desc[pos + 2];
+		}
+		pos += desc[pos];
+	}
+	return (*ep_in < 0 || *ep_out < 0) ? -1 : 0;
+}
+
+static int bulk(int fd, int ep, unsigned char *buf, int len)
+{
+	struct usbdevfs_bulktransfer xfer;
+
+	xfer.ep = ep;
+	xfer.len = len;
+	xfer.timeout = TIMEOUT_MS;
+	xfer.data = buf;
+	return ioctl(fd, USBDEVFS_BULK, &xfer);
+}
+
+static double elapsed(struct timeval *t0, struct timeval *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) + (t1->tv_usec - t0->tv_usec) / 1e6;
+}
+
+/* gadget side: drain the OUT stream, then send the IN stream */
+static int gadget_side(void)
+{
+	unsigned char buf[STREAM_LEN];
+	unsigned long off = 0, total;
+	int fd, i, n;
+
+	fd = open(ADB_DEV, O_RDWR);
+	if (fd < 0) {
+		perror(ADB_DEV);
+		return 1;
+	}
+
+	total = (unsigned long)STREAM_LEN * STREAM_COUNT;
+	while (off < total) {
+		n = read(fd, buf, sizeof(buf));
+		if (n <= 0) {
+			fprintf(stderr, "read: %s\n",
+				n ? strerror(errno) : "eof");
+			return 1;
+		}
+		if (check(buf, off, n))
+			return 1;
+		off += n;
+	}
+
+	for (i = 0, off = 0; i < STREAM_COUNT; i++, off += STREAM_LEN) {
+		fill(buf, off, STREAM_LEN);
+		if (write(fd, buf, STREAM_LEN) != STREAM_LEN) {
+			perror("write");
+			return 1;
+		}
+	}
+
+	close(fd);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned char buf[STREAM_LEN];
+	struct timeval t0, t1, t2;
+	unsigned long off;
+	int fd, intf, ep_in, ep_out, i, status, ret = 0;
+	double mb = STREAM_LEN * (double)STREAM_COUNT / 1e6;
+	pid_t pid;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s /dev/bus/usb/BBB/DDD\n", argv[0]);
+		return 1;
+	}
+
+	fd = open(argv[1], O_RDWR);
+	if (fd < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+	if (find_adb_eps(fd, &intf, &ep_in, &ep_out) < 0) {
+		fprintf(stderr, "no ADB bulk endpoints on %s\n", argv[1]);
+		return 1;
+	}
+	if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &intf) < 0) {
+		perror("USBDEVFS_CLAIMINTERFACE");
+		return 1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0)
+		exit(gadget_side());
+
+	gettimeofday(&t0, NULL);
+	for (i = 0, off = 0; i < STREAM_COUNT && !ret;
+	     i++, off += STREAM_LEN) {
+		fill(buf, off, STREAM_LEN);
+		if (bulk(fd, ep_out, buf, STREAM_LEN) != STREAM_LEN) {
+			perror("bulk out");
+			ret = 1;
+		}
+	}
+	gettimeofday(&t1, NULL);
+
+	for (i = 0, off = 0; i < STREAM_COUNT && !ret;
+	     i++, off += STREAM_LEN) {
+		if (bulk(fd, ep_in, buf, STREAM_LEN) != STREAM_LEN) {
+			perror("bulk in");
+			ret = 1;
+		} else if (check(buf, off, STREAM_LEN)) {
+			ret = 1;
+		}
+	}
+	gettimeofday(&t2, NULL);
+
+	if (ret)
+		kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	if (!WIFEXITED(status) || WEXITSTATUS(status))
+		ret = 1;
+
+	if (!ret)
+		printf("adb_bench: rx %.1f MB/s, tx %.1f MB/s\n",
+			mb / elapsed(&t0, &t1), mb / elapsed(&t1, &t2));
+
+	ioctl(fd, USBDEVFS_RELEASEINTERFACE, &intf);
+	close(fd);
+	return ret;
+}
@@ -0,0 +1,203 @@
+/*
+ * MTP gadget OUT path test, run against dummy_hcd.
+ *
+ * The host side pushes bulk transfers whose length is not a multiple of
+ * wMaxPacketSize through usbfs while the gadget side drains /dev/mtp_usb
+ * with read() calls smaller than the gadget request buffer.  Every byte
+ * must arrive in order, and every short transfer must end exactly one
+ * read() on the gadget side.  A final bulk stream reports throughput.
+ *
+ * usage: mtp_rx /dev/bus/usb/BBB/DDD
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <linux/usbdevice_fs.h>
+#include <linux/usb/ch9.h>
+
+#define MTP_DEV		"/dev/mtp_usb"
+#define READ_CHUNK	300
+#define SHORT_LEN	1000
+#define SHORT_COUNT	64
+#define STREAM_LEN	16384
+#define STREAM_COUNT	1024
+#define TIMEOUT_MS	5000
+
+static unsigned char pattern(unsigned long off)
+{
+	return (unsigned char)(off * 7 + (off >> 8));
+}
+
+static int find_bulk_out(int fd, int *intf, int *ep)
+{
+	unsigned char desc[4096];
+	ssize_t len;
+	int pos = 0, cur_intf = -1, cur_class = -1;
+
+	len = read(fd, desc, sizeof(desc));
+	if (len < USB_DT_DEVICE_SIZE)
+		return -1;
+
+	while (pos + 2 <= len && desc[pos] >= 2) {
+		unsigned char type = desc[pos + 1];
+
+		if (type == USB_DT_INTERFACE) {
+			cur_intf = desc[pos + 2];
+			cur_class = desc[pos + 5];
+		} else if (type == USB_DT_ENDPOINT &&
+			   cur_class == USB_CLASS_VENDOR_SPEC &&
+			   (desc[pos + 3] & USB_ENDPOINT_XFERTYPE_MASK) ==
+			   USB_ENDPOINT_XFER_BULK &&
+			   !(desc[pos + 2] & USB_DIR_IN)) {
+			*intf = cur_intf;
+			*ep = desc[pos + 2];
+			return 0;
+		}
+		pos += desc[pos];
+	}
+	return -1;
+}
+
+static int bulk_out(int fd, int ep, unsigned char *buf, int len)
+{
+	struct usbdevfs_bulktransfer bulk;
+
+	bulk.ep = ep;
+	bulk.len = len;
+	bulk.timeout = TIMEOUT_MS;
+	bulk.data = buf;
+	return ioctl(fd, USBDEVFS_BULK, &bulk);
+}
+
+/* gadget side: returns 0 when every short transfer ended one read() */
+static int gadget_reader(void)
+{
+	unsigned char buf[STREAM_LEN];
+	unsigned long off = 0, total;
+	int fd, i, j, n, got;
+
+	fd = open(MTP_DEV, O_RDWR);
+	if (fd < 0) {
+		perror(MTP_DEV);
+		return 1;
+	}
+
+	for (i = 0; i < SHORT_COUNT; i++) {
+		got = 0;
+		while (got < SHORT_LEN) {
+			n = read(fd, buf, READ_CHUNK);
+			if (n <= 0) {
+				fprintf(stderr, "read %d: %s\n", i,
+					n ? strerror(errno) : "eof");
+				return 1;
+			}
+			for (j = 0; j < n; j++)
+				if (buf[j] != pattern(off + j)) {
+					fprintf(stderr, "mismatch at %lu\n",
+						off + j);
+					return 1;
+				}
+			off += n;
+			got += n;
+		}
+		if (got != SHORT_LEN) {
+			fprintf(stderr, "transfer %d: read %d of %d bytes\n",
+				i, got, SHORT_LEN);
+			return 1;
+		}
+	}
+
+	total = (unsigned long)STREAM_LEN * STREAM_COUNT;
+	while (total) {
+		n = read(fd, buf, sizeof(buf));
+		if (n <= 0) {
+			perror("stream read");
+			return 1;
+		}
+		total -= n;
+	}
+
+	close(fd);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned char buf[STREAM_LEN];
+	struct timeval t0, t1;
+	unsigned long off = 0;
+	int fd, intf, ep, i, j, status, ret = 0;
+	pid_t pid;
+	double secs;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s /dev/bus/usb/BBB/DDD\n", argv[0]);
+		return 1;
+	}
+
+	fd = open(argv[1], O_RDWR);
+	if (fd < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+	if (find_bulk_out(fd, &intf, &ep) < 0) {
+		fprintf(stderr, "no MTP bulk OUT endpoint on %s\n", argv[1]);
+		return 1;
+	}
+	if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &intf) < 0) {
+		perror("USBDEVFS_CLAIMINTERFACE");
+		return 1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0)
+		exit(gadget_reader());
+
+	for (i = 0; i < SHORT_COUNT && !ret; i++) {
+		for (j = 0; j < SHORT_LEN; j++)
+			buf[j] = pattern(off + j);
+		if (bulk_out(fd, ep, buf, SHORT_LEN) != SHORT_LEN) {
+			perror("short bulk");
+			ret = 1;
+		}
+		off += SHORT_LEN;
+	}
+
+	gettimeofday(&t0, NULL);
+	for (i = 0; i < STREAM_COUNT && !ret; i++)
+		if (bulk_out(fd, ep, buf, STREAM_LEN) != STREAM_LEN) {
+			perror("stream bulk");
+			ret = 1;
+		}
+	gettimeofday(&t1, NULL);
+
+	if (ret)
+		kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+	if (!WIFEXITED(status) || WEXITSTATUS(status))
+		ret = 1;
+
+	if (!ret) {
+		secs = (t1.tv_sec - t0.tv_sec) +
+			(t1.tv_usec - t0.tv_usec) / 1e6;
+		printf("mtp_rx: %d short transfers ok, %.1f MB/s\n",
+			SHORT_COUNT,
+			STREAM_LEN * (double)STREAM_COUNT / secs / 1e6);
+	}
+
+	ioctl(fd, USBDEVFS_RELEASEINTERFACE, &intf);
+	close(fd);
+	return ret;
+}
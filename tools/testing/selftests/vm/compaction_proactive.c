@@ -0,0 +1,229 @@
+/*
+ * Proactive compaction test.
+ *
+ * Fragments free memory by populating anonymous memory until no free
+ * block of order >= ORDER is left and then dropping every other page.
+ * It then turns on vm.compaction_proactive_threshold and checks that
+ * kcompactd runs by itself and recovers order >= ORDER free blocks.
+ * The vm.compaction_proactive_* settings are restored on exit.  Please
+ * run as root.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define ORDER		4
+#define THRESHOLD	1
+#define INTERVAL_MS	100
+#define WAIT_SEC	10
+#define CHUNK		(4UL*1024*1024)
+#define MAX_CHUNKS	1024
+
+#define SYSCTL_DIR	"/proc/sys/vm/"
+
+static const char *tunables[] = {
+	"compaction_proactive_threshold",
+	"compaction_proactive_order",
+	"compaction_proactive_interval_ms",
+};
+static long saved[3];
+
+static int read_long(const char *path, long *val)
+{
+	FILE *f = fopen(path, "r");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fscanf(f, "%ld", val) == 1 ? 0 : -1;
+	fclose(f);
+	return ret;
+}
+
+static int write_long(const char *path, long val)
+{
+	FILE *f = fopen(path, "w");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fprintf(f, "%ld\n", val) > 0 ? 0 : -1;
+	if (fclose(f))
+		ret = -1;
+	return ret;
+}
+
+static int tunable(int i, long *val, int write)
+{
+	char path[128];
+
+	snprintf(path, sizeof(path), SYSCTL_DIR "%s", tunables[i]);
+	return write ? write_long(path, *val) : read_long(path, val);
+}
+
+static unsigned long vmstat(const char *name)
+{
+	char key[64];
+	unsigned long val, ret = 0;
+	FILE *f = fopen("/proc/vmstat", "r");
+
+	if (!f)
+		return 0;
+	while (fscanf(f, "%63s %lu", key, &val) == 2)
+		if (!strcmp(key, name))
+			ret = val;
+	fclose(f);
+	return ret;
+}
+
+/* free pages held in blocks of at least ORDER, summed over all zones */
+static unsigned long high_order_free_pages(void)
+{
+	char line[512];
+	unsigned long total = 0;
+	FILE *f = fopen("/proc/buddyinfo", "r");
+
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		char *p = strstr(line, "zone");
+		unsigned long nr;
+		int order = 0, n;
+
+		if (!p)
+			continue;
+		p += 4;
+		while (*p == ' ')
+			p++;
+		while (*p && *p != ' ')
+			p++;
+		while (sscanf(p, "%lu%n", &nr, &n) == 1) {
+			if (order >= ORDER)
+				total += nr << order;
+			order++;
+			p += n;
+		}
+	}
+	fclose(f);
+	return total;
+}
+
+static unsigned long meminfo_bytes(const char *name)
+{
+	char line[128], key[64];
+	unsigned long val, ret = 0;
+	FILE *f = fopen("/proc/meminfo", "r");
+
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f))
+		if (sscanf(line, "%63s %lu", key, &val) == 2 &&
+		    !strcmp(key, name))
+			ret = val * 1024;
+	fclose(f);
+	return ret;
+}
+
+static void restore(void)
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+		tunable(i, &saved[i], 1);
+}
+
+static char *chunks[MAX_CHUNKS];
+static int nr_chunks;
+
+/* populate memory until no block of order >= ORDER is left free */
+static int fragment(unsigned long page)
+{
+	unsigned long floor = meminfo_bytes("MemTotal:") / 20;
+	unsigned long off;
+	int i;
+
+	while (nr_chunks < MAX_CHUNKS && high_order_free_pages() &&
+	       meminfo_bytes("MemFree:") > floor + CHUNK) {
+		char *addr = mmap(NULL, CHUNK, PROT_READ | PROT_WRITE,
+				  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (addr == MAP_FAILED)
+			break;
+		memset(addr, 0x5a, CHUNK);
+		chunks[nr_chunks++] = addr;
+	}
+
+	for (i = 0; i < nr_chunks; i++)
+		for (off = page; off < CHUNK; off += 2 * page)
+			madvise(chunks[i] + off, page, MADV_DONTNEED);
+
+	return high_order_free_pages() ? -1 : 0;
+}
+
+int main(void)
+{
+	unsigned long page = sysconf(_SC_PAGESIZE);
+	unsigned long before, after, wake, success;
+	long val;
+	int i, ret = 1;
+
+	for (i = 0; i < 3; i++)
+		if (tunable(i, &saved[i], 0)) {
+			printf("no %s, skipping\n", tunables[i]);
+			return 0;
+		}
+
+	if (fragment(page)) {
+		printf("could not use up all order >= %d blocks, skipping\n",
+		       ORDER);
+		ret = 0;
+		goto out;
+	}
+
+	before = high_order_free_pages();
+	wake = vmstat("compact_daemon_wake");
+	success = vmstat("compact_daemon_success");
+	printf("fragmented %d MB, %lu pages free in order >= %d blocks\n",
+	       nr_chunks * (int)(CHUNK >> 20), before, ORDER);
+
+	val = ORDER;
+	if (tunable(1, &val, 1))
+		goto fail_set;
+	val = INTERVAL_MS;
+	if (tunable(2, &val, 1))
+		goto fail_set;
+	val = THRESHOLD;
+	if (tunable(0, &val, 1))
+		goto fail_set;
+
+	for (i = 0; i < WAIT_SEC; i++) {
+		sleep(1);
+		if (vmstat("compact_daemon_success") > success)
+			break;
+	}
+
+	after = high_order_free_pages();
+	printf("kcompactd: %lu wakeups, %lu successes; %lu pages free in "
+	       "order >= %d blocks\n",
+	       vmstat("compact_daemon_wake") - wake,
+	       vmstat("compact_daemon_success") - success, after, ORDER);
+
+	if (vmstat("compact_daemon_wake") == wake)
+		printf("kcompactd did not run proactively\n");
+	else if (after <= before)
+		printf("no high order blocks were recovered\n");
+	else
+		ret = 0;
+	goto out;
+
+fail_set:
+	perror("setting vm.compaction_proactive_*");
+out:
+	restore();
+	for (i = 0; i < nr_chunks; i++)
+		munmap(chunks[i], CHUNK);
+	return ret;
+}